@@ -0,0 +1,110 @@
+#include "CCBot.h"
+#include "Timer.hpp"
+#include "SyntheticMaps.h"
+#include <iomanip>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+    #pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+    #include <unistd.h>
+#endif
+
+using namespace CC;
+
+namespace
+{
+    struct MapSpec
+    {
+        SyntheticMaps::Kind kind;
+        int                 width;
+        int                 height;
+    };
+
+    // sizes span the ladder map pool up to the largest map the game allows
+    const MapSpec Corpus[] =
+    {
+        { SyntheticMaps::Open,      152, 136 },
+        { SyntheticMaps::Open,      200, 176 },
+        { SyntheticMaps::Maze,      192, 192 },
+        { SyntheticMaps::Maze,      256, 256 },
+        { SyntheticMaps::Islands,   224, 224 },
+        { SyntheticMaps::ManyBases, 176, 176 },
+        { SyntheticMaps::ManyBases, 256, 256 },
+    };
+
+    // the resident memory of the process, the difference between two stages is what the stage kept allocated
+    long long GetResidentBytes()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return (long long)counters.WorkingSetSize;
+        }
+        return 0;
+#elif defined(__linux__)
+        long long pages = 0;
+        long long resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        if (statm >> pages >> resident)
+        {
+            return resident * (long long)sysconf(_SC_PAGESIZE);
+        }
+        return 0;
+#else
+        return 0;
+#endif
+    }
+}
+
+// Runs the game start map analysis on every map of the synthetic corpus and prints the time and
+// memory of each stage as csv, so changes to the map stack can be compared between builds.
+// usage: MapBenchmark [seed] [repetitions]
+int main(int argc, char * argv[])
+{
+    const unsigned seed = argc > 1 ? (unsigned)std::stoul(argv[1]) : 1;
+    const int repetitions = argc > 2 ? std::max(1, std::stoi(argv[2])) : 1;
+
+    std::cout << "map,width,height,run,stage,ms,kb\n";
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (const MapSpec & spec : Corpus)
+    {
+        StandInObservation observation;
+        SyntheticMaps::Generate(spec.kind, spec.width, spec.height, seed, observation);
+
+        for (int run(0); run < repetitions; ++run)
+        {
+            CCBot bot;
+            bot.Config().UseMapCache = false;
+
+            Timer stageTimer;
+            Timer totalTimer;
+            long long stageStartBytes = GetResidentBytes();
+            const long long startBytes = stageStartBytes;
+
+            auto report = [&](const std::string & stage, double ms, long long bytes)
+            {
+                std::cout << SyntheticMaps::GetKindName(spec.kind) << "," << spec.width << "," << spec.height << ","
+                          << run << "," << stage << "," << ms << "," << (bytes / 1024) << "\n";
+            };
+
+            bot.SetStartupStageCallback([&](const std::string & stage)
+            {
+                const long long bytes = GetResidentBytes();
+                report(stage, stageTimer.getElapsedTimeInMilliSec(), bytes - stageStartBytes);
+                stageStartBytes = bytes;
+                stageTimer.start();
+            });
+
+            stageTimer.start();
+            totalTimer.start();
+            bot.OnStandInGameStart(observation);
+            report("total", totalTimer.getElapsedTimeInMilliSec(), GetResidentBytes() - startBytes);
+        }
+    }
+
+    return 0;
+}
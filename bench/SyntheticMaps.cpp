@@ -0,0 +1,318 @@
+#include "SyntheticMaps.h"
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+using namespace CC;
+
+namespace
+{
+    const int Border          = 4;      // unwalkable tiles around the edge of every map
+    const int BaseClearRadius = 10;     // tiles cleared around a base for its depot and resources
+    const int MazeCellSize    = 16;     // maze cells are corridors of this size minus the walls
+    const int MazeWall        = 2;
+    const int IslandSpacing   = 56;
+    const int BaseSpacing     = 28;     // distance between bases on a map covered in bases
+
+    struct Site
+    {
+        int x;
+        int y;
+    };
+
+    void FillRect(StandInObservation & observation, int x0, int y0, int x1, int y1, bool walkable, bool buildable)
+    {
+        for (int x = std::max(x0, 0); x < std::min(x1, observation.gameInfo.width); ++x)
+        {
+            for (int y = std::max(y0, 0); y < std::min(y1, observation.gameInfo.height); ++y)
+            {
+                observation.setWalkable(x, y, walkable);
+                observation.setBuildable(x, y, buildable);
+            }
+        }
+    }
+
+    void FillDisc(StandInObservation & observation, int cx, int cy, int radius, bool walkable, bool buildable)
+    {
+        for (int x = std::max(cx - radius, 0); x <= std::min(cx + radius, observation.gameInfo.width - 1); ++x)
+        {
+            for (int y = std::max(cy - radius, 0); y <= std::min(cy + radius, observation.gameInfo.height - 1); ++y)
+            {
+                if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= radius * radius)
+                {
+                    observation.setWalkable(x, y, walkable);
+                    observation.setBuildable(x, y, buildable);
+                }
+            }
+        }
+    }
+
+    void FillHeight(StandInObservation & observation, int x0, int y0, int x1, int y1, float height)
+    {
+        for (int x = std::max(x0, 0); x < std::min(x1, observation.gameInfo.width); ++x)
+        {
+            for (int y = std::max(y0, 0); y < std::min(y1, observation.gameInfo.height); ++y)
+            {
+                observation.setTerrainHeight(x, y, height);
+            }
+        }
+    }
+
+    // a depot spot with eight mineral fields in an arc facing away from the middle of the map and a geyser at each end
+    void AddBase(StandInObservation & observation, const Site & site)
+    {
+        FillDisc(observation, site.x, site.y, BaseClearRadius, true, true);
+
+        const float cx = site.x + 0.5f;
+        const float cy = site.y + 0.5f;
+        const float dx = cx - observation.gameInfo.width / 2.0f;
+        const float dy = cy - observation.gameInfo.height / 2.0f;
+        const float angle = (dx == 0 && dy == 0) ? 0.0f : std::atan2(dy, dx);
+
+        // mineral fields are two tiles wide, so they sit on whole x and half y positions
+        for (int i(0); i < 8; ++i)
+        {
+            const float a = angle + (i - 3.5f) * 0.3f;
+            const CCPosition pos(std::floor(cx + 7.0f * std::cos(a)), std::floor(cy + 7.0f * std::sin(a)) + 0.5f);
+            observation.addUnit(sc2::UNIT_TYPEID::NEUTRAL_MINERALFIELD, pos, sc2::Unit::Alliance::Neutral);
+        }
+
+        for (int side : { -1, 1 })
+        {
+            const float a = angle + side * 1.6f;
+            const CCPosition pos(std::floor(cx + 7.0f * std::cos(a)) + 0.5f, std::floor(cy + 7.0f * std::sin(a)) + 0.5f);
+            observation.addUnit(sc2::UNIT_TYPEID::NEUTRAL_VESPENEGEYSER, pos, sc2::Unit::Alliance::Neutral);
+        }
+    }
+
+    // places every base, we start at the first one and the enemy at the one furthest away from it
+    void AddBases(StandInObservation & observation, const std::vector<Site> & sites)
+    {
+        BOT_ASSERT(sites.size() >= 2, "A synthetic map needs at least two bases");
+
+        for (auto & site : sites)
+        {
+            AddBase(observation, site);
+        }
+
+        const Site & self = sites.front();
+        const Site * enemy = &sites.back();
+        for (auto & site : sites)
+        {
+            const int distance = (site.x - self.x) * (site.x - self.x) + (site.y - self.y) * (site.y - self.y);
+            if (distance > (enemy->x - self.x) * (enemy->x - self.x) + (enemy->y - self.y) * (enemy->y - self.y))
+            {
+                enemy = &site;
+            }
+        }
+
+        observation.startLocation = CCPosition(self.x + 0.5f, self.y + 0.5f);
+        observation.gameInfo.enemy_start_locations = { CCPosition(enemy->x + 0.5f, enemy->y + 0.5f) };
+        observation.addUnit(sc2::UNIT_TYPEID::PROTOSS_NEXUS, observation.startLocation, sc2::Unit::Alliance::Self);
+    }
+
+    bool IsNearSite(const std::vector<Site> & sites, int x, int y, int distance)
+    {
+        for (auto & site : sites)
+        {
+            if ((site.x - x) * (site.x - x) + (site.y - y) * (site.y - y) < distance * distance)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // three plateaus split by cliffs with a few ramps through them, scattered rocks and bases around the edge
+    void GenerateOpen(StandInObservation & observation, int width, int height, std::mt19937 & rng)
+    {
+        FillRect(observation, Border, Border, width - Border, height - Border, true, true);
+
+        std::vector<Site> sites;
+        const int rx = width / 2 - Border - BaseClearRadius - 2;
+        const int ry = height / 2 - Border - BaseClearRadius - 2;
+        for (int i(0); i < 8; ++i)
+        {
+            const float a = 3.14159265f * (0.25f + i / 4.0f);
+            sites.push_back({ width / 2 + (int)(rx * std::cos(a)), height / 2 + (int)(ry * std::sin(a)) });
+        }
+        sites.push_back({ width / 2, height / 2 });
+
+        // the outer thirds are high ground, reached through ramps that can be walked on but not built on
+        FillHeight(observation, 0, 0, width / 3, height, 4.0f);
+        FillHeight(observation, 2 * width / 3, 0, width, height, 4.0f);
+        std::uniform_int_distribution<int> rampY(Border + 8, height - Border - 16);
+        for (int cliffX : { width / 3, 2 * width / 3 })
+        {
+            FillRect(observation, cliffX - 1, Border, cliffX + 1, height - Border, false, false);
+            for (int r(0); r < 3; ++r)
+            {
+                const int y = rampY(rng);
+                FillRect(observation, cliffX - 2, y, cliffX + 2, y + 6, true, false);
+            }
+        }
+
+        std::uniform_int_distribution<int> rockX(Border, width - Border - 1);
+        std::uniform_int_distribution<int> rockY(Border, height - Border - 1);
+        std::uniform_int_distribution<int> rockRadius(2, 5);
+        for (int placed(0), tries(0); placed < width * height / 2048 && tries < 1000; ++tries)
+        {
+            const int x = rockX(rng);
+            const int y = rockY(rng);
+            const int radius = rockRadius(rng);
+            if (IsNearSite(sites, x, y, BaseClearRadius + radius + 2)) { continue; }
+
+            FillDisc(observation, x, y, radius, false, false);
+            placed++;
+        }
+
+        AddBases(observation, sites);
+    }
+
+    // corridors carved by a depth first walk over a grid of cells, with a base room in every third cell
+    void GenerateMaze(StandInObservation & observation, int width, int height, std::mt19937 & rng)
+    {
+        const int cellsX = (width - 2 * Border) / MazeCellSize;
+        const int cellsY = (height - 2 * Border) / MazeCellSize;
+
+        auto carveCell = [&](int cx, int cy)
+        {
+            const int x = Border + cx * MazeCellSize;
+            const int y = Border + cy * MazeCellSize;
+            FillRect(observation, x + MazeWall, y + MazeWall, x + MazeCellSize - MazeWall, y + MazeCellSize - MazeWall, true, true);
+        };
+
+        std::vector<bool> visited(cellsX * cellsY, false);
+        std::vector<std::pair<int, int>> stack = { std::make_pair(0, 0) };
+        visited[0] = true;
+        carveCell(0, 0);
+
+        while (!stack.empty())
+        {
+            const int cx = stack.back().first;
+            const int cy = stack.back().second;
+
+            std::vector<std::pair<int, int>> neighbors;
+            const int dirs[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+            for (auto & d : dirs)
+            {
+                const int nx = cx + d[0];
+                const int ny = cy + d[1];
+                if (nx >= 0 && ny >= 0 && nx < cellsX && ny < cellsY && !visited[ny * cellsX + nx])
+                {
+                    neighbors.push_back(std::make_pair(nx, ny));
+                }
+            }
+
+            if (neighbors.empty())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            auto next = neighbors[std::uniform_int_distribution<size_t>(0, neighbors.size() - 1)(rng)];
+            visited[next.second * cellsX + next.first] = true;
+            carveCell(next.first, next.second);
+
+            // knock out the wall between the two cells
+            const int x0 = Border + std::min(cx, next.first) * MazeCellSize + MazeWall;
+            const int y0 = Border + std::min(cy, next.second) * MazeCellSize + MazeWall;
+            const int x1 = Border + (std::max(cx, next.first) + 1) * MazeCellSize - MazeWall;
+            const int y1 = Border + (std::max(cy, next.second) + 1) * MazeCellSize - MazeWall;
+            FillRect(observation, x0, y0, x1, y1, true, true);
+
+            stack.push_back(next);
+        }
+
+        std::vector<Site> sites;
+        for (int cy(1); cy < cellsY; cy += 3)
+        {
+            for (int cx(1); cx < cellsX; cx += 3)
+            {
+                sites.push_back({ Border + cx * MazeCellSize + MazeCellSize / 2, Border + cy * MazeCellSize + MazeCellSize / 2 });
+            }
+        }
+
+        AddBases(observation, sites);
+    }
+
+    // round islands with a base each, only every other row of islands is joined by bridges
+    void GenerateIslands(StandInObservation & observation, int width, int height, std::mt19937 & rng)
+    {
+        std::uniform_int_distribution<int> islandRadius(BaseClearRadius + 6, BaseClearRadius + 12);
+        std::uniform_int_distribution<int> jitter(-4, 4);
+        std::uniform_int_distribution<int> islandHeight(0, 4);
+
+        std::vector<Site> sites;
+        int row = 0;
+        for (int y = Border + IslandSpacing / 2; y + IslandSpacing / 2 <= height - Border; y += IslandSpacing, ++row)
+        {
+            bool first = true;
+            for (int x = Border + IslandSpacing / 2; x + IslandSpacing / 2 <= width - Border; x += IslandSpacing)
+            {
+                const Site site = { x + jitter(rng), y + jitter(rng) };
+                const int radius = islandRadius(rng);
+
+                FillDisc(observation, site.x, site.y, radius, true, true);
+                FillHeight(observation, site.x - radius, site.y - radius, site.x + radius + 1, site.y + radius + 1, (float)islandHeight(rng));
+
+                if (row % 2 == 0 && !first)
+                {
+                    const Site & previous = sites.back();
+                    FillRect(observation, previous.x, std::min(previous.y, site.y), site.x, std::min(previous.y, site.y) + 4, true, false);
+                }
+
+                sites.push_back(site);
+                first = false;
+            }
+        }
+
+        AddBases(observation, sites);
+    }
+
+    // open ground with a base every few tiles in both directions
+    void GenerateManyBases(StandInObservation & observation, int width, int height, std::mt19937 & rng)
+    {
+        FillRect(observation, Border, Border, width - Border, height - Border, true, true);
+
+        std::vector<Site> sites;
+        const int margin = Border + BaseClearRadius + 2;
+        for (int y = margin; y <= height - margin; y += BaseSpacing)
+        {
+            for (int x = margin; x <= width - margin; x += BaseSpacing)
+            {
+                sites.push_back({ x, y });
+            }
+        }
+
+        std::shuffle(sites.begin() + 1, sites.end(), rng);
+        AddBases(observation, sites);
+    }
+}
+
+const char * SyntheticMaps::GetKindName(Kind kind)
+{
+    switch (kind)
+    {
+        case Open:      return "Open";
+        case Maze:      return "Maze";
+        case Islands:   return "Islands";
+        case ManyBases: return "ManyBases";
+        default:        return "Unknown";
+    }
+}
+
+void SyntheticMaps::Generate(Kind kind, int width, int height, unsigned seed, StandInObservation & observation)
+{
+    std::mt19937 rng(seed);
+    observation.reset(width, height);
+
+    switch (kind)
+    {
+        case Open:      GenerateOpen(observation, width, height, rng); break;
+        case Maze:      GenerateMaze(observation, width, height, rng); break;
+        case Islands:   GenerateIslands(observation, width, height, rng); break;
+        case ManyBases: GenerateManyBases(observation, width, height, rng); break;
+    }
+}
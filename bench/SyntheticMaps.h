@@ -0,0 +1,17 @@
+#pragma once
+
+#include "StandInObservation.h"
+
+namespace CC
+{
+    // Generates walkable / buildable grids with resource clusters that look enough like ladder maps
+    // to exercise the map analysis: open ground with rocks and ramps, mazes of corridors, islands
+    // that are not connected by ground, and maps covered in bases.
+    namespace SyntheticMaps
+    {
+        enum Kind { Open, Maze, Islands, ManyBases };
+
+        const char * GetKindName(Kind kind);
+        void Generate(Kind kind, int width, int height, unsigned seed, StandInObservation & observation);
+    }
+}
@@ -1179,7 +1179,7 @@ bool BOSSManager::fixBuildOrderRecurse(const BOSS::GameState & state, BOSS::Buil
 
 void BOSSManager::printDebugInfo() const
 {
-    if (!m_bot.Config().DrawBOSSInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::BOSSInfo))
     {
         return;
     }
@@ -0,0 +1,255 @@
+#include "BaseLayout.h"
+#include "CCBot.h"
+#include "Util.h"
+
+#include <algorithm>
+
+using namespace CC;
+
+const int MaxBlocksPerBase   = 6;       // blocks planned around a single base
+const int MaxLayoutDistance  = 20;      // ground distance in tiles from the base a block may start at
+
+BaseLayout::BaseLayout(CCBot & bot)
+    : m_bot(bot)
+    , m_columns(0)
+    , m_addonWidth(0)
+{
+    for (int size = 0; size < NumSlotSizes; ++size)
+    {
+        m_slotWidth[size] = 0;
+        m_slotHeight[size] = 0;
+    }
+}
+
+void BaseLayout::onStart(const SummedAreaTable & unbuildable, const SummedAreaTable & blocked)
+{
+    for (int size = 0; size < NumSlotSizes; ++size)
+    {
+        m_slots[size].clear();
+    }
+
+    const CCRace race = m_bot.GetPlayerRace(Players::Self);
+    if (Util::IsZerg(race))
+    {
+        return;
+    }
+
+    const UnitType supplyProvider = Util::GetSupplyProvider(race, m_bot);
+    m_slotWidth[Small]  = supplyProvider.tileWidth();
+    m_slotHeight[Small] = supplyProvider.tileHeight();
+#ifdef SC2API
+    m_slotWidth[Large]  = 3;
+    m_slotHeight[Large] = 3;
+#else
+    m_slotWidth[Large]  = 4;
+    m_slotHeight[Large] = 3;
+#endif
+    m_columns    = Util::IsTerran(race) ? 1 : 2;
+    m_addonWidth = Util::IsTerran(race) ? 2 : 0;
+
+    const int width  = m_bot.Map().width();
+    const int height = m_bot.Map().height();
+
+    m_keepClear.reset(width, height);
+    m_planned.reset(width, height);
+
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            if (blocked.get(x, y))
+            {
+                m_keepClear.set(x, y, true);
+                continue;
+            }
+
+            for (const BaseLocation * base : m_bot.Bases().getBaseLocations())
+            {
+                if (base->isInResourceBox(x, y))
+                {
+                    m_keepClear.set(x, y, true);
+                    break;
+                }
+            }
+        }
+    }
+
+    // depot locations with a tile of space around them, whichever way the depot position is anchored
+    const UnitType townHall = Util::GetTownHall(race, m_bot);
+    for (const BaseLocation * base : m_bot.Bases().getBaseLocations())
+    {
+        const CCTilePosition & depot = base->getDepotPosition();
+        for (int x = depot.x - townHall.tileWidth(); x <= depot.x + townHall.tileWidth(); ++x)
+        {
+            for (int y = depot.y - townHall.tileHeight(); y <= depot.y + townHall.tileHeight(); ++y)
+            {
+                m_keepClear.set(x, y, true);
+            }
+        }
+    }
+
+    m_keepClear.update();
+
+    // the start base is planned first so it gets the tiles the bases around it would also want
+    const BaseLocation * startBase = m_bot.Bases().getPlayerStartingBaseLocation(Players::Self);
+    if (startBase)
+    {
+        planBase(startBase, unbuildable);
+    }
+
+    for (const BaseLocation * base : m_bot.Bases().getBaseLocations())
+    {
+        if (base != startBase)
+        {
+            planBase(base, unbuildable);
+        }
+    }
+}
+
+// places blocks greedily on the tiles closest to the base by ground distance
+void BaseLayout::planBase(const BaseLocation * base, const SummedAreaTable & unbuildable)
+{
+    const int largeWidth  = m_columns * (m_slotWidth[Large] + m_addonWidth);
+    const int blockWidth  = largeWidth + m_slotWidth[Small];
+    const int blockHeight = 2 * m_slotHeight[Large];
+    const int smallSlots  = blockHeight / m_slotHeight[Small];
+
+    std::vector<CCTilePosition> & large = m_slots[Large][base];
+    std::vector<CCTilePosition> powering;
+    std::vector<CCTilePosition> supply;
+    int blocks = 0;
+
+    for (auto & tile : base->getClosestTiles())
+    {
+        if (blocks >= MaxBlocksPerBase || base->getGroundDistance(tile) > MaxLayoutDistance)
+        {
+            break;
+        }
+
+        if (!canPlaceBlock(base, tile.x, tile.y, blockWidth, blockHeight, unbuildable))
+        {
+            continue;
+        }
+
+        for (int x = tile.x; x < tile.x + blockWidth; ++x)
+        {
+            for (int y = tile.y; y < tile.y + blockHeight; ++y)
+            {
+                m_planned.set(x, y, true);
+            }
+        }
+
+        m_planned.update();
+        ++blocks;
+
+        for (int column = 0; column < m_columns; ++column)
+        {
+            for (int row = 0; row < 2; ++row)
+            {
+                large.push_back(getBuildPosition(tile.x + column * (m_slotWidth[Large] + m_addonWidth), tile.y + row * m_slotHeight[Large], Large));
+            }
+        }
+
+        // the middle supply slot of every block comes before the others, so new pylons power new blocks
+        for (int i = 0; i < smallSlots; ++i)
+        {
+            CCTilePosition slot = getBuildPosition(tile.x + largeWidth, tile.y + i * m_slotHeight[Small], Small);
+            (i == smallSlots / 2 ? powering : supply).push_back(slot);
+        }
+    }
+
+    std::vector<CCTilePosition> & small = m_slots[Small][base];
+    small = powering;
+    small.insert(small.end(), supply.begin(), supply.end());
+
+    std::reverse(small.begin(), small.end());
+    std::reverse(large.begin(), large.end());
+}
+
+bool BaseLayout::canPlaceBlock(const BaseLocation * base, int x0, int y0, int width, int height, const SummedAreaTable & unbuildable) const
+{
+    const int x1 = x0 + width;
+    const int y1 = y0 + height;
+
+    // the lane around the block has to be on the map too
+    if (x0 < 1 || y0 < 1 || x1 + 1 > m_bot.Map().width() || y1 + 1 > m_bot.Map().height())
+    {
+        return false;
+    }
+
+    if (unbuildable.any(x0, y0, x1, y1) || m_keepClear.any(x0, y0, x1, y1))
+    {
+        return false;
+    }
+
+    // lanes may touch the lanes of other blocks, but not the blocks
+    if (m_planned.any(x0 - 1, y0 - 1, x1 + 1, y1 + 1))
+    {
+        return false;
+    }
+
+    // the block belongs to this base and not to the one next to it
+    return m_bot.Bases().getBaseLocation(x0 + width / 2, y0 + height / 2) == base;
+}
+
+// the position the game expects for a footprint with the given top left tile, see BuildingPlacer::footprintIsFree
+CCTilePosition BaseLayout::getBuildPosition(int x0, int y0, SlotSize size) const
+{
+#ifdef SC2API
+    return CCTilePosition(x0 + m_slotWidth[size] / 2, y0 + m_slotHeight[size] / 2);
+#else
+    return CCTilePosition(x0, y0);
+#endif
+}
+
+bool BaseLayout::getSlotSize(const UnitType & type, SlotSize & size) const
+{
+    if (type.isRefinery() || type.isResourceDepot() || type.isAddon())
+    {
+        return false;
+    }
+
+    // small slots are for supply providers only, the middle one powers the block
+    if (type.isSupplyProvider())
+    {
+        size = Small;
+    }
+    // large slots are for production and tech buildings, defensive structures go where they defend
+    else if (!type.isStaticDefense() && !type.isBunker())
+    {
+        size = Large;
+    }
+    else
+    {
+        return false;
+    }
+
+    return type.tileWidth() == m_slotWidth[size] && type.tileHeight() == m_slotHeight[size];
+}
+
+std::vector<CCTilePosition> & BaseLayout::getSlots(const BaseLocation * base, SlotSize size)
+{
+    return m_slots[size][base];
+}
+
+void BaseLayout::draw() const
+{
+    for (int size = 0; size < NumSlotSizes; ++size)
+    {
+        for (auto & baseSlots : m_slots[size])
+        {
+            for (auto & slot : baseSlots.second)
+            {
+#ifdef SC2API
+                const int x0 = slot.x - m_slotWidth[size] / 2;
+                const int y0 = slot.y - m_slotHeight[size] / 2;
+#else
+                const int x0 = slot.x;
+                const int y0 = slot.y;
+#endif
+                m_bot.Map().drawBox(Util::TileToPosition((float)x0), Util::TileToPosition((float)y0),
+                                    Util::TileToPosition((float)(x0 + m_slotWidth[size])), Util::TileToPosition((float)(y0 + m_slotHeight[size])), CCColor(0, 255, 255));
+            }
+        }
+    }
+}
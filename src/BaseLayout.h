@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Common.h"
+#include "SummedAreaTable.h"
+#include <map>
+
+namespace CC
+{
+    class CCBot;
+    class BaseLocation;
+    class UnitType;
+
+    // Building slots planned around every base at game start. Each block holds two rows of production sized
+    // slots next to a column of supply provider slots, with the middle supply slot first so its pylon powers the
+    // whole block, room for terran add-ons, and a lane of one tile around the block so units can walk out.
+    // Zerg builds on creep and gets no layout.
+    class BaseLayout
+    {
+    public:
+
+        enum SlotSize { Small, Large, NumSlotSizes };
+
+    private:
+
+        CCBot &             m_bot;
+
+        int                 m_slotWidth[NumSlotSizes];
+        int                 m_slotHeight[NumSlotSizes];
+        int                 m_columns;          // columns of large slots in a block
+        int                 m_addonWidth;       // tiles kept free right of each large slot
+
+        // build positions of the slots not known to be built on, nearest to the base last so they pop first
+        std::map<const BaseLocation *, std::vector<CCTilePosition>> m_slots[NumSlotSizes];
+
+        SummedAreaTable     m_keepClear;        // mineral lines and depot locations of every base, rocks and other structures
+        SummedAreaTable     m_planned;          // tiles of the blocks planned so far
+
+        void    planBase(const BaseLocation * base, const SummedAreaTable & unbuildable);
+        bool    canPlaceBlock(const BaseLocation * base, int x0, int y0, int width, int height, const SummedAreaTable & unbuildable) const;
+        CCTilePosition getBuildPosition(int x0, int y0, SlotSize size) const;
+
+    public:
+
+        BaseLayout(CCBot & bot);
+
+        void    onStart(const SummedAreaTable & unbuildable, const SummedAreaTable & blocked);
+
+        // whether the type fits one of the slot sizes
+        bool    getSlotSize(const UnitType & type, SlotSize & size) const;
+
+        std::vector<CCTilePosition> & getSlots(const BaseLocation * base, SlotSize size);
+
+        void    draw() const;
+    };
+}
@@ -1,6 +1,7 @@
 #include "BaseLocation.h"
 #include "Util.h"
 #include "CCBot.h"
+#include "MapCache.h"
 #include <sstream>
 #include <iostream>
 
@@ -16,6 +17,79 @@ BaseLocation::BaseLocation(CCBot & bot, int baseID, const std::vector<Unit> & re
     , m_right                (std::numeric_limits<CCPositionType>::lowest())
     , m_top                  (std::numeric_limits<CCPositionType>::lowest())
     , m_bottom               (std::numeric_limits<CCPositionType>::max())
+{
+    addResources(resources);
+
+    // compute this BaseLocation's DistanceMap, which will compute the ground distance
+    // from the center of its recourses to every other tile on the map
+    m_distanceMap = m_bot.Map().getSharedDistanceMap(m_centerOfResources);
+
+    // check to see if this is a start location for the map
+    for (auto & pos : m_bot.GetStartLocations())
+    {
+        if (containsPosition(pos))
+        {
+            m_isStartLocation = true;
+            m_depotPosition = Util::GetTilePosition(pos);
+        }
+    }
+    
+    checkPlayerStartLocation();
+    
+    // if it's not a start location, we need to calculate the depot position
+    if (!isStartLocation())
+    {
+        UnitType depot = Util::GetTownHall(m_bot.GetPlayerRace(Players::Self), m_bot);
+#ifdef SC2API
+        int offsetX = 0;
+        int offsetY = 0;
+#else
+        int offsetX = 1;
+        int offsetY = 1;
+#endif
+        
+        // the position of the depot will be the closest spot we can build one from the resource center
+        for (auto & tile : getClosestTiles())
+        {
+            // the build position will be up-left of where this tile is
+            // this means we are positioning the center of the resouce depot
+            CCTilePosition buildTile(tile.x - offsetX, tile.y - offsetY);
+
+            if (m_bot.Map().canBuildTypeAtPosition(buildTile.x, buildTile.y, depot))
+            {
+                m_depotPosition = buildTile;
+                break;
+            }
+        }
+    }
+}
+
+BaseLocation::BaseLocation(CCBot & bot, int baseID, const std::vector<Unit> & resources, const MapCache & cache)
+    : m_bot(bot)
+    , m_baseID               (baseID)
+    , m_isStartLocation      (false)
+    , m_left                 (std::numeric_limits<CCPositionType>::max())
+    , m_right                (std::numeric_limits<CCPositionType>::lowest())
+    , m_top                  (std::numeric_limits<CCPositionType>::lowest())
+    , m_bottom               (std::numeric_limits<CCPositionType>::max())
+{
+    addResources(resources);
+
+    // the distance map and depot position don't depend on the players, so they are used straight from the cache
+    const MapCache::BaseRecord & record = cache.getBaseRecord(baseID);
+    auto distanceMap = std::make_shared<DistanceMap>();
+    distanceMap->loadDistanceMap(CCTilePosition(record.startTileX, record.startTileY), cache.width(), cache.height(), 
+        cache.getDistances(record), cache.getSortedTiles(record), (size_t)record.numSortedTiles);
+    m_bot.Map().addSharedDistanceMap(distanceMap);
+    m_distanceMap = distanceMap;
+
+    m_isStartLocation = record.isStartLocation != 0;
+    m_depotPosition = CCTilePosition(record.depotX, record.depotY);
+
+    checkPlayerStartLocation();
+}
+
+void BaseLocation::addResources(const std::vector<Unit> & resources)
 {
     m_isPlayerStartLocation[0] = false;
     m_isPlayerStartLocation[1] = false;
@@ -61,21 +135,10 @@ BaseLocation::BaseLocation(CCBot & bot, int baseID, const std::vector<Unit> & re
     size_t numResources = m_minerals.size() + m_geysers.size();
 
     m_centerOfResources = CCPosition(m_left + (m_right-m_left)/2, m_top + (m_bottom-m_top)/2);
+}
 
-    // compute this BaseLocation's DistanceMap, which will compute the ground distance
-    // from the center of its recourses to every other tile on the map
-    m_distanceMap = m_bot.Map().getDistanceMap(m_centerOfResources);
-
-    // check to see if this is a start location for the map
-    for (auto & pos : m_bot.GetStartLocations())
-    {
-        if (containsPosition(pos))
-        {
-            m_isStartLocation = true;
-            m_depotPosition = Util::GetTilePosition(pos);
-        }
-    }
-    
+void BaseLocation::checkPlayerStartLocation()
+{
     // if this base location position is near our own resource depot, it's our start location
     for (auto & unit : m_bot.GetUnits())
     {
@@ -87,33 +150,6 @@ BaseLocation::BaseLocation(CCBot & bot, int baseID, const std::vector<Unit> & re
             break;
         }
     }
-    
-    // if it's not a start location, we need to calculate the depot position
-    if (!isStartLocation())
-    {
-        UnitType depot = Util::GetTownHall(m_bot.GetPlayerRace(Players::Self), m_bot);
-#ifdef SC2API
-        int offsetX = 0;
-        int offsetY = 0;
-#else
-        int offsetX = 1;
-        int offsetY = 1;
-#endif
-        
-        // the position of the depot will be the closest spot we can build one from the resource center
-        for (auto & tile : getClosestTiles())
-        {
-            // the build position will be up-left of where this tile is
-            // this means we are positioning the center of the resouce depot
-            CCTilePosition buildTile(tile.x - offsetX, tile.y - offsetY);
-
-            if (m_bot.Map().canBuildTypeAtPosition(buildTile.x, buildTile.y, depot))
-            {
-                m_depotPosition = buildTile;
-                break;
-            }
-        }
-    }
 }
 
 // TODO: calculate the actual depot position
@@ -186,14 +222,19 @@ const CCPosition & BaseLocation::getPosition() const
     return m_centerOfResources;
 }
 
+const DistanceMap & BaseLocation::getDistanceMap() const
+{
+    return *m_distanceMap;
+}
+
 int BaseLocation::getGroundDistance(const CCPosition & pos) const
 {
-    return m_distanceMap.getDistance(pos);
+    return m_distanceMap->getDistance(pos);
 }
 
 int BaseLocation::getGroundDistance(const CCTilePosition & pos) const
 {
-    return m_distanceMap.getDistance(pos);
+    return m_distanceMap->getDistance(pos);
 }
 
 bool BaseLocation::isStartLocation() const
@@ -201,9 +242,9 @@ bool BaseLocation::isStartLocation() const
     return m_isStartLocation;
 }
 
-const std::vector<CCTilePosition> & BaseLocation::getClosestTiles() const
+TileList BaseLocation::getClosestTiles() const
 {
-    return m_distanceMap.getSortedTiles();
+    return m_distanceMap->getSortedTiles();
 }
 
 void BaseLocation::draw()
@@ -9,11 +9,12 @@
 namespace CC
 {
     class CCBot;
+    class MapCache;
 
     class BaseLocation
     {
         CCBot &                     m_bot;
-        DistanceMap                 m_distanceMap;
+        std::shared_ptr<const DistanceMap> m_distanceMap;     // shared with the MapTools distance map cache
 
         CCTilePosition              m_depotPosition;
         CCPosition                  m_centerOfResources;
@@ -33,10 +34,16 @@ namespace CC
         CCPositionType              m_bottom;
         bool                        m_isStartLocation;
 
+        void addResources(const std::vector<Unit> & resources);
+        void checkPlayerStartLocation();
+
     public:
 
         BaseLocation(CCBot & bot, int baseID, const std::vector<Unit> & resources);
 
+        // restores a base location from the map cache, resources must be the units found at the cached resource positions
+        BaseLocation(CCBot & bot, int baseID, const std::vector<Unit> & resources, const MapCache & cache);
+
         int getGroundDistance(const CCPosition & pos) const;
         int getGroundDistance(const CCTilePosition & pos) const;
         bool isStartLocation() const;
@@ -45,6 +52,7 @@ namespace CC
         bool containsPosition(const CCPosition & pos) const;
         const CCTilePosition & getDepotPosition() const;
         const CCPosition & getPosition() const;
+        const DistanceMap & getDistanceMap() const;
         const std::vector<Unit> & getGeysers() const;
         const std::vector<Unit> & getMinerals() const;
         bool isOccupiedByPlayer(CCPlayer player) const;
@@ -53,7 +61,7 @@ namespace CC
 
         void setPlayerOccupying(CCPlayer player, bool occupying);
 
-        const std::vector<CCTilePosition> & getClosestTiles() const;
+        TileList getClosestTiles() const;
 
         void draw();
     };
@@ -7,6 +7,8 @@ using namespace CC;
 
 BaseLocationManager::BaseLocationManager(CCBot & bot)
     : m_bot(bot)
+    , m_territoryMap(bot)
+    , m_structureSignature(0)
 {
     
 }
@@ -17,6 +19,50 @@ void BaseLocationManager::onStart()
     m_playerStartingBaseLocations[Players::Self]  = nullptr;
     m_playerStartingBaseLocations[Players::Enemy] = nullptr; 
     
+    // the base locations and tile lookup are restored from the map cache if a previous game saved them
+    bool loadedFromCache = loadBaseLocations();
+    if (!loadedFromCache)
+    {
+        computeBaseLocations();
+    }
+
+    // construct the vectors of base location pointers, this is safe since they will never change
+    for (auto & baseLocation : m_baseLocationData)
+    {
+        m_baseLocationPtrs.push_back(&baseLocation);
+
+        // if it's a start location, add it to the start locations
+        if (baseLocation.isStartLocation())
+        {
+            m_startingBaseLocations.push_back(&baseLocation);
+        }
+
+        // if it's our starting location, set the pointer
+        if (baseLocation.isPlayerStartLocation(Players::Self))
+        {
+            m_playerStartingBaseLocations[Players::Self] = &baseLocation;
+        }
+
+        if (baseLocation.isPlayerStartLocation(Players::Enemy))
+        {
+            m_playerStartingBaseLocations[Players::Enemy] = &baseLocation;
+        }
+    }
+
+    // construct the sets of occupied base locations
+    m_occupiedBaseLocations[Players::Self] = std::set<const BaseLocation *>();
+    m_occupiedBaseLocations[Players::Enemy] = std::set<const BaseLocation *>();
+    m_territoryMap.onStart();
+
+    if (!loadedFromCache)
+    {
+        m_bot.Map().saveMapCache(*this);
+    }
+    m_bot.OnStartupStage("base locations");
+}
+
+void BaseLocationManager::computeBaseLocations()
+{
     // a BaseLocation will be anything where there are minerals to mine
     // so we will first look over all minerals and cluster them based on some distance
     const CCPositionType clusterDistance = Util::TileToPosition(12);
@@ -95,29 +141,6 @@ void BaseLocationManager::onStart()
         }
     }
 
-    // construct the vectors of base location pointers, this is safe since they will never change
-    for (auto & baseLocation : m_baseLocationData)
-    {
-        m_baseLocationPtrs.push_back(&baseLocation);
-
-        // if it's a start location, add it to the start locations
-        if (baseLocation.isStartLocation())
-        {
-            m_startingBaseLocations.push_back(&baseLocation);
-        }
-
-        // if it's our starting location, set the pointer
-        if (baseLocation.isPlayerStartLocation(Players::Self))
-        {
-            m_playerStartingBaseLocations[Players::Self] = &baseLocation;
-        }
-
-        if (baseLocation.isPlayerStartLocation(Players::Enemy))
-        {
-            m_playerStartingBaseLocations[Players::Enemy] = &baseLocation;
-        }
-    }
-
     // construct the map of tile positions to base locations
     for (int x=0; x < m_bot.Map().width(); ++x)
     {
@@ -136,10 +159,61 @@ void BaseLocationManager::onStart()
             }
         }
     }
+}
 
-    // construct the sets of occupied base locations
-    m_occupiedBaseLocations[Players::Self] = std::set<const BaseLocation *>();
-    m_occupiedBaseLocations[Players::Enemy] = std::set<const BaseLocation *>();
+bool BaseLocationManager::loadBaseLocations()
+{
+    const MapCache & cache = m_bot.Map().getMapCache();
+    if (!cache.isLoaded())
+    {
+        return false;
+    }
+
+    // resources sit on half tiles, so twice their position identifies them exactly
+    std::map<std::pair<int, int>, Unit> resources;
+    for (auto & unit : m_bot.GetUnits())
+    {
+        if (unit.getType().isMineral() || unit.getType().isGeyser())
+        {
+            resources[std::make_pair((int)(unit.getPosition().x * 2), (int)(unit.getPosition().y * 2))] = unit;
+        }
+    }
+
+    // every cached resource must still be on the map, otherwise the cache can't be trusted
+    std::vector<std::vector<Unit>> resourceClusters(cache.numBases());
+    for (size_t baseID(0); baseID < cache.numBases(); ++baseID)
+    {
+        const MapCache::BaseRecord & record = cache.getBaseRecord(baseID);
+        const float * positions = cache.getResourcePositions(record);
+
+        for (int r(0); r < record.numResources; ++r)
+        {
+            auto it = resources.find(std::make_pair((int)(positions[2*r] * 2), (int)(positions[2*r + 1] * 2)));
+            if (it == resources.end())
+            {
+                return false;
+            }
+
+            resourceClusters[baseID].push_back(it->second);
+        }
+    }
+
+    for (size_t baseID(0); baseID < resourceClusters.size(); ++baseID)
+    {
+        m_baseLocationData.push_back(BaseLocation(m_bot, (int)baseID, resourceClusters[baseID], cache));
+    }
+
+    const int32_t * tileBaseLocations = cache.tileBaseLocations();
+    for (int x=0; x < m_bot.Map().width(); ++x)
+    {
+        for (int y=0; y < m_bot.Map().height(); ++y)
+        {
+            int baseID = tileBaseLocations[y * m_bot.Map().width() + x];
+            m_tileBaseLocations[x][y] = baseID >= 0 ? &m_baseLocationData[baseID] : nullptr;
+        }
+    }
+
+    return true;
 }
 
 void BaseLocationManager::onFrame()
@@ -251,6 +325,99 @@ void BaseLocationManager::onFrame()
             m_occupiedBaseLocations[Players::Enemy].insert(&baseLocation);
         }
     }
+
+    // only the tiles around bases that were gained or lost are updated
+    m_territoryMap.update(m_occupiedBaseLocations[Players::Self], m_occupiedBaseLocations[Players::Enemy]);
+
+    updateStructureSignature();
+}
+
+// order independent hash of every structure on the map, expansion placement only has to be rechecked when it changes
+void BaseLocationManager::updateStructureSignature()
+{
+    uint64_t signature = 0;
+    uint64_t numStructures = 0;
+
+    for (auto & unit : m_bot.GetUnits())
+    {
+        // neutral units include the destructible rocks that can block an expansion
+        bool neutralObstacle = unit.getPlayer() == Players::Neutral && !unit.getType().isMineral() && !unit.getType().isGeyser();
+        if (!unit.getType().isBuilding() && !neutralObstacle)
+        {
+            continue;
+        }
+
+        uint64_t id = (uint64_t)unit.getID() * 0x9E3779B97F4A7C15ull;
+        signature ^= id ^ (id >> 29);
+        numStructures++;
+    }
+
+    m_structureSignature = signature ^ (numStructures * 0xBF58476D1CE4E5B9ull);
+}
+
+const BaseLocationManager::ExpansionRanking & BaseLocationManager::getExpansionRanking(int player) const
+{
+    ExpansionRanking & ranking = m_expansionRankings[player];
+    const BaseLocation * homeBase = getPlayerStartingBaseLocation(player);
+
+    // pathing distances never change, so the expansions are only ranked once with a single batched query
+    if (!ranking.ranked && homeBase != nullptr)
+    {
+        std::vector<const BaseLocation *> candidates;
+        std::vector<sc2::QueryInterface::PathingQuery> pathingQueries;
+        for (auto & base : getBaseLocations())
+        {
+            // skip mineral only and starting locations (TODO: fix this)
+            if (base->isMineralOnly() || base->isStartLocation())
+            {
+                continue;
+            }
+
+            sc2::QueryInterface::PathingQuery query;
+            query.start_ = homeBase->getPosition();
+            query.end_ = CCPosition((float)base->getDepotPosition().x, (float)base->getDepotPosition().y);
+            pathingQueries.push_back(query);
+            candidates.push_back(base);
+        }
+
+        std::vector<float> distances = m_bot.Query()->PathingDistance(pathingQueries);
+        std::vector<std::pair<float, const BaseLocation *>> connected;
+        for (size_t i(0); i < candidates.size() && i < distances.size(); ++i)
+        {
+            // if it is not connected, skip it
+            if (distances[i] > 0)
+            {
+                connected.push_back(std::make_pair(distances[i], candidates[i]));
+            }
+        }
+
+        std::stable_sort(connected.begin(), connected.end(), [](const std::pair<float, const BaseLocation *> & a, const std::pair<float, const BaseLocation *> & b) { return a.first < b.first; });
+
+        for (auto & c : connected)
+        {
+            ranking.bases.push_back(c.second);
+        }
+
+        ranking.ranked = true;
+        ranking.signature = m_structureSignature + 1;
+    }
+
+    // a building is already there or blocks it, only checked again once a structure appears or disappears
+    if (ranking.ranked && ranking.signature != m_structureSignature)
+    {
+        sc2::AbilityID buildAbility = m_bot.Data(Util::GetTownHall(m_bot.GetPlayerRace(Players::Self), m_bot)).buildAbility;
+        std::vector<sc2::QueryInterface::PlacementQuery> placementQueries;
+        for (auto & base : ranking.bases)
+        {
+            placementQueries.push_back(sc2::QueryInterface::PlacementQuery(buildAbility, CCPosition((float)base->getDepotPosition().x, (float)base->getDepotPosition().y)));
+        }
+
+        ranking.placeable = m_bot.Query()->Placement(placementQueries);
+        ranking.placeable.resize(ranking.bases.size(), false);
+        ranking.signature = m_structureSignature;
+    }
+
+    return ranking;
 }
 
 BaseLocation * BaseLocationManager::getBaseLocation(const CCPosition & pos) const
@@ -266,7 +433,7 @@ BaseLocation * BaseLocationManager::getBaseLocation(const CCPosition & pos) cons
 
 void BaseLocationManager::drawBaseLocations()
 {
-    if (!m_bot.Config().DrawBaseLocationInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::BaseLocationInfo))
     {
         return;
     }
@@ -281,6 +448,22 @@ void BaseLocationManager::drawBaseLocations()
 
     m_bot.Map().drawCircle(Util::GetPosition(nextExpansionPosition), 1, CCColor(255, 0, 255));
     m_bot.Map().drawText(Util::GetPosition(nextExpansionPosition), "Next Expansion Location", CCColor(255, 0, 255));
+
+    // every distance map is counted once no matter how many bases and caches share it
+    std::set<const DistanceMap *> counted;
+    size_t distanceMapBytes = 0;
+    for (auto & baseLocation : m_baseLocationData)
+    {
+        if (counted.insert(&baseLocation.getDistanceMap()).second)
+        {
+            distanceMapBytes += baseLocation.getDistanceMap().getMemoryUsage();
+        }
+    }
+    distanceMapBytes += m_bot.Map().getDistanceMapMemory(counted);
+
+    std::stringstream ss;
+    ss << "Distance Maps: " << counted.size() << " (" << (distanceMapBytes / 1024) << " KB)";
+    m_bot.Map().drawTextScreen(0.72f, 0.02f, ss.str());
 }
 
 const std::vector<const BaseLocation *> & BaseLocationManager::getBaseLocations() const
@@ -298,6 +481,18 @@ const BaseLocation * BaseLocationManager::getPlayerStartingBaseLocation(int play
     return m_playerStartingBaseLocations.at(player);
 }
 
+const BaseLocation * BaseLocationManager::getBaseLocation(int tileX, int tileY) const
+{
+    if (!m_bot.Map().isValidTile(tileX, tileY)) { return nullptr; }
+
+    return m_tileBaseLocations[tileX][tileY];
+}
+
+const TerritoryMap & BaseLocationManager::getTerritoryMap() const
+{
+    return m_territoryMap;
+}
+
 const std::set<const BaseLocation *> & BaseLocationManager::getOccupiedBaseLocations(int player) const
 {
     return m_occupiedBaseLocations.at(player);
@@ -306,95 +501,35 @@ const std::set<const BaseLocation *> & BaseLocationManager::getOccupiedBaseLocat
 
 CCTilePosition BaseLocationManager::getNextExpansion(int player) const
 {
-    const BaseLocation * homeBase = getPlayerStartingBaseLocation(player);
-    const BaseLocation * closestBase = nullptr;
-    float minDistance = std::numeric_limits<float>::max();
+    const ExpansionRanking & ranking = getExpansionRanking(player);
 
-    CCPosition homeTile = homeBase->getPosition();
-    //std::cout << std::endl;
-    for (auto & base : getBaseLocations())
+    // the closest expansion by pathing distance from our main that a town hall can still be placed at
+    for (size_t i(0); i < ranking.bases.size(); ++i)
     {
-        // skip mineral only and starting locations (TODO: fix this)
-        if (base->isMineralOnly() || base->isStartLocation())
+        if (ranking.placeable[i])
         {
-            continue;
-        }
-
-        // get the tile position of the base
-        auto tile = base->getDepotPosition();
-
-        // a building is already there or the tiles are reserved
-        if (!m_bot.Query()->Placement(m_bot.Data(Util::GetTownHall(m_bot.GetPlayerRace(Players::Self), m_bot)).buildAbility, CCPosition(float(tile.x), float(tile.y))))
-        {
-            continue;
-        }
-
-        // the base's distance from our main nexus
-        //int distanceFromHome = homeBase->getGroundDistance(tile);
-        float distanceFromHome = m_bot.Query()->PathingDistance(homeTile, CCPosition((float)tile.x, (float)tile.y));
-
-        /*std::cout << "pos: " << tile.x << "," << tile.y << std::endl;
-        std::cout << "distance: " << distanceFromHome << std::endl;*/
-
-        // if it is not connected, continue
-        if (distanceFromHome <= 0)
-        {
-            continue;
-        }
-
-        if (!closestBase || distanceFromHome < minDistance)
-        {
-            closestBase = base;
-            minDistance = distanceFromHome;
+            return ranking.bases[i]->getDepotPosition();
         }
     }
-    //std::cout << "min distance: " << minDistance << std::endl;
-    //std::cout << std::endl;
-    return closestBase ? closestBase->getDepotPosition() : CCTilePosition(0, 0);
+
+    return CCTilePosition(0, 0);
 }
 
 CCTilePosition BaseLocationManager::getNextExpansion(int player, const BuildingPlacer & placer) const
 {
-    const BaseLocation * homeBase = getPlayerStartingBaseLocation(player);
-    const BaseLocation * closestBase = nullptr;
-    int minDistance = std::numeric_limits<int>::max();
+    const ExpansionRanking & ranking = getExpansionRanking(player);
 
-    CCPosition homeTile = homeBase->getPosition();
-    
-    for (auto & base : getBaseLocations())
+    for (size_t i(0); i < ranking.bases.size(); ++i)
     {
-        // skip mineral only and starting locations (TODO: fix this)
-        if (base->isMineralOnly() || base->isStartLocation())
-        {
-            continue;
-        }
-
         // get the tile position of the base
-        auto tile = base->getDepotPosition();
-        
-        // a building is already there or the tiles are reserved
-        if (!m_bot.Query()->Placement(m_bot.Data(Util::GetTownHall(m_bot.GetPlayerRace(Players::Self), m_bot)).buildAbility, CCPosition(float(tile.x), float(tile.y)))
-            || placer.isReserved(tile.x, tile.y))
-        {
-            continue;
-        }
-
-        // the base's distance from our main nexus
-        //int distanceFromHome = homeBase->getGroundDistance(tile);
-        int distanceFromHome = (int)m_bot.Query()->PathingDistance(homeBase->getPosition(), CCPosition((float)tile.x, (float)tile.y));
+        auto tile = ranking.bases[i]->getDepotPosition();
 
-        // if it is not connected, continue
-        if (distanceFromHome < 0)
-        {
-            continue;
-        }
-
-        if (!closestBase || distanceFromHome < minDistance)
+        // a building is already there or the tiles are reserved
+        if (ranking.placeable[i] && !placer.isReserved(tile.x, tile.y))
         {
-            closestBase = base;
-            minDistance = distanceFromHome;
+            return tile;
         }
     }
 
-    return closestBase ? closestBase->getDepotPosition() : CCTilePosition(0, 0);
+    return CCTilePosition(0, 0);
 }
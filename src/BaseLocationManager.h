@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BaseLocation.h"
+#include "TerritoryMap.h"
 
 namespace CC
 {
@@ -9,6 +10,15 @@ namespace CC
 
     class BaseLocationManager
     {
+        // expansions ordered by pathing distance from a player's home base, with whether a town hall fits at each
+        struct ExpansionRanking
+        {
+            std::vector<const BaseLocation *>   bases;
+            std::vector<bool>                   placeable;
+            uint64_t                            signature;      // the structure signature placement was last checked for
+            bool                                ranked;
+        };
+
         CCBot & m_bot;
 
         std::vector<BaseLocation>                       m_baseLocationData;
@@ -17,9 +27,18 @@ namespace CC
         std::map<int, const BaseLocation *>             m_playerStartingBaseLocations;
         std::map<int, std::set<const BaseLocation *>>   m_occupiedBaseLocations;
         std::vector<std::vector<BaseLocation *>>        m_tileBaseLocations;
+        TerritoryMap                                    m_territoryMap;
+        uint64_t                                        m_structureSignature;   // changes whenever a structure appears or disappears
+        mutable std::map<int, ExpansionRanking>         m_expansionRankings;
 
         BaseLocation * getBaseLocation(const CCPosition & pos) const;
 
+        void computeBaseLocations();
+        bool loadBaseLocations();
+        void updateStructureSignature();
+
+        const ExpansionRanking & getExpansionRanking(int player) const;
+
     public:
 
         BaseLocationManager(CCBot & bot);
@@ -32,6 +51,8 @@ namespace CC
         const std::vector<const BaseLocation *> & getStartingBaseLocations() const;
         const std::set<const BaseLocation *> & getOccupiedBaseLocations(int player) const;
         const BaseLocation * getPlayerStartingBaseLocation(int player) const;
+        const BaseLocation * getBaseLocation(int tileX, int tileY) const;
+        const TerritoryMap & getTerritoryMap() const;
 
         CCTilePosition getNextExpansion(int player) const;
         CCTilePosition getNextExpansion(int player, const BuildingPlacer & placer) const;
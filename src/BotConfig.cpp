@@ -18,6 +18,7 @@ BotConfig::BotConfig()
     UseEnemySpecificStrategy            = false;
     FoundEnemySpecificStrategy          = false;
     UsingAutoObserver                   = false;
+    UseMapCache                         = true;
 
     SetLocalSpeed                       = 10;
     SetFrameSkip                        = 0;
@@ -149,5 +150,6 @@ void BotConfig::readConfigFile()
         const json & module = j["Modules"];
 
         JSONTools::ReadBool("UseAutoObserver", module, UsingAutoObserver);
+        JSONTools::ReadBool("UseMapCache", module, UseMapCache);
     }
 }
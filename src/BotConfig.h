@@ -14,6 +14,7 @@ namespace CC
         std::string ConfigFileLocation;
 
         bool UsingAutoObserver;
+        bool UseMapCache;
 
         std::string BotName;
         std::string Authors;
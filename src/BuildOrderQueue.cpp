@@ -66,6 +66,11 @@ bool BuildOrderQueue::canSkipItem()
     return highestNotBlocking;
 }
 
+bool BuildOrderQueue::hasNextHighestPriorityItem()
+{
+    return m_queue.size() > (size_t)m_numSkippedItems;
+}
+
 void BuildOrderQueue::queueItem(const BuildOrderItem & b)
 {
     // if the queue is empty, set the highest and lowest priorities
@@ -46,6 +46,7 @@ namespace CC
         BuildOrderItem & getNextHighestPriorityItem();	// returns the highest priority item
 
         bool canSkipItem();
+        bool hasNextHighestPriorityItem();							// whether an item is left below the skipped ones
         std::string getQueueInformation() const;
 
         // overload the bracket operator for ease of use
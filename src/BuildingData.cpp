@@ -4,46 +4,165 @@ using namespace CC;
 
 BuildingData::BuildingData()
 {
+    for (size_t status = 0; status < BuildingStatus::Size; ++status)
+    {
+        m_head[status] = -1;
+        m_tail[status] = -1;
+        m_count[status] = 0;
+    }
+}
+
+int BuildingData::getIndex(BuildingTaskID id) const
+{
+    const size_t index = (size_t)(id & 0xFFFFFFFF);
+    const uint32_t generation = (uint32_t)(id >> 32);
+
+    if (index >= m_slots.size() || m_slots[index].generation != generation || (generation & 1) == 0)
+    {
+        return -1;
+    }
 
+    return (int)index;
 }
 
-void BuildingData::removeBuilding(const Building & b)
+BuildingTaskID BuildingData::getID(int index) const
 {
-    const auto & building = std::find(_buildings.begin(), _buildings.end(), b);
+    return index < 0 ? NoBuildingTask : ((BuildingTaskID)m_slots[index].generation << 32) | (BuildingTaskID)index;
+}
+
+void BuildingData::link(int index)
+{
+    Slot & slot = m_slots[index];
+    const size_t status = slot.building.status;
+
+    slot.prev = m_tail[status];
+    slot.next = -1;
 
-    if (building != _buildings.end())
+    if (m_tail[status] != -1)
     {
-        _buildings.erase(building);
+        m_slots[m_tail[status]].next = index;
     }
+    else
+    {
+        m_head[status] = index;
+    }
+
+    m_tail[status] = index;
+    ++m_count[status];
 }
 
-std::vector<Building> & BuildingData::getBuildings()
+void BuildingData::unlink(int index)
 {
-    return _buildings;
+    Slot & slot = m_slots[index];
+    const size_t status = slot.building.status;
+
+    if (slot.prev != -1) { m_slots[slot.prev].next = slot.next; } else { m_head[status] = slot.next; }
+    if (slot.next != -1) { m_slots[slot.next].prev = slot.prev; } else { m_tail[status] = slot.prev; }
+
+    slot.prev = -1;
+    slot.next = -1;
+    --m_count[status];
 }
 
-void BuildingData::addBuilding(const Building & b)
+BuildingTaskID BuildingData::addBuilding(const Building & b)
 {
-    _buildings.push_back(b);
+    BOT_ASSERT(b.status < BuildingStatus::Size, "Unknown building status: %d", (int)b.status);
+
+    int index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = (int)m_slots.size();
+        m_slots.push_back(Slot());
+        m_slots.back().generation = 0;
+    }
+
+    Slot & slot = m_slots[index];
+    slot.building = b;
+    ++slot.generation;
+    link(index);
+
+    return getID(index);
 }
 
-bool BuildingData::isBeingBuilt(UnitType type)
+void BuildingData::removeBuilding(BuildingTaskID id)
 {
-    for (auto & b : _buildings)
+    const int index = getIndex(id);
+    if (index == -1)
     {
-        if (b.type == type)
-        {
-            return true;
-        }
+        return;
     }
 
-    return false;
+    unlink(index);
+    m_slots[index].building = Building();
+    ++m_slots[index].generation;
+    m_freeSlots.push_back(index);
 }
 
-void BuildingData::removeBuildings(const std::vector<Building> & buildings)
+void BuildingData::setStatus(BuildingTaskID id, size_t status)
 {
-    for (const auto & b : buildings)
+    BOT_ASSERT(status < BuildingStatus::Size, "Unknown building status: %d", (int)status);
+
+    const int index = getIndex(id);
+    if (index == -1 || m_slots[index].building.status == status)
     {
-        removeBuilding(b);
+        return;
     }
-}
\ No newline at end of file
+
+    unlink(index);
+    m_slots[index].building.status = status;
+    link(index);
+}
+
+Building * BuildingData::getBuilding(BuildingTaskID id)
+{
+    const int index = getIndex(id);
+    return index == -1 ? nullptr : &m_slots[index].building;
+}
+
+const Building * BuildingData::getBuilding(BuildingTaskID id) const
+{
+    const int index = getIndex(id);
+    return index == -1 ? nullptr : &m_slots[index].building;
+}
+
+BuildingTaskID BuildingData::first(size_t status) const
+{
+    return getID(m_head[status]);
+}
+
+BuildingTaskID BuildingData::next(BuildingTaskID id) const
+{
+    const int index = getIndex(id);
+    return index == -1 ? NoBuildingTask : getID(m_slots[index].next);
+}
+
+size_t BuildingData::size() const
+{
+    return m_slots.size() - m_freeSlots.size();
+}
+
+size_t BuildingData::size(size_t status) const
+{
+    return m_count[status];
+}
+
+bool BuildingData::isBeingBuilt(const UnitType & type) const
+{
+    for (size_t status = 0; status < BuildingStatus::Size; ++status)
+    {
+        for (int index = m_head[status]; index != -1; index = m_slots[index].next)
+        {
+            if (m_slots[index].building.type == type)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -5,19 +5,53 @@
 
 namespace CC
 {
+    // a handle to a building task, it stays valid until the task is removed and never refers to another task
+    typedef uint64_t BuildingTaskID;
+    const BuildingTaskID NoBuildingTask = 0;
+
+    // Building tasks in a slot map. A removed task leaves its slot to the next task added, and every slot counts
+    // how often it was reused, so handles to removed tasks stop resolving instead of pointing at a new task.
+    // The tasks of each status are kept in an intrusive list, in the order they got that status, so a status
+    // change is an unlink and a link, and walking the tasks of one status never touches the others.
     class BuildingData
     {
-        std::vector<Building>                   _buildings;
+        struct Slot
+        {
+            Building    building;
+            uint32_t    generation;     // odd while the slot holds a task
+            int         prev;           // neighbours in the list of the task's status, -1 at the ends
+            int         next;
+        };
+
+        std::vector<Slot>   m_slots;
+        std::vector<int>    m_freeSlots;
+        int                 m_head[BuildingStatus::Size];
+        int                 m_tail[BuildingStatus::Size];
+        size_t              m_count[BuildingStatus::Size];
+
+        int             getIndex(BuildingTaskID id) const;
+        BuildingTaskID  getID(int index) const;
+        void            link(int index);
+        void            unlink(int index);
 
     public:
 
         BuildingData();
 
-        std::vector<Building> & getBuildings();
+        BuildingTaskID  addBuilding(const Building & b);
+        void            removeBuilding(BuildingTaskID id);
+        void            setStatus(BuildingTaskID id, size_t status);
+
+        // nullptr once the task has been removed
+        Building *          getBuilding(BuildingTaskID id);
+        const Building *    getBuilding(BuildingTaskID id) const;
+
+        // walks the tasks of a status, take the next handle before changing the status of a task or removing it
+        BuildingTaskID  first(size_t status) const;
+        BuildingTaskID  next(BuildingTaskID id) const;
 
-        void addBuilding(const Building & b);
-        void removeBuilding(const Building & b);
-        void removeBuildings(const std::vector<Building> & buildings);
-        bool isBeingBuilt(UnitType type);
+        size_t          size() const;
+        size_t          size(size_t status) const;
+        bool            isBeingBuilt(const UnitType & type) const;
     };
-}
\ No newline at end of file
+}
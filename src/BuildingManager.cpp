@@ -5,12 +5,28 @@
 
 using namespace CC;
 
+// how far a worker walks in a frame, sc2 workers move 2.8125 tiles per game second of 16 frames
+#ifdef SC2API
+const float WorkerTilesPerFrame = 2.8125f / 16;
+#else
+const float WorkerTilesPerFrame = 4.92f / 32;
+#endif
+
+// frames between two location searches for a building whose builder hasn't been sent yet
+const int PrepareSearchFrames = 8;
+
+// prepared buildings listed in the building information
+const size_t LatencyHistory = 5;
+
 BuildingManager::BuildingManager(CCBot & bot)
     : m_bot(bot)
     , m_buildingPlacer(bot)
     , m_debugMode(false)
     , m_reservedMinerals(0)
     , m_reservedGas(0)
+    , m_prepared()
+    , m_nextPrepareFrame(0)
+    , m_totalLatencySaved(0)
 {
 
 }
@@ -23,19 +39,10 @@ void BuildingManager::onStart()
 // gets called every frame from GameCommander
 void BuildingManager::onFrame()
 {
-    for (auto unit : m_bot.UnitInfo().getUnits(Players::Self))
-    {
-        // filter out units which aren't buildings under construction
-        if (m_bot.Data(unit).isBuilding)
-        {
-            std::stringstream ss;
-            ss << unit.getID();
-            m_bot.Map().drawText(unit.getPosition(), ss.str());
-        }
-    }
-
+    m_buildingPlacer.onFrame();             // keep the placer's view of occupied tiles current
     validateWorkersAndBuildings();          // check to see if assigned workers have died en route or while constructing
     assignWorkersToUnassignedBuildings();   // assign workers to the unassigned buildings and label them 'planned'    
+    checkPreparedBuilding();                // give up the builder sent ahead if production no longer wants its building
     constructAssignedBuildings();           // for each planned building, if the worker isn't constructing, send the command    
     checkForStartedConstruction();          // check to see if any buildings have started construction and update data structures    
     checkForDeadTerranBuilders();           // if we are terran and a building is under construction without a worker, assign a new one    
@@ -46,64 +53,48 @@ void BuildingManager::onFrame()
 
 bool BuildingManager::isBeingBuilt(UnitType type)
 {
-    for (auto & b : m_buildings)
-    {
-        if (b.type == type)
-        {
-            return true;
-        }
-    }
-
-    return false;
+    return m_buildings.isBeingBuilt(type);
 }
 
-// STEP 1: DO BOOK KEEPING ON WORKERS WHICH MAY HAVE DIED
+// STEP 1: DO BOOK KEEPING ON BUILDINGS WHICH HAVE DIED
 void BuildingManager::validateWorkersAndBuildings()
 {
     // TODO: if a terran worker dies while constructing and its building
     //       is under construction, place unit back into buildingsNeedingBuilders
 
-    std::vector<Building> toRemove;
-
-    // find any buildings which have become obsolete
-    for (auto & b : m_buildings)
+    // only the buildings that died last frame are looked up, not every task
+    for (auto & unit : m_bot.UnitInfo().getUnitsDied(Players::Self))
     {
-        if (b.status != BuildingStatus::UnderConstruction)
+        auto it = m_tasksByBuilding.find(unit.getID());
+        if (it == m_tasksByBuilding.end())
         {
             continue;
         }
 
-        auto buildingUnit = b.buildingUnit;
-
-        // TODO: || !b.buildingUnit->getType().isBuilding()
-        if (!buildingUnit.isValid())
-        {
-            toRemove.push_back(b);
-        }
+        const BuildingTaskID id = it->second;
+        m_tasksByBuilding.erase(it);
+        removeBuilding(id);
     }
-
-    removeBuildings(toRemove);
 }
 
 // STEP 2: ASSIGN WORKERS TO BUILDINGS WITHOUT THEM
 void BuildingManager::assignWorkersToUnassignedBuildings()
 {
-    std::vector<Building> toRemove;
-
     // for each building that doesn't have a builder, assign one
-    for (Building & b : m_buildings)
+    for (BuildingTaskID id = m_buildings.first(BuildingStatus::Unassigned), next; id != NoBuildingTask; id = next)
     {
-        if (b.status != BuildingStatus::Unassigned)
-        {
-            continue;
-        }
+        next = m_buildings.next(id);
+        Building & b = *m_buildings.getBuilding(id);
 
         BOT_ASSERT(!b.builderUnit.isValid(), "Error: Tried to assign a builder to a building that already had one ");
 
         if (m_debugMode) { printf("Assigning Worker To: %s\n", b.type.getName().c_str()); }
 
+        // a builder sent ahead takes the building to where it was sent
+        const bool prepared = m_prepared.builder.isValid() && m_prepared.type == b.type;
+
         // grab a worker unit from WorkerManager which is closest to this final position
-        CCTilePosition testLocation = getBuildingLocation(b);
+        CCTilePosition testLocation = prepared ? m_prepared.position : getBuildingLocation(b);
         if (!m_bot.Map().isValidTile(testLocation))
         {
             continue;
@@ -115,11 +106,12 @@ void BuildingManager::assignWorkersToUnassignedBuildings()
             if (b.posFindFailTimes > 300)
             {
                 if (m_debugMode) { printf("Can't build %s, removing from queue\n", b.type.getName().c_str()); }
-                toRemove.push_back(b);
 
                 // unreserve the resources
                 m_reservedMinerals -= b.type.mineralPrice();
                 m_reservedGas -= b.type.gasPrice();
+
+                removeBuilding(id);
             }
             else
             {
@@ -131,7 +123,7 @@ void BuildingManager::assignWorkersToUnassignedBuildings()
         b.finalPosition = testLocation;
 
         // grab the worker unit from WorkerManager which is closest to this final position
-        Unit builderUnit = m_bot.Workers().getBuilder(b);
+        Unit builderUnit = prepared ? m_prepared.builder : m_bot.Workers().getBuilder(b);
         b.builderUnit = builderUnit;
 
         if (!b.builderUnit.isValid())
@@ -142,21 +134,26 @@ void BuildingManager::assignWorkersToUnassignedBuildings()
         // reserve this building's space
         m_buildingPlacer.reserveTiles((int)b.finalPosition.x, (int)b.finalPosition.y, b.type.tileWidth(), b.type.tileHeight());
 
-        b.status = BuildingStatus::Assigned;
-    }
+        m_buildings.setStatus(id, BuildingStatus::Assigned);
+        m_tasksByPosition[getPositionKey(b.finalPosition)] = id;
 
-    removeBuildings(toRemove);
+        // the walk the builder already did is how much sooner the building starts
+        if (prepared)
+        {
+            const int saved = std::max(0, getTravelFrames(m_prepared.dispatchPosition, b.finalPosition) - getTravelFrames(b.builderUnit.getPosition(), b.finalPosition));
+            m_totalLatencySaved += saved;
+            m_latencySaved.push_back(std::make_pair(b.type.getName(), saved));
+            m_prepared = PreparedBuilding();
+        }
+    }
 }
 
 // STEP 3: ISSUE CONSTRUCTION ORDERS TO ASSIGN BUILDINGS AS NEEDED
 void BuildingManager::constructAssignedBuildings()
 {
-    for (auto & b : m_buildings)
+    for (BuildingTaskID id = m_buildings.first(BuildingStatus::Assigned); id != NoBuildingTask; id = m_buildings.next(id))
     {
-        if (b.status != BuildingStatus::Assigned)
-        {
-            continue;
-        }
+        Building & b = *m_buildings.getBuilding(id);
 
         // TODO: not sure if this is the correct way to tell if the building is constructing
         //sc2::AbilityID buildAbility = m_bot.Data(b.type).buildAbility;
@@ -236,64 +233,64 @@ void BuildingManager::constructAssignedBuildings()
 // STEP 4: UPDATE DATA STRUCTURES FOR BUILDINGS STARTING CONSTRUCTION
 void BuildingManager::checkForStartedConstruction()
 {
-    // for each building unit which is being constructed
-    for (auto buildingStarted : m_bot.UnitInfo().getUnits(Players::Self))
+    // buildings that started construction show up as new structures on the map, and each one is matched
+    // to the assigned task with its position
+    for (auto & unitID : m_bot.Map().getAddedStructures())
     {
-        // filter out units which aren't buildings under construction
-        if (!buildingStarted.getType().isBuilding() || !buildingStarted.isBeingConstructed())
+        Unit buildingStarted = m_bot.GetUnit(unitID);
+
+        // filter out units which aren't our buildings under construction
+        if (!buildingStarted.isValid() || buildingStarted.getPlayer() != Players::Self || !buildingStarted.getType().isBuilding() || !buildingStarted.isBeingConstructed())
         {
             continue;
         }
 
-        // check all our building status objects to see if we have a match and if we do, update it
-
-        for (auto & b : m_buildings)
+        auto it = m_tasksByPosition.find(getPositionKey(buildingStarted.getTilePosition()));
+        if (it == m_tasksByPosition.end())
         {
-            if (b.status != BuildingStatus::Assigned)
-            {
-                continue;
-            }
-
-            // check if the positions match
-            int dx = b.finalPosition.x - buildingStarted.getTilePosition().x;
-            int dy = b.finalPosition.y - buildingStarted.getTilePosition().y;
+            continue;
+        }
 
-            if (dx*dx + dy*dy < Util::TileToPosition(1.0f))
-            {
-                if (b.buildingUnit.isValid())
-                {
-                    std::cout << "Building mis-match somehow\n";
-                }
+        const BuildingTaskID id = it->second;
+        m_tasksByPosition.erase(it);
 
-                // the resources should now be spent, so unreserve them
-                m_reservedMinerals -= buildingStarted.getType().mineralPrice();
-                m_reservedGas      -= buildingStarted.getType().gasPrice();
-                
-                // flag it as started and set the buildingUnit
-                b.underConstruction = true;
-                b.buildingUnit = buildingStarted;
+        Building * task = m_buildings.getBuilding(id);
+        if (!task || task->status != BuildingStatus::Assigned)
+        {
+            continue;
+        }
 
-                // if we are zerg, the buildingUnit now becomes nullptr since it's destroyed
-                if (Util::IsZerg(m_bot.GetPlayerRace(Players::Self)))
-                {
-                    b.builderUnit = Unit();
-                }
-                else if (Util::IsProtoss(m_bot.GetPlayerRace(Players::Self)))
-                {
-                    m_bot.Workers().finishedWithWorker(b.builderUnit);
-                    b.builderUnit = Unit();
-                }
+        Building & b = *task;
+        if (b.buildingUnit.isValid())
+        {
+            std::cout << "Building mis-match somehow\n";
+        }
 
-                // put it in the under construction vector
-                b.status = BuildingStatus::UnderConstruction;
+        // the resources should now be spent, so unreserve them
+        m_reservedMinerals -= buildingStarted.getType().mineralPrice();
+        m_reservedGas      -= buildingStarted.getType().gasPrice();
 
-                // free this space
-                m_buildingPlacer.freeTiles((int)b.finalPosition.x, (int)b.finalPosition.y, b.type.tileWidth(), b.type.tileHeight());
+        // flag it as started and set the buildingUnit
+        b.underConstruction = true;
+        b.buildingUnit = buildingStarted;
 
-                // only one building will match
-                break;
-            }
+        // if we are zerg, the buildingUnit now becomes nullptr since it's destroyed
+        if (Util::IsZerg(m_bot.GetPlayerRace(Players::Self)))
+        {
+            b.builderUnit = Unit();
+        }
+        else if (Util::IsProtoss(m_bot.GetPlayerRace(Players::Self)))
+        {
+            m_bot.Workers().finishedWithWorker(b.builderUnit);
+            b.builderUnit = Unit();
         }
+
+        // put it in the under construction list
+        m_buildings.setStatus(id, BuildingStatus::UnderConstruction);
+        m_tasksByBuilding[buildingStarted.getID()] = id;
+
+        // free this space
+        m_buildingPlacer.freeTiles((int)b.finalPosition.x, (int)b.finalPosition.y, b.type.tileWidth(), b.type.tileHeight());
     }
 }
 
@@ -303,13 +300,16 @@ void BuildingManager::checkForDeadTerranBuilders() {}
 // STEP 6: CHECK FOR COMPLETED BUILDINGS
 void BuildingManager::checkForCompletedBuildings()
 {
-    std::vector<Building> toRemove;
-
     // for each of our buildings under construction
-    for (auto & b : m_buildings)
+    for (BuildingTaskID id = m_buildings.first(BuildingStatus::UnderConstruction), next; id != NoBuildingTask; id = next)
     {
-        if (b.status != BuildingStatus::UnderConstruction)
+        next = m_buildings.next(id);
+        Building & b = *m_buildings.getBuilding(id);
+
+        // TODO: || !b.buildingUnit->getType().isBuilding()
+        if (!b.buildingUnit.isValid())
         {
+            removeBuilding(id);
             continue;
         }
 
@@ -354,12 +354,10 @@ void BuildingManager::checkForCompletedBuildings()
                 m_bot.Actions()->UnitCommand(b.buildingUnit.getUnitPtr(), sc2::ABILITY_ID::RALLY_BUILDING, pos);
             }
 
-            // remove this unit from the under construction vector
-            toRemove.push_back(b);
+            // remove this unit from the under construction list
+            removeBuilding(id);
         }
     }
-
-    removeBuildings(toRemove);
 }
 
 // add a new building to be constructed
@@ -371,7 +369,98 @@ void BuildingManager::addBuildingTask(const UnitType & type, const CCTilePositio
     Building b(type, desiredPosition);
     b.status = BuildingStatus::Unassigned;
 
-    m_buildings.push_back(b);
+    m_buildings.addBuilding(b);
+}
+
+void BuildingManager::prepareBuilding(const UnitType & type, const CCTilePosition & desiredPosition, int framesUntilAffordable)
+{
+    const int frame = m_bot.GetCurrentFrame();
+
+    if (m_prepared.builder.isValid())
+    {
+        if (m_prepared.type == type)
+        {
+            m_prepared.requestFrame = frame;
+            return;
+        }
+
+        // something else comes next now
+        cancelPreparedBuilding();
+    }
+
+    if (frame < m_nextPrepareFrame)
+    {
+        return;
+    }
+
+    m_nextPrepareFrame = frame + PrepareSearchFrames;
+
+    Building b(type, desiredPosition);
+    b.finalPosition = getBuildingLocation(b);
+    if (!m_bot.Map().isValidTile(b.finalPosition) || (b.finalPosition.x == 0 && b.finalPosition.y == 0))
+    {
+        return;
+    }
+
+    // the builder leaves once its walk takes as long as the wait for the resources
+    Unit builder = m_bot.Workers().getBuilder(b, false);
+    if (!builder.isValid() || getTravelFrames(builder.getPosition(), b.finalPosition) < framesUntilAffordable)
+    {
+        return;
+    }
+
+    builder = m_bot.Workers().getBuilder(b);
+    builder.move(b.finalPosition);
+
+    // nothing else may take the location while the builder walks there
+    m_buildingPlacer.reserveTiles((int)b.finalPosition.x, (int)b.finalPosition.y, type.tileWidth(), type.tileHeight());
+
+    m_prepared.type             = type;
+    m_prepared.position         = b.finalPosition;
+    m_prepared.builder          = builder;
+    m_prepared.dispatchPosition = builder.getPosition();
+    m_prepared.requestFrame     = frame;
+}
+
+void BuildingManager::cancelPreparedBuilding()
+{
+    if (!m_prepared.builder.isValid())
+    {
+        return;
+    }
+
+    m_bot.Workers().finishedWithWorker(m_prepared.builder);
+    m_buildingPlacer.freeTiles((int)m_prepared.position.x, (int)m_prepared.position.y, m_prepared.type.tileWidth(), m_prepared.type.tileHeight());
+    m_prepared = PreparedBuilding();
+}
+
+// production asks for the prepared building every frame until it can afford it, and the building task
+// takes the builder in the frame it is added, so a prepared building nobody asked for this frame is given up
+void BuildingManager::checkPreparedBuilding()
+{
+    if (!m_prepared.builder.isValid())
+    {
+        return;
+    }
+
+    if (m_prepared.requestFrame != m_bot.GetCurrentFrame() || !m_prepared.builder.isAlive())
+    {
+        cancelPreparedBuilding();
+    }
+}
+
+int BuildingManager::getTravelFrames(const CCPosition & from, const CCTilePosition & to) const
+{
+    const CCPosition target = Util::GetPosition(to);
+
+    // only an estimate, so the region graph answers it without a path search every frame
+    int distance = m_bot.Map().getApproxGroundDistance(from, target);
+    if (distance < 0)
+    {
+        distance = (int)(Util::Dist(from, target) / Util::TileToPosition(1.0f));
+    }
+
+    return (int)(distance / WorkerTilesPerFrame);
 }
 
 // TODO: may need to iterate over all tiles of the building footprint
@@ -400,52 +489,78 @@ void BuildingManager::drawBuildingInformation()
 {
     m_buildingPlacer.drawReservedTiles();
 
-    if (!m_bot.Config().DrawBuildingInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::BuildingInfo))
     {
         return;
     }
 
+    for (auto & unit : m_bot.UnitInfo().getUnits(Players::Self))
+    {
+        // filter out units which aren't buildings under construction
+        if (m_bot.Data(unit).isBuilding)
+        {
+            m_bot.Map().drawText(unit.getPosition(), std::to_string(unit.getID()));
+        }
+    }
+
     std::stringstream ss;
     ss << "Building Information " << m_buildings.size() << "\n\n\n";
 
-    int yspace = 0;
+    if (m_prepared.builder.isValid())
+    {
+        ss << "Prepared " << m_prepared.type.getName() << "    " << m_prepared.builder.getID() << " (" << m_prepared.position.x << "," << m_prepared.position.y << ")\n";
+    }
 
-    for (const auto & b : m_buildings)
+    ss << "Walking saved by sending builders ahead: " << m_totalLatencySaved << " frames\n";
+    for (size_t i = m_latencySaved.size() > LatencyHistory ? m_latencySaved.size() - LatencyHistory : 0; i < m_latencySaved.size(); ++i)
     {
-        std::stringstream dss;
+        ss << "    " << m_latencySaved[i].first << " " << m_latencySaved[i].second << " frames\n";
+    }
+    ss << "\n";
 
-        if (b.builderUnit.isValid())
-        {
-            dss << "\n\nBuilder: " << b.builderUnit.getID() << "\n";
-        }
+    int yspace = 0;
 
-        if (b.buildingUnit.isValid())
+    // the tasks of every status, in the order they got it
+    for (size_t status = 0; status < BuildingStatus::Size; ++status)
+    {
+        for (BuildingTaskID id = m_buildings.first(status); id != NoBuildingTask; id = m_buildings.next(id))
         {
-            dss << "Building: " << b.buildingUnit.getID() << "\n" << b.buildingUnit.getBuildPercentage();
-            m_bot.Map().drawText(b.buildingUnit.getPosition(), dss.str());
-        }
+            const Building & b = *m_buildings.getBuilding(id);
+            std::stringstream dss;
+
+            if (b.builderUnit.isValid())
+            {
+                dss << "\n\nBuilder: " << b.builderUnit.getID() << "\n";
+            }
+
+            if (b.buildingUnit.isValid())
+            {
+                dss << "Building: " << b.buildingUnit.getID() << "\n" << b.buildingUnit.getBuildPercentage();
+                m_bot.Map().drawText(b.buildingUnit.getPosition(), dss.str());
+            }
         
-        if (b.status == BuildingStatus::Unassigned)
-        {
-            ss << "Unassigned " << b.type.getName() << "    " << getBuildingWorkerCode(b) << "\n";
-        }
-        else if (b.status == BuildingStatus::Assigned)
-        {
-            ss << "Assigned " << b.type.getName() << "    " << b.builderUnit.getID() << " " << getBuildingWorkerCode(b) << " (" << b.finalPosition.x << "," << b.finalPosition.y << ")\n";
+            if (b.status == BuildingStatus::Unassigned)
+            {
+                ss << "Unassigned " << b.type.getName() << "    " << getBuildingWorkerCode(b) << "\n";
+            }
+            else if (b.status == BuildingStatus::Assigned)
+            {
+                ss << "Assigned " << b.type.getName() << "    " << b.builderUnit.getID() << " " << getBuildingWorkerCode(b) << " (" << b.finalPosition.x << "," << b.finalPosition.y << ")\n";
 
-            int xdelta = (int)std::ceil((b.type.tileWidth() - 1.0) / 2);
-            int ydelta = (int)std::ceil((b.type.tileHeight() - 1.0) / 2);
-            int x1 = b.finalPosition.x - xdelta;
-            int y1 = b.finalPosition.y - ydelta;
-            int x2 = b.finalPosition.x + b.type.tileWidth() - xdelta;
-            int y2 = b.finalPosition.y + b.type.tileHeight() - ydelta;
+                int xdelta = (int)std::ceil((b.type.tileWidth() - 1.0) / 2);
+                int ydelta = (int)std::ceil((b.type.tileHeight() - 1.0) / 2);
+                int x1 = b.finalPosition.x - xdelta;
+                int y1 = b.finalPosition.y - ydelta;
+                int x2 = b.finalPosition.x + b.type.tileWidth() - xdelta;
+                int y2 = b.finalPosition.y + b.type.tileHeight() - ydelta;
 
-            m_bot.Map().drawBox((CCPositionType)x1, (CCPositionType)y1, (CCPositionType)x2, (CCPositionType)y2, CCColor(255, 0, 0));
-            //m_bot.Map().drawLine(b.finalPosition, m_bot.GetUnit(b.builderUnitTag)->pos, CCColors::Yellow);
-        }
-        else if (b.status == BuildingStatus::UnderConstruction)
-        {
-            ss << "Constructing " << b.type.getName() << "    " << getBuildingWorkerCode(b) << "\n";
+                m_bot.Map().drawBox((CCPositionType)x1, (CCPositionType)y1, (CCPositionType)x2, (CCPositionType)y2, CCColor(255, 0, 0));
+                //m_bot.Map().drawLine(b.finalPosition, m_bot.GetUnit(b.builderUnitTag)->pos, CCColors::Yellow);
+            }
+            else if (b.status == BuildingStatus::UnderConstruction)
+            {
+                ss << "Constructing " << b.type.getName() << "    " << getBuildingWorkerCode(b) << "\n";
+            }
         }
     }
 
@@ -456,11 +571,11 @@ std::vector<UnitType> BuildingManager::buildingsQueued() const
 {
     std::vector<UnitType> buildingsQueued;
 
-    for (const auto & b : m_buildings)
+    for (size_t status : { BuildingStatus::Unassigned, BuildingStatus::Assigned })
     {
-        if (b.status == BuildingStatus::Unassigned || b.status == BuildingStatus::Assigned)
+        for (BuildingTaskID id = m_buildings.first(status); id != NoBuildingTask; id = m_buildings.next(id))
         {
-            buildingsQueued.push_back(b.type);
+            buildingsQueued.push_back(m_buildings.getBuilding(id)->type);
         }
     }
 
@@ -471,12 +586,9 @@ std::vector<UnitType> BuildingManager::getUnassignedQueued() const
 {
     std::vector<UnitType> buildingsQueued;
 
-    for (const auto& b : m_buildings)
+    for (BuildingTaskID id = m_buildings.first(BuildingStatus::Unassigned); id != NoBuildingTask; id = m_buildings.next(id))
     {
-        if (b.status == BuildingStatus::Unassigned)
-        {
-            buildingsQueued.push_back(b.type);
-        }
+        buildingsQueued.push_back(m_buildings.getBuilding(id)->type);
     }
 
     return buildingsQueued;
@@ -503,23 +615,49 @@ CCTilePosition BuildingManager::getBuildingLocation(const Building & b)
             return CCTilePosition(-1, -1);
         }
     }
-    
+
+    // planned slots first, the search only runs when the layout has no free slot left for this building
+    CCTilePosition slot = m_buildingPlacer.getLayoutLocation(b);
+    if (slot.x != 0 || slot.y != 0)
+    {
+        return slot;
+    }
 
     // get a position within our region
     // TODO: put back in special pylon / cannon spacing
     return m_buildingPlacer.getBuildLocationNear(b, m_bot.Config().BuildingSpacing);
 }
 
-void BuildingManager::removeBuildings(const std::vector<Building> & toRemove)
-
+// removes a task and forgets where it was indexed
+void BuildingManager::removeBuilding(BuildingTaskID id)
 {
-    for (auto & b : toRemove)
+    const Building * b = m_buildings.getBuilding(id);
+    if (!b)
     {
-        const auto & it = std::find(m_buildings.begin(), m_buildings.end(), b);
+        return;
+    }
 
-        if (it != m_buildings.end())
+    if (b->status == BuildingStatus::Assigned)
+    {
+        auto it = m_tasksByPosition.find(getPositionKey(b->finalPosition));
+        if (it != m_tasksByPosition.end() && it->second == id)
+        {
+            m_tasksByPosition.erase(it);
+        }
+    }
+    else if (b->status == BuildingStatus::UnderConstruction && b->buildingUnit.isValid())
+    {
+        auto it = m_tasksByBuilding.find(b->buildingUnit.getID());
+        if (it != m_tasksByBuilding.end() && it->second == id)
         {
-            m_buildings.erase(it);
+            m_tasksByBuilding.erase(it);
         }
     }
-}
\ No newline at end of file
+
+    m_buildings.removeBuilding(id);
+}
+
+int BuildingManager::getPositionKey(const CCTilePosition & tile) const
+{
+    return (int)tile.y * m_bot.Map().width() + (int)tile.x;
+}
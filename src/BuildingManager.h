@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include "BuildingPlacer.h"
+#include "BuildingData.h"
 
 namespace CC
 {
@@ -12,14 +13,36 @@ namespace CC
         CCBot &   m_bot;
 
         BuildingPlacer  m_buildingPlacer;
-        std::vector<Building> m_buildings;
+        BuildingData    m_buildings;
+
+        std::map<int, BuildingTaskID>       m_tasksByPosition;  // assigned tasks by the tile index of their final position
+        std::map<CCUnitID, BuildingTaskID>  m_tasksByBuilding;  // tasks under construction by their building unit
+
+        // a builder sent ahead to where the next building will go, while we can't afford it yet
+        struct PreparedBuilding
+        {
+            UnitType        type;
+            CCTilePosition  position;
+            Unit            builder;
+            CCPosition      dispatchPosition;   // where the builder was when it was sent
+            int             requestFrame;       // the last frame production still wanted the building
+        };
+
+        PreparedBuilding    m_prepared;
+        int                 m_nextPrepareFrame;     // locations aren't searched every frame while the builder waits
+        int                 m_totalLatencySaved;    // frames of walking done before the buildings could be afforded
+        std::vector<std::pair<std::string, int>> m_latencySaved;    // the same per prepared building
 
         bool            m_debugMode;
         int             m_reservedMinerals;				// minerals reserved for planned buildings
         int             m_reservedGas;					// gas reserved for planned buildings
 
         bool            isBuildingPositionExplored(const Building & b) const;
-        void            removeBuildings(const std::vector<Building> & toRemove);
+        void            removeBuilding(BuildingTaskID id);
+        int             getPositionKey(const CCTilePosition & tile) const;
+        int             getTravelFrames(const CCPosition & from, const CCTilePosition & to) const;
+        void            cancelPreparedBuilding();
+        void            checkPreparedBuilding();
 
         void            validateWorkersAndBuildings();		    // STEP 1
         void            assignWorkersToUnassignedBuildings();	// STEP 2
@@ -37,6 +60,9 @@ namespace CC
         void                onStart();
         void                onFrame();
         void                addBuildingTask(const UnitType & type, const CCTilePosition & desiredPosition);
+
+        // sends a builder ahead so it reaches the building's location about when we can afford the building
+        void                prepareBuilding(const UnitType & type, const CCTilePosition & desiredPosition, int framesUntilAffordable);
         void                drawBuildingInformation();
         CCTilePosition      getBuildingLocation(const Building & b);
 
@@ -3,23 +3,81 @@
 #include "CCBot.h"
 #include "Building.h"
 #include "Util.h"
+#include "TileSpiral.h"
 
 using namespace CC;
 
+// the number of locally valid candidates the game is asked to confirm, in one placement query
+const size_t PlacementBatchSize = 4;
+
+// the farthest ring of tiles around the desired position that is searched, about a thousand tiles
+const int MaxSearchRadius = 16;
+
 BuildingPlacer::BuildingPlacer(CCBot & bot)
     : m_bot(bot)
+    , m_layout(bot)
 {
 
 }
 
 void BuildingPlacer::onStart()
 {
-    m_reserveMap = std::vector< std::vector<bool> >(m_bot.Map().width(), std::vector<bool>(m_bot.Map().height(), false));
+    const int width  = m_bot.Map().width();
+    const int height = m_bot.Map().height();
+
+    m_reserved.reset(width, height);
+    m_blocked.reset(width, height);
+    m_unbuildable.reset(width, height);
+
+    for (int x = 0; x < width; ++x)
+    {
+        for (int y = 0; y < height; ++y)
+        {
+            m_blocked.set(x, y, m_bot.Map().isBlocked(x, y));
+            m_unbuildable.set(x, y, !m_bot.Map().isBuildable(x, y));
+        }
+    }
+
+    m_blocked.update();
+    m_unbuildable.update();
+
+    m_layout.onStart(m_unbuildable, m_blocked);
+}
+
+// structures placed or removed since the last frame change which tiles are blocked
+void BuildingPlacer::onFrame()
+{
+    const std::vector<CCTilePosition> & changedTiles = m_bot.Map().getChangedTiles();
+    if (changedTiles.empty())
+    {
+        return;
+    }
+
+    for (auto & tile : changedTiles)
+    {
+        m_blocked.set(tile.x, tile.y, m_bot.Map().isBlocked(tile));
+    }
+
+    m_blocked.update();
 }
 
+// mineral lines of every base we hold are kept free, not only the one at our start location
 bool BuildingPlacer::isInResourceBox(int tileX, int tileY) const
 {
-    return m_bot.Bases().getPlayerStartingBaseLocation(Players::Self)->isInResourceBox(tileX, tileY);
+    if (m_bot.Bases().getPlayerStartingBaseLocation(Players::Self)->isInResourceBox(tileX, tileY))
+    {
+        return true;
+    }
+
+    for (const BaseLocation * base : m_bot.Bases().getOccupiedBaseLocations(Players::Self))
+    {
+        if (base->isInResourceBox(tileX, tileY))
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 // makes final checks to see if a building can be built at a certain location
@@ -44,15 +102,12 @@ bool BuildingPlacer::canBuildHere(int bx, int by, const Building & b) const
         endx += xdelta;
     }
 
-    // check the reserve map
-    for (int x = startx; x < endx; x++)
+    // check the reserve map, every tile of the rectangle has to be on the map and unreserved
+    if (startx < endx && starty < endy)
     {
-        for (int y = starty; y < endy; y++)
+        if (startx < 0 || starty < 0 || endx > m_bot.Map().width() || endy > m_bot.Map().height() || m_reserved.any(startx, starty, endx, endy))
         {
-            if (!m_bot.Map().isValidTile(x, y) || m_reserveMap[x][y])
-            {
-                return false;
-            }
+            return false;
         }
     }
 
@@ -104,27 +159,65 @@ bool BuildingPlacer::canBuildHereWithSpace(int bx, int by, const Building & b, i
         return false;
     }
 
-    if (!m_bot.Map().canBuildTypeAtPosition(bx, by, b.type))
+    // the rectangle is on the map, so the only tile check left is whether any of it is reserved, one summed-area lookup
+    if (!b.type.isRefinery() && m_reserved.any(startx, starty, endx, endy))
     {
         return false;
     }
 
-    // if we can't build here, or space is reserved, or it's in the resource box, we can't build here
-    for (int x = startx; x < endx; x++)
+    // the game only confirms the chosen candidates, see getBuildLocationNear
+    return canBuildLocally(bx, by, b.type);
+}
+
+CCTilePosition BuildingPlacer::getLayoutLocation(const Building & b)
+{
+    BaseLayout::SlotSize size;
+    if (!m_layout.getSlotSize(b.type, size))
+    {
+        return CCTilePosition(0, 0);
+    }
+
+    const BaseLocation * base = m_bot.Bases().getBaseLocation(b.desiredPosition.x, b.desiredPosition.y);
+    if (!base || !base->isOccupiedByPlayer(Players::Self))
+    {
+        base = m_bot.Bases().getPlayerStartingBaseLocation(Players::Self);
+    }
+
+    std::vector<CCTilePosition> & slots = m_layout.getSlots(base, size);
+
+    // slots that have been built on are popped for good, the ones reserved for a building in progress or
+    // still waiting for power are skipped and stay for later. only the last few slots are looked at
+    std::vector<CCTilePosition> candidates;
+    for (size_t i = slots.size(); i > 0 && slots.size() - i < 2 * PlacementBatchSize && candidates.size() < PlacementBatchSize; --i)
     {
-        for (int y = starty; y < endy; y++)
+        const CCTilePosition slot = slots[i - 1];
+
+        if (!footprintIsFree(slot.x, slot.y, b.type))
         {
-            if (!b.type.isRefinery())
+            if (i == slots.size())
             {
-                if (!buildable(b, x, y) || m_reserveMap[x][y])
-                {
-                    return false;
-                }
+                slots.pop_back();
             }
+            continue;
+        }
+
+        if (canBuildHere(slot.x, slot.y, b) && canBuildLocally(slot.x, slot.y, b.type))
+        {
+            candidates.push_back(slot);
         }
     }
 
-    return true;
+    std::vector<bool> valid;
+    m_bot.Map().canBuildTypeAtPositions(b.type, candidates, valid);
+    for (size_t i(0); i < candidates.size(); ++i)
+    {
+        if (valid[i])
+        {
+            return candidates[i];
+        }
+    }
+
+    return CCTilePosition(0, 0);
 }
 
 CCTilePosition BuildingPlacer::getBuildLocationNear(const Building & b, int buildDist) const
@@ -137,23 +230,48 @@ CCTilePosition BuildingPlacer::getBuildLocationNear(const Building & b, int buil
     Timer t;
     t.start();
 
-    // get the precomputed vector of tile positions which are sorted closes to this location
-    auto & closestToBuilding = m_bot.Map().getClosestTilesTo(b.desiredPosition);
+    // walk the rings of tiles around the desired position, a few locations that pass our own checks at a time,
+    // on ground connected to the desired position when it is on walkable ground
+    const int desiredSector = m_bot.Map().getSectorNumber(b.desiredPosition.x, b.desiredPosition.y);
+    TileSpiral spiral(b.desiredPosition, MaxSearchRadius, m_bot.Map().width(), m_bot.Map().height());
 
-    double ms1 = t.getElapsedTimeInMilliSec();
-
-    // iterate through the list until we've found a suitable location
-    for (size_t i(0); i < closestToBuilding.size() && i < 1000; ++i)
+    std::vector<CCTilePosition> candidates;
+    std::vector<bool> valid;
+    CCTilePosition pos;
+    bool tilesLeft = true;
+    while (tilesLeft)
     {
-        auto & pos = closestToBuilding[i];
+        candidates.clear();
+        while (candidates.size() < PlacementBatchSize)
+        {
+            if (!spiral.next(pos))
+            {
+                tilesLeft = false;
+                break;
+            }
+
+            if (desiredSector != 0 && m_bot.Map().getSectorNumber(pos.x, pos.y) != desiredSector)
+            {
+                continue;
+            }
 
-        if (canBuildHereWithSpace(pos.x, pos.y, b, buildDist))
+            if (canBuildHereWithSpace(pos.x, pos.y, b, buildDist))
+            {
+                candidates.push_back(pos);
+            }
+        }
+
+        // the game confirms a batch in one query and the closest one it accepts wins. if it rejects them all,
+        // because of units standing there for instance, the search goes on with the next batch
+        m_bot.Map().canBuildTypeAtPositions(b.type, candidates, valid);
+        for (size_t i(0); i < candidates.size(); ++i)
         {
-            double ms = t.getElapsedTimeInMilliSec();
-            //printf("Building Placer Took %d iterations, lasting %lf ms @ %lf iterations/ms, %lf setup ms\n", (int)i, ms, (i / ms), ms1);
-            //std::cout << "build position: " << pos.x << "," << pos.y << std::endl;
-            //std::cout << "width: " << b.type.tileWidth() << ". height: " << b.type.tileHeight() << std::endl;
-            return pos;
+            if (valid[i])
+            {
+                double ms = t.getElapsedTimeInMilliSec();
+                //printf("Building Placer Took %d candidates, lasting %lf ms\n", (int)candidates.size(), ms);
+                return candidates[i];
+            }
         }
     }
 
@@ -209,23 +327,84 @@ bool BuildingPlacer::tileOverlapsBaseLocation(int x, int y, UnitType type) const
     return false;
 }
 
-bool BuildingPlacer::buildable(const Building & b, int x, int y) const
+// the tiles canBuildTypeAtPosition checks the building on, a necessary condition for the game to accept the position
+bool BuildingPlacer::footprintIsFree(int bx, int by, const UnitType & type) const
 {
-    // TODO: does this take units on the map into account?
-    if (!m_bot.Map().isValidTile(x, y))
+#ifdef SC2API
+    const int x0 = bx - type.tileWidth() / 2;
+    const int y0 = by - type.tileHeight() / 2;
+#else
+    const int x0 = bx;
+    const int y0 = by;
+#endif
+    const int x1 = x0 + type.tileWidth();
+    const int y1 = y0 + type.tileHeight();
+
+    if (x0 < 0 || y0 < 0 || x1 > m_bot.Map().width() || y1 > m_bot.Map().height())
     {
         return false;
     }
 
-    // todo: check that it won't block an addon
+    return !m_unbuildable.any(x0, y0, x1, y1) && !m_blocked.any(x0, y0, x1, y1);
+}
 
-    return true;
+// everything the game checks that we can know ourselves: buildable and unoccupied tiles, the mineral line
+// exclusion around depots, creep for zerg and power for protoss. units standing in the way are left to the game
+bool BuildingPlacer::canBuildLocally(int bx, int by, const UnitType & type) const
+{
+    // refineries go on geysers, whose tiles are never buildable
+    if (type.isRefinery())
+    {
+        return true;
+    }
+
+    if (!footprintIsFree(bx, by, type))
+    {
+        return false;
+    }
+
+#ifdef SC2API
+    const int x0 = bx - type.tileWidth() / 2;
+    const int y0 = by - type.tileHeight() / 2;
+    const bool needsCreep = type.getRace() == sc2::Race::Zerg && !type.isResourceDepot();
+    const bool needsPower = type.getRace() == sc2::Race::Protoss && !type.isResourceDepot() && !type.isSupplyProvider();
+#else
+    const int x0 = bx;
+    const int y0 = by;
+    const bool needsCreep = type.getAPIUnitType().requiresCreep();
+    const bool needsPower = false;
+#endif
+
+    for (int x = x0; x < x0 + type.tileWidth(); ++x)
+    {
+        for (int y = y0; y < y0 + type.tileHeight(); ++y)
+        {
+            if (type.isResourceDepot() && !m_bot.Map().isDepotBuildableTile(x, y))
+            {
+                return false;
+            }
+
+            if (needsCreep && !m_bot.Map().hasCreep(x, y))
+            {
+                return false;
+            }
+        }
+    }
+
+#ifndef SC2API
+    if (type.getAPIUnitType().requiresPsi() && !BWAPI::Broodwar->hasPower(BWAPI::TilePosition(bx, by), type.getAPIUnitType()))
+    {
+        return false;
+    }
+#endif
+
+    return !needsPower || m_bot.Map().isPowered(bx, by);
 }
 
 void BuildingPlacer::reserveTiles(int bx, int by, int width, int height)
 {
-    int rwidth = (int)m_reserveMap.size();
-    int rheight = (int)m_reserveMap[0].size();
+    int rwidth = m_bot.Map().width();
+    int rheight = m_bot.Map().height();
 
     int xdelta = (int)std::ceil((width - 1.0) / 2);
     int ydelta = (int)std::ceil((height - 1.0) / 2);
@@ -243,26 +422,30 @@ void BuildingPlacer::reserveTiles(int bx, int by, int width, int height)
     {
         for (int y = starty; y < endy && y < rheight; y++)
         {
-            m_reserveMap[x][y] = true;
+            m_reserved.set(x, y, true);
         }
     }
+
+    m_reserved.update();
 }
 
 void BuildingPlacer::drawReservedTiles()
 {
-    if (!m_bot.Config().DrawReservedBuildingTiles)
+    if (!m_bot.Draw().isEnabled(DebugCategory::ReservedBuildingTiles))
     {
         return;
     }
 
-    int rwidth = (int)m_reserveMap.size();
-    int rheight = (int)m_reserveMap[0].size();
+    m_layout.draw();
+
+    int rwidth = m_bot.Map().width();
+    int rheight = m_bot.Map().height();
 
     for (int x = 0; x < rwidth; ++x)
     {
         for (int y = 0; y < rheight; ++y)
         {
-            if (m_reserveMap[x][y] || isInResourceBox(x, y))
+            if (m_reserved.get(x, y) || isInResourceBox(x, y))
             {
                 m_bot.Map().drawTile(x, y, CCColor(255, 255, 0));
             }
@@ -272,8 +455,8 @@ void BuildingPlacer::drawReservedTiles()
 
 void BuildingPlacer::freeTiles(int bx, int by, int width, int height)
 {
-    int rwidth = (int)m_reserveMap.size();
-    int rheight = (int)m_reserveMap[0].size();
+    int rwidth = m_bot.Map().width();
+    int rheight = m_bot.Map().height();
 
     int xdelta = (int)std::ceil((width - 1.0) / 2);
     int ydelta = (int)std::ceil((height - 1.0) / 2);
@@ -291,9 +474,11 @@ void BuildingPlacer::freeTiles(int bx, int by, int width, int height)
     {
         for (int y = starty; y < endy && y < rheight; y++)
         {
-            m_reserveMap[x][y] = false;
+            m_reserved.set(x, y, false);
         }
     }
+
+    m_reserved.update();
 }
 
 CCTilePosition BuildingPlacer::getRefineryPosition()
@@ -351,13 +536,6 @@ CCTilePosition BuildingPlacer::getRefineryPosition()
 
 bool BuildingPlacer::isReserved(int x, int y) const
 {
-    int rwidth = (int)m_reserveMap.size();
-    int rheight = (int)m_reserveMap[0].size();
-    if (x < 0 || y < 0 || x >= rwidth || y >= rheight)
-    {
-        return false;
-    }
-
-    return m_reserveMap[x][y];
+    return m_reserved.get(x, y);
 }
 
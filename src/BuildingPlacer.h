@@ -2,6 +2,8 @@
 
 #include "Common.h"
 #include "BuildingData.h"
+#include "SummedAreaTable.h"
+#include "BaseLayout.h"
 
 namespace CC
 {
@@ -12,10 +14,16 @@ namespace CC
     {
         CCBot & m_bot;
 
-        std::vector< std::vector<bool> > m_reserveMap;
+        // integral images of the tiles a building can't go on, so every footprint test is a few lookups
+        SummedAreaTable m_reserved;         // tiles reserved for buildings we are about to place
+        SummedAreaTable m_blocked;          // tiles covered by structures
+        SummedAreaTable m_unbuildable;      // tiles the terrain or static resources don't allow building on
+
+        BaseLayout      m_layout;           // building slots planned around every base at game start
 
         // queries for various BuildingPlacer data
-        bool buildable(const Building & b, int x, int y) const;
+        bool footprintIsFree(int bx, int by, const UnitType & type) const;
+        bool canBuildLocally(int bx, int by, const UnitType & type) const;
         bool isInResourceBox(int x, int y) const;
         bool tileOverlapsBaseLocation(int x, int y, UnitType type) const;
 
@@ -25,14 +33,18 @@ namespace CC
         BuildingPlacer(CCBot & bot);
 
         void onStart();
+        void onFrame();
 
         bool isReserved(int x, int y) const;
 
-        // determines whether we can build at a given location
+        // determines whether we can build at a given location, as far as we can tell without asking the game
         bool canBuildHere(int bx, int by, const Building & b) const;
         bool canBuildHereWithSpace(int bx, int by, const Building & b, int buildDist) const;
 
-        // returns a build location near a building's desired location
+        // returns the closest free slot the layout planned for the building at the base of its desired location, (0, 0) if there is none
+        CCTilePosition getLayoutLocation(const Building & b);
+
+        // returns a build location near a building's desired location, only the best few candidates are confirmed by the game
         CCTilePosition getBuildLocationNear(const Building & b, int buildDist) const;
 
         void drawReservedTiles();
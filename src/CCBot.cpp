@@ -10,7 +10,11 @@ CCBot::CCBot()
     , m_workers(*this)
     , m_gameCommander(*this)
     , m_strategy(*this)
+    , m_debugDraw(*this)
     , m_techTree(*this)
+#ifdef SC2API
+    , m_standIn(nullptr)
+#endif
 {
     
 }
@@ -18,6 +22,7 @@ CCBot::CCBot()
 void CCBot::OnGameStart() 
 {
     m_config.readConfigFile();
+    m_debugDraw.onStart();
 
     // add all the possible start locations on the map
 #ifdef SC2API
@@ -59,6 +64,46 @@ void CCBot::OnGameStart()
     m_startTime = std::chrono::system_clock::now();
 }
 
+#ifdef SC2API
+// runs the map analysis part of OnGameStart on an observation made up without a game, for benchmarks
+void CCBot::OnStandInGameStart(const StandInObservation & observation)
+{
+    m_standIn = &observation;
+
+    m_baseLocations = observation.gameInfo.enemy_start_locations;
+    m_baseLocations.push_back(observation.startLocation);
+
+    setUnits();
+    m_map.onStart();
+    m_unitInfo.onStart();
+    m_bases.onStart();
+}
+
+const StandInObservation * CCBot::GetStandInObservation() const
+{
+    return m_standIn;
+}
+
+const sc2::GameInfo & CCBot::GetGameInfo() const
+{
+    return m_standIn ? m_standIn->gameInfo : Observation()->GetGameInfo();
+}
+#endif
+
+void CCBot::SetStartupStageCallback(const std::function<void(const std::string &)> & callback)
+{
+    m_startupStageCallback = callback;
+}
+
+// marks the end of one stage of the game start analysis, so benchmarks can measure each stage on its own
+void CCBot::OnStartupStage(const std::string & stage) const
+{
+    if (m_startupStageCallback)
+    {
+        m_startupStageCallback(stage);
+    }
+}
+
 void CCBot::OnStep()
 {
     if (GetCurrentFrame() % 25 == 0)
@@ -81,15 +126,22 @@ void CCBot::OnStep()
     m_strategy.onFrame();
     m_gameCommander.onFrame();
 
-#ifdef SC2API
-    Debug()->SendDebug();
-#endif
+    m_debugDraw.flush();
 }
 
 void CCBot::setUnits()
 {
     m_allUnits.clear();
 #ifdef SC2API
+    if (m_standIn)
+    {
+        for (auto & unit : m_standIn->units)
+        {
+            m_allUnits.push_back(Unit(&unit, *this));
+        }
+        return;
+    }
+
     Control()->GetObservation();
     for (auto & unit : Observation()->GetUnits())
     {
@@ -106,6 +158,11 @@ void CCBot::setUnits()
 CCRace CCBot::GetPlayerRace(int player) const
 {
 #ifdef SC2API
+    if (m_standIn)
+    {
+        return m_standIn->race;
+    }
+
     auto playerID = Observation()->GetPlayerID();
     for (auto & playerInfo : Observation()->GetGameInfo().player_info)
     {
@@ -159,6 +216,11 @@ BotConfig & CCBot::Config()
      return m_config;
 }
 
+DebugDraw & CCBot::Draw()
+{
+    return m_debugDraw;
+}
+
 const MapTools & CCBot::Map() const
 {
     return m_map;
@@ -259,6 +321,25 @@ int CCBot::GetGas() const
 #endif
 }
 
+// everything gathered since the game started, spending doesn't lower it
+int CCBot::GetCollectedMinerals() const
+{
+#ifdef SC2API
+    return (int)Observation()->GetScore().score_details.collected_minerals;
+#else
+    return BWAPI::Broodwar->self()->gatheredMinerals();
+#endif
+}
+
+int CCBot::GetCollectedGas() const
+{
+#ifdef SC2API
+    return (int)Observation()->GetScore().score_details.collected_vespene;
+#else
+    return BWAPI::Broodwar->self()->gatheredGas();
+#endif
+}
+
 Unit CCBot::GetUnit(const CCUnitID & tag) const
 {
 #ifdef SC2API
@@ -285,6 +366,11 @@ const std::string & CCBot::getName(sc2::UnitTypeID type) const
 CCPosition CCBot::GetStartLocation() const
 {
 #ifdef SC2API
+    if (m_standIn)
+    {
+        return m_standIn->startLocation;
+    }
+
     return Observation()->GetStartLocation();
 #else
     return BWAPI::Position(BWAPI::Broodwar->self()->getStartLocation());
@@ -1,18 +1,21 @@
 #pragma once
 
 #include "Common.h"
+#include <functional>
 
 #include "MapTools.h"
 #include "BaseLocationManager.h"
 #include "UnitInfoManager.h"
 #include "WorkerManager.h"
 #include "BotConfig.h"
+#include "DebugDraw.h"
 #include "GameCommander.h"
 #include "BuildingManager.h"
 #include "StrategyManager.h"
 #include "TechTree.h"
 #include "MetaType.h"
 #include "Unit.h"
+#include "StandInObservation.h"
 
 namespace CC
 {
@@ -28,6 +31,7 @@ namespace CC
         WorkerManager           m_workers;
         StrategyManager         m_strategy;
         BotConfig               m_config;
+        DebugDraw               m_debugDraw;
         TechTree                m_techTree;
         GameCommander           m_gameCommander;
 
@@ -36,6 +40,11 @@ namespace CC
         std::chrono::time_point<std::chrono::system_clock> m_startTime;
         double                  m_framesPerSecond;
 
+#ifdef SC2API
+        const StandInObservation *                  m_standIn;
+#endif
+        std::function<void(const std::string &)>    m_startupStageCallback;
+
         void setUnits();
 
 #ifdef SC2API
@@ -50,12 +59,16 @@ namespace CC
 #ifdef SC2API
         void OnGameStart() override;
         void OnStep() override;
+        void OnStandInGameStart(const StandInObservation & observation);
+        const StandInObservation * GetStandInObservation() const;
+        const sc2::GameInfo & GetGameInfo() const;
 #else
         void OnGameStart();
         void OnStep();
 #endif
 
         BotConfig & Config();
+        DebugDraw & Draw();
         WorkerManager & Workers();
         const BaseLocationManager & Bases() const;
         const MapTools & Map() const;
@@ -70,12 +83,17 @@ namespace CC
         std::string GetPlayerRaceName(int player) const;
         CCPosition GetStartLocation() const;
 
+        void SetStartupStageCallback(const std::function<void(const std::string &)> & callback);
+        void OnStartupStage(const std::string & stage) const;
+
         int GetCurrentFrame() const;
         double GetFramesPerSecond() const;
         int GetMinerals() const;
         int GetCurrentSupply() const;
         int GetMaxSupply() const;
         int GetGas() const;
+        int GetCollectedMinerals() const;
+        int GetCollectedGas() const;
         Unit GetUnit(const CCUnitID & tag) const;
         const std::vector<Unit> & GetUnits() const;
         const std::string & getName(sc2::UnitTypeID type) const;
@@ -10,11 +10,23 @@ const size_t BaseDefensePriority = 2;
 const size_t ScoutDefensePriority = 3;
 const size_t DropPriority = 4;
 
+// enemies closer than this to one of our bases, and closer to it than to any enemy base, are defended against
+const int BaseDefenseTileDistance = 20;
+
+// exploring, the army looks for tiles within this many tiles of it that haven't been seen for at least ExploreStaleFrames
+const float ExploreTileRadius = 40.0f;
+const int   ExploreStaleFrames = 1344;
+
+// how many of those tiles are ranked by coarse ground distance, and how many of the closest are measured exactly
+const size_t ExploreCandidates = 16;
+const size_t ExploreRefine = 3;
+
 CombatCommander::CombatCommander(CCBot & bot)
     : m_bot(bot)
     , m_squadData(bot)
     , m_initialized(false)
     , m_attackStarted(false)
+    , m_exploreTile(-1, -1)
 {
 
 }
@@ -206,6 +218,24 @@ void CombatCommander::updateScoutDefenseSquad()
 
 void CombatCommander::updateDefenseSquads()
 {
+    // sort the enemy units by which of our bases' territory they are in
+    const TerritoryMap & territory = m_bot.Bases().getTerritoryMap();
+    std::map<const BaseLocation *, std::vector<Unit>> enemyUnitsByBase;
+    for (auto & unit : m_bot.UnitInfo().getUnits(Players::Enemy))
+    {
+        // if it's an overlord, don't worry about it for defense, we don't care what they see
+        if (unit.getType().isOverlord())
+        {
+            continue;
+        }
+
+        int distance = territory.getDistance(unit.getPosition());
+        if (territory.getOwner(unit.getPosition()) == Players::Self && distance != -1 && distance < BaseDefenseTileDistance)
+        {
+            enemyUnitsByBase[territory.getClosestBase(unit.getPosition())].push_back(unit);
+        }
+    }
+
     // for each of our occupied regions
     const BaseLocation * enemyBaseLocation = m_bot.Bases().getPlayerStartingBaseLocation(Players::Enemy);
     for (const BaseLocation * myBaseLocation : m_bot.Bases().getOccupiedBaseLocations(Players::Self))
@@ -222,20 +252,7 @@ void CombatCommander::updateDefenseSquads()
         int numDefendersPerEnemyUnit = 2;
 
         // all of the enemy units in this region
-        std::vector<Unit> enemyUnitsInRegion;
-        for (auto & unit : m_bot.UnitInfo().getUnits(Players::Enemy))
-        {
-            // if it's an overlord, don't worry about it for defense, we don't care what they see
-            if (unit.getType().isOverlord())
-            {
-                continue;
-            }
-
-            if (myBaseLocation->containsPosition(unit.getPosition()))
-            {
-                enemyUnitsInRegion.push_back(unit);
-            }
-        }
+        std::vector<Unit> enemyUnitsInRegion = enemyUnitsByBase[myBaseLocation];
 
         // we can ignore the first enemy worker in our region since we assume it is a scout
         for (auto unit : enemyUnitsInRegion)
@@ -481,7 +498,36 @@ CCPosition CombatCommander::getMainAttackLocation()
     }
 
     // Fourth choice: We can't see anything so explore the map attacking along the way
-    return Util::GetPosition(m_bot.Map().getLeastRecentlySeenTile());
+    return getExploreLocation();
+}
+
+// the stale tiles near the army are found on the coarse cells of the last-seen pyramid, and the closest of them by
+// ground is explored. the tile is kept until we see it, so the squad keeps walking the same flow field
+CCPosition CombatCommander::getExploreLocation()
+{
+    const MapTools & map = m_bot.Map();
+    if (map.isValidTile(m_exploreTile) && !map.isVisible(m_exploreTile.x, m_exploreTile.y))
+    {
+        return Util::GetPosition(m_exploreTile);
+    }
+
+    const Squad & mainAttackSquad = m_squadData.getSquad("MainAttack");
+    const CCPosition from = mainAttackSquad.isEmpty() ? m_bot.GetStartLocation() : mainAttackSquad.calcCenter();
+
+    std::vector<CCTilePosition> tiles;
+    map.getLastSeenPyramid().getBestTiles(from, Util::TileToPosition(ExploreTileRadius), ExploreCandidates, false, m_bot.GetCurrentFrame() - ExploreStaleFrames, tiles);
+
+    std::vector<CCPosition> candidates;
+    for (auto & tile : tiles)
+    {
+        candidates.push_back(Util::GetPosition(tile));
+    }
+
+    map.sortByGroundDistance(from, candidates, ExploreRefine);
+
+    // nothing near the army is stale, so head for the tile seen longest ago anywhere
+    m_exploreTile = candidates.empty() ? map.getLeastRecentlySeenTile() : Util::GetTilePosition(candidates.front());
+    return Util::GetPosition(m_exploreTile);
 }
 
 Unit CombatCommander::findClosestWorkerTo(std::vector<Unit> & unitsToAssign, const CCPosition & target)
@@ -16,6 +16,7 @@ namespace CC
         std::vector<Unit>  m_combatUnits;
         bool            m_initialized;
         bool            m_attackStarted;
+        CCTilePosition  m_exploreTile;      // the tile the main attack squad explores toward, kept until it is seen
 
         void            updateScoutDefenseSquad();
         void            updateDefenseSquads();
@@ -27,6 +28,7 @@ namespace CC
         Unit            findClosestWorkerTo(std::vector<Unit> & unitsToAssign, const CCPosition & target);
 
         CCPosition      getMainAttackLocation();
+        CCPosition      getExploreLocation();
 
         void            updateDefenseSquadUnits(Squad & defenseSquad, const size_t & flyingDefendersNeeded, const size_t & groundDefendersNeeded);
         bool            shouldWeStartAttacking();
@@ -0,0 +1,115 @@
+#include "DebugDraw.h"
+#include "CCBot.h"
+
+using namespace CC;
+
+DebugDraw::DebugDraw(CCBot & bot)
+    : m_bot             (bot)
+    , m_sentLastFrame   (true)  // the first flush always sends, which also delivers debug commands queued before the game
+{
+    m_enabled.fill(false);
+}
+
+void DebugDraw::onStart()
+{
+    const BotConfig & config = m_bot.Config();
+
+    setEnabled(DebugCategory::GameInfo,              config.DrawGameInfo);
+    setEnabled(DebugCategory::TileInfo,              config.DrawTileInfo);
+    setEnabled(DebugCategory::BaseLocationInfo,      config.DrawBaseLocationInfo);
+    setEnabled(DebugCategory::WalkableSectors,       config.DrawWalkableSectors);
+    setEnabled(DebugCategory::ResourceInfo,          config.DrawResourceInfo);
+    setEnabled(DebugCategory::ProductionInfo,        config.DrawProductionInfo);
+    setEnabled(DebugCategory::ScoutInfo,             config.DrawScoutInfo);
+    setEnabled(DebugCategory::WorkerInfo,            config.DrawWorkerInfo);
+    setEnabled(DebugCategory::ModuleTimers,          config.DrawModuleTimers);
+    setEnabled(DebugCategory::ReservedBuildingTiles, config.DrawReservedBuildingTiles);
+    setEnabled(DebugCategory::BuildingInfo,          config.DrawBuildingInfo);
+    setEnabled(DebugCategory::EnemyUnitInfo,         config.DrawEnemyUnitInfo);
+    setEnabled(DebugCategory::LastSeenTileInfo,      config.DrawLastSeenTileInfo);
+    setEnabled(DebugCategory::UnitTargetInfo,        config.DrawUnitTargetInfo);
+    setEnabled(DebugCategory::SquadInfo,             config.DrawSquadInfo);
+    setEnabled(DebugCategory::BOSSInfo,              config.DrawBOSSInfo);
+}
+
+void DebugDraw::setEnabled(int category, bool enabled)
+{
+    BOT_ASSERT(category >= 0 && category < DebugCategory::Size, "Invalid debug draw category: %d", category);
+    m_enabled[category] = enabled;
+}
+
+void DebugDraw::line(const CCPosition & p1, float z1, const CCPosition & p2, float z2, const CCColor & color)
+{
+#if CC_DEBUG_DRAW
+    m_commands.push_back({ Shape::Line, p1, p2, z1, z2, 0.0f, color, std::string() });
+#endif
+}
+
+void DebugDraw::box(const CCPosition & p1, float z1, const CCPosition & p2, float z2, const CCColor & color)
+{
+#if CC_DEBUG_DRAW
+    m_commands.push_back({ Shape::Box, p1, p2, z1, z2, 0.0f, color, std::string() });
+#endif
+}
+
+void DebugDraw::sphere(const CCPosition & pos, float z, float radius, const CCColor & color)
+{
+#if CC_DEBUG_DRAW
+    m_commands.push_back({ Shape::Sphere, pos, pos, z, z, radius, color, std::string() });
+#endif
+}
+
+void DebugDraw::text(const CCPosition & pos, float z, const std::string & str, const CCColor & color)
+{
+#if CC_DEBUG_DRAW
+    m_commands.push_back({ Shape::Text, pos, pos, z, z, 0.0f, color, str });
+#endif
+}
+
+void DebugDraw::textScreen(const CCPosition & pos, const std::string & str, const CCColor & color)
+{
+#if CC_DEBUG_DRAW
+    m_commands.push_back({ Shape::TextScreen, pos, pos, 0.0f, 0.0f, 0.0f, color, str });
+#endif
+}
+
+// hands every buffered primitive to the game at once, and skips the round-trip entirely on frames
+// where nothing was drawn and nothing from the previous frame needs to be cleared off the screen
+void DebugDraw::flush()
+{
+    if (m_commands.empty() && !m_sentLastFrame)
+    {
+        return;
+    }
+
+#ifdef SC2API
+    sc2::DebugInterface * debug = m_bot.Debug();
+    for (auto & c : m_commands)
+    {
+        switch (c.shape)
+        {
+            case Shape::Line:       debug->DebugLineOut(sc2::Point3D(c.p1.x, c.p1.y, c.z1), sc2::Point3D(c.p2.x, c.p2.y, c.z2), c.color); break;
+            case Shape::Box:        debug->DebugBoxOut(sc2::Point3D(c.p1.x, c.p1.y, c.z1), sc2::Point3D(c.p2.x, c.p2.y, c.z2), c.color); break;
+            case Shape::Sphere:     debug->DebugSphereOut(sc2::Point3D(c.p1.x, c.p1.y, c.z1), c.radius, c.color); break;
+            case Shape::Text:       debug->DebugTextOut(c.text, sc2::Point3D(c.p1.x, c.p1.y, c.z1), c.color); break;
+            case Shape::TextScreen: debug->DebugTextOut(c.text, c.p1, c.color); break;
+        }
+    }
+    debug->SendDebug();
+#else
+    for (auto & c : m_commands)
+    {
+        switch (c.shape)
+        {
+            case Shape::Line:       BWAPI::Broodwar->drawLineMap(c.p1, c.p2, c.color); break;
+            case Shape::Box:        BWAPI::Broodwar->drawBoxMap(c.p1, c.p2, c.color); break;
+            case Shape::Sphere:     BWAPI::Broodwar->drawCircleMap(c.p1, (int)c.radius, c.color); break;
+            case Shape::Text:       BWAPI::Broodwar->drawTextMap(c.p1, c.text.c_str()); break;
+            case Shape::TextScreen: BWAPI::Broodwar->drawTextScreen(c.p1, c.text.c_str()); break;
+        }
+    }
+#endif
+
+    m_sentLastFrame = !m_commands.empty();
+    m_commands.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Common.h"
+
+// Ladder builds define CC_DEBUG_DRAW=0 (cmake -DCC_LADDER_BUILD=ON), which makes every category
+// report disabled at compile time so the formatting code behind an isEnabled() check is dropped
+#ifndef CC_DEBUG_DRAW
+#define CC_DEBUG_DRAW 1
+#endif
+
+namespace CC
+{
+    class CCBot;
+
+    namespace DebugCategory
+    {
+        enum { GameInfo, TileInfo, BaseLocationInfo, WalkableSectors, ResourceInfo, ProductionInfo, ScoutInfo, WorkerInfo,
+               ModuleTimers, ReservedBuildingTiles, BuildingInfo, EnemyUnitInfo, LastSeenTileInfo, UnitTargetInfo,
+               SquadInfo, BOSSInfo, Size };
+    }
+
+    // Buffers every debug primitive drawn during a frame and hands them to the game in one batch at the
+    // end of the frame. Each category is toggled at runtime by the matching Draw* flag in the config.
+    class DebugDraw
+    {
+        enum class Shape { Line, Box, Sphere, Text, TextScreen };
+
+        struct Command
+        {
+            Shape       shape;
+            CCPosition  p1;
+            CCPosition  p2;
+            float       z1;
+            float       z2;
+            float       radius;
+            CCColor     color;
+            std::string text;
+        };
+
+        CCBot &                                 m_bot;
+        std::array<bool, DebugCategory::Size>   m_enabled;
+        std::vector<Command>                    m_commands;     // cleared every flush, its capacity is kept
+        bool                                    m_sentLastFrame;
+
+    public:
+
+        DebugDraw(CCBot & bot);
+
+        void    onStart();
+        void    flush();
+
+#if CC_DEBUG_DRAW
+        bool    isEnabled(int category) const { return m_enabled[category]; }
+#else
+        bool    isEnabled(int) const { return false; }
+#endif
+        void    setEnabled(int category, bool enabled);
+
+        void    line(const CCPosition & p1, float z1, const CCPosition & p2, float z2, const CCColor & color);
+        void    box(const CCPosition & p1, float z1, const CCPosition & p2, float z2, const CCColor & color);
+        void    sphere(const CCPosition & pos, float z, float radius, const CCColor & color);
+        void    text(const CCPosition & pos, float z, const std::string & str, const CCColor & color);
+        void    textScreen(const CCPosition & pos, const std::string & str, const CCColor & color);
+    };
+}
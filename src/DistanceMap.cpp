@@ -1,6 +1,8 @@
 #include "DistanceMap.h"
 #include "CCBot.h"
 #include "Util.h"
+#include <queue>
+#include <algorithm>
 
 using namespace CC;
 
@@ -8,15 +10,203 @@ const size_t LegalActions = 4;
 const int actionX[LegalActions] = {1, -1, 0, 0};
 const int actionY[LegalActions] = {0, 0, 1, -1};
 
+namespace
+{
+    // structures block walking through them, but their tiles can still be reached so that distances to buildings exist:
+    // a step may always enter a structure tile, but only continues inside that structure or out of the one the map starts in
+    bool CanStep(const MapTools & map, const CCTilePosition & from, const CCTilePosition & to, int startStructure)
+    {
+        if (!map.isValidTile(to))
+        {
+            return false;
+        }
+
+        const int toStructure = map.getStructureAt(to.x, to.y);
+        if (toStructure == 0 && !map.isWalkable(to))
+        {
+            return false;
+        }
+
+        const int fromStructure = map.getStructureAt(from.x, from.y);
+        return fromStructure == 0 || fromStructure == startStructure || fromStructure == toStructure;
+    }
+}
+
+TileList::TileList(const CCTilePosition * tiles, size_t size)
+    : m_tiles(tiles)
+    , m_size(size)
+{
+
+}
+
+const CCTilePosition * TileList::begin() const
+{
+    return m_tiles;
+}
+
+const CCTilePosition * TileList::end() const
+{
+    return m_tiles + m_size;
+}
+
+const CCTilePosition & TileList::operator [] (size_t i) const
+{
+    return m_tiles[i];
+}
+
+size_t TileList::size() const
+{
+    return m_size;
+}
+
+bool TileList::empty() const
+{
+    return m_size == 0;
+}
+
 DistanceMap::DistanceMap() 
+    : m_width(0)
+    , m_height(0)
+    , m_startStructure(0)
+    , m_dist(nullptr)
+    , m_sortedTiles(nullptr)
+    , m_numSortedTiles(0)
 {
     
 }
 
+DistanceMap::DistanceMap(const DistanceMap & rhs)
+{
+    *this = rhs;
+}
+
+DistanceMap & DistanceMap::operator = (const DistanceMap & rhs)
+{
+    if (this == &rhs)
+    {
+        return *this;
+    }
+
+    m_width             = rhs.m_width;
+    m_height            = rhs.m_height;
+    m_startTile         = rhs.m_startTile;
+    m_startStructure    = rhs.m_startStructure;
+    m_distStorage       = rhs.m_distStorage;
+    m_sortedTileStorage = rhs.m_sortedTileStorage;
+
+    // data owned by rhs has been copied so we point at our own copy, data loaded from the cache is shared
+    if (rhs.m_dist == rhs.m_distStorage.data())
+    {
+        bindStorage();
+    }
+    else
+    {
+        m_dist           = rhs.m_dist;
+        m_sortedTiles    = rhs.m_sortedTiles;
+        m_numSortedTiles = rhs.m_numSortedTiles;
+    }
+
+    return *this;
+}
+
+DistanceMap::DistanceMap(DistanceMap && rhs)
+{
+    *this = std::move(rhs);
+}
+
+DistanceMap & DistanceMap::operator = (DistanceMap && rhs)
+{
+    if (this == &rhs)
+    {
+        return *this;
+    }
+
+    const bool ownsData = rhs.m_dist == rhs.m_distStorage.data();
+
+    m_width             = rhs.m_width;
+    m_height            = rhs.m_height;
+    m_startTile         = rhs.m_startTile;
+    m_startStructure    = rhs.m_startStructure;
+    m_dist              = rhs.m_dist;
+    m_sortedTiles       = rhs.m_sortedTiles;
+    m_numSortedTiles    = rhs.m_numSortedTiles;
+    m_distStorage       = std::move(rhs.m_distStorage);
+    m_sortedTileStorage = std::move(rhs.m_sortedTileStorage);
+
+    if (ownsData)
+    {
+        bindStorage();
+    }
+
+    rhs.m_dist           = nullptr;
+    rhs.m_sortedTiles    = nullptr;
+    rhs.m_numSortedTiles = 0;
+    rhs.m_distStorage.clear();
+    rhs.m_sortedTileStorage.clear();
+
+    return *this;
+}
+
+void DistanceMap::bindStorage()
+{
+    m_dist           = m_distStorage.data();
+    m_sortedTiles    = m_sortedTileStorage.data();
+    m_numSortedTiles = m_sortedTileStorage.size();
+}
+
+// copies data viewed from the map cache into our own storage, so that it can be changed
+void DistanceMap::materialize()
+{
+    if (m_dist == m_distStorage.data())
+    {
+        return;
+    }
+
+    m_distStorage.assign(m_dist, m_dist + m_width * m_height);
+    m_sortedTileStorage.assign(m_sortedTiles, m_sortedTiles + m_numSortedTiles);
+    bindStorage();
+}
+
+// rebuilds the sorted tile list from the distances with a counting sort, ties are in row-major order
+void DistanceMap::sortTiles()
+{
+    int maxDist = -1;
+    for (int d : m_distStorage)
+    {
+        maxDist = std::max(maxDist, d);
+    }
+
+    std::vector<size_t> offsets(maxDist + 2, 0);
+    for (int d : m_distStorage)
+    {
+        if (d != -1) { offsets[d + 1]++; }
+    }
+
+    for (size_t d(1); d < offsets.size(); ++d)
+    {
+        offsets[d] += offsets[d - 1];
+    }
+
+    m_sortedTileStorage.resize(offsets.back());
+    for (int y(0); y < m_height; ++y)
+    {
+        for (int x(0); x < m_width; ++x)
+        {
+            int d = m_distStorage[y * m_width + x];
+            if (d != -1)
+            {
+                m_sortedTileStorage[offsets[d]++] = CCTilePosition(x, y);
+            }
+        }
+    }
+
+    bindStorage();
+}
+
 int DistanceMap::getDistance(int tileX, int tileY) const
 { 
     BOT_ASSERT(tileX < m_width && tileY < m_height, "Index out of range: X = %d, Y = %d", tileX, tileY);
-    return m_dist[tileX][tileY]; 
+    return m_dist[tileY * m_width + tileX]; 
 }
 
 int DistanceMap::getDistance(const CCTilePosition & pos) const
@@ -33,53 +223,252 @@ int DistanceMap::getDistance(const CCPosition & pos) const
 #endif
 }
 
-const std::vector<CCTilePosition> & DistanceMap::getSortedTiles() const
+TileList DistanceMap::getSortedTiles() const
 {
-    return m_sortedTiles;
+    return TileList(m_sortedTiles, m_numSortedTiles);
 }
 
-// Computes m_dist[x][y] = ground distance from (startX, startY) to (x,y)
+// Computes m_dist[y*width + x] = ground distance from (startX, startY) to (x,y)
 // Uses BFS, since the map is quite large and DFS may cause a stack overflow
 void DistanceMap::computeDistanceMap(CCBot & m_bot, const CCTilePosition & startTile)
 {
+    const MapTools & map = m_bot.Map();
+
     m_startTile = startTile;
-    m_width = m_bot.Map().width();
-    m_height = m_bot.Map().height();
-    m_dist = std::vector<std::vector<int>>(m_width, std::vector<int>(m_height, -1));
-    m_sortedTiles.reserve(m_width * m_height);
+    m_startStructure = map.getStructureAt(startTile.x, startTile.y);
+    m_width = map.width();
+    m_height = map.height();
+    m_distStorage.assign(m_width * m_height, -1);
+    m_sortedTileStorage.clear();
+    m_sortedTileStorage.reserve(m_width * m_height);
 
-    // the fringe for the BFS we will perform to calculate distances
-    std::vector<CCTilePosition> fringe;
-    fringe.reserve(m_width * m_height);
-    fringe.push_back(startTile);
-    m_sortedTiles.push_back(startTile);
+    // the sorted tiles are exactly the fringe of the BFS, so they are used as the fringe directly
+    // the storage was reserved for every tile, so pushing onto it never reallocates
+    m_sortedTileStorage.push_back(startTile);
 
-    m_dist[(int)startTile.x][(int)startTile.y] = 0;
+    m_dist = m_distStorage.data();
+    m_distStorage[startTile.y * m_width + startTile.x] = 0;
 
-    for (size_t fringeIndex=0; fringeIndex<fringe.size(); ++fringeIndex)
+    for (size_t fringeIndex=0; fringeIndex<m_sortedTileStorage.size(); ++fringeIndex)
     {
-        auto & tile = fringe[fringeIndex];
+        const CCTilePosition tile = m_sortedTileStorage[fringeIndex];
 
         // check every possible child of this tile
         for (size_t a=0; a<LegalActions; ++a)
         {
             CCTilePosition nextTile(tile.x + actionX[a], tile.y + actionY[a]);
 
-            // if the new tile is inside the map bounds, is walkable, and has not been visited yet, set the distance of its parent + 1
-            if (m_bot.Map().isWalkable(nextTile) && getDistance(nextTile) == -1)
+            // if the new tile can be stepped on from this one and has not been visited yet, set the distance of its parent + 1
+            if (CanStep(map, tile, nextTile, m_startStructure) && getDistance(nextTile) == -1)
+            {
+                m_distStorage[nextTile.y * m_width + nextTile.x] = m_distStorage[tile.y * m_width + tile.x] + 1;
+                m_sortedTileStorage.push_back(nextTile);
+            }
+        }
+    }
+
+    bindStorage();
+}
+
+void DistanceMap::loadDistanceMap(const CCTilePosition & startTile, int width, int height, const int * dist, const CCTilePosition * sortedTiles, size_t numSortedTiles)
+{
+    m_startTile      = startTile;
+    m_startStructure = 0;
+    m_width          = width;
+    m_height         = height;
+    m_dist           = dist;
+    m_sortedTiles    = sortedTiles;
+    m_numSortedTiles = numSortedTiles;
+
+    m_distStorage.clear();
+    m_sortedTileStorage.clear();
+}
+
+bool DistanceMap::crosses(const std::vector<CCTilePosition> & changedTiles) const
+{
+    if (m_dist == nullptr)
+    {
+        return false;
+    }
+
+    // a blocked tile matters if a path reached it, an opened one if a path reached one of its neighbours
+    for (auto & tile : changedTiles)
+    {
+        if (getDistance(tile) != -1)
+        {
+            return true;
+        }
+
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            int x = tile.x + actionX[a];
+            int y = tile.y + actionY[a];
+            if (x >= 0 && y >= 0 && x < m_width && y < m_height && getDistance(x, y) != -1)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool DistanceMap::repair(CCBot & bot, const std::vector<CCTilePosition> & changedTiles)
+{
+    if (!crosses(changedTiles))
+    {
+        return false;
+    }
+
+    const MapTools & map = bot.Map();
+
+    // a structure placed on or removed from the start tile changes where every path leaves from
+    if (map.getStructureAt(m_startTile.x, m_startTile.y) != m_startStructure)
+    {
+        computeDistanceMap(bot, m_startTile);
+        return true;
+    }
+
+    materialize();
+    int * dist = m_distStorage.data();
+
+    typedef std::pair<int, int> Entry;
+    typedef std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Queue;
+
+    auto pushReached = [&](Queue & queue, int x, int y)
+    {
+        if (x >= 0 && y >= 0 && x < m_width && y < m_height && dist[y * m_width + x] != -1)
+        {
+            queue.push(Entry(dist[y * m_width + x], y * m_width + x));
+        }
+    };
+
+    // find the tiles that lost their shortest path: a tile keeps its distance if a neighbour one step closer
+    // still leads to it. tiles are checked closest first, so every possible parent has been checked already
+    enum { Unchecked, Supported, Lost };
+    std::vector<uint8_t> state(m_width * m_height, Unchecked);
+    std::vector<int> lost;
+    Queue check;
+
+    for (auto & tile : changedTiles)
+    {
+        pushReached(check, tile.x, tile.y);
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            pushReached(check, tile.x + actionX[a], tile.y + actionY[a]);
+        }
+    }
+
+    const int startIndex = m_startTile.y * m_width + m_startTile.x;
+    while (!check.empty())
+    {
+        const int index = check.top().second;
+        check.pop();
+
+        if (state[index] != Unchecked) { continue; }
+
+        const CCTilePosition tile(index % m_width, index / m_width);
+        const int d = dist[index];
+
+        bool supported = index == startIndex;
+        for (size_t a=0; a<LegalActions && !supported; ++a)
+        {
+            const CCTilePosition parent(tile.x + actionX[a], tile.y + actionY[a]);
+            if (!map.isValidTile(parent)) { continue; }
+
+            const int p = parent.y * m_width + parent.x;
+            supported = dist[p] == d - 1 && state[p] != Lost && CanStep(map, parent, tile, m_startStructure);
+        }
+
+        if (supported)
+        {
+            state[index] = Supported;
+            continue;
+        }
+
+        state[index] = Lost;
+        lost.push_back(index);
+
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            const int cx = tile.x + actionX[a];
+            const int cy = tile.y + actionY[a];
+            if (map.isValidTile(cx, cy) && dist[cy * m_width + cx] == d + 1)
             {
-                m_dist[(int)nextTile.x][(int)nextTile.y] = m_dist[(int)tile.x][(int)tile.y] + 1;
-                fringe.push_back(nextTile);
-                m_sortedTiles.push_back(nextTile);
+                check.push(Entry(d + 1, cy * m_width + cx));
             }
         }
     }
+
+    // lost tiles start over from their best remaining neighbour
+    Queue open;
+    for (int index : lost)
+    {
+        dist[index] = -1;
+    }
+
+    for (int index : lost)
+    {
+        const CCTilePosition tile(index % m_width, index / m_width);
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            const CCTilePosition parent(tile.x + actionX[a], tile.y + actionY[a]);
+            if (!map.isValidTile(parent)) { continue; }
+
+            const int p = parent.y * m_width + parent.x;
+            if (dist[p] != -1 && (dist[index] == -1 || dist[p] + 1 < dist[index]) && CanStep(map, parent, tile, m_startStructure))
+            {
+                dist[index] = dist[p] + 1;
+            }
+        }
+
+        if (dist[index] != -1)
+        {
+            open.push(Entry(dist[index], index));
+        }
+    }
+
+    // opened tiles may give their neighbours shorter paths, so the changed tiles are relaxed from as well
+    for (auto & tile : changedTiles)
+    {
+        pushReached(open, tile.x, tile.y);
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            pushReached(open, tile.x + actionX[a], tile.y + actionY[a]);
+        }
+    }
+
+    // dijkstra with unit edge costs, which only ever lowers distances
+    while (!open.empty())
+    {
+        const Entry entry = open.top();
+        open.pop();
+
+        if (entry.first != dist[entry.second]) { continue; }
+
+        const CCTilePosition tile(entry.second % m_width, entry.second / m_width);
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            const CCTilePosition next(tile.x + actionX[a], tile.y + actionY[a]);
+            if (!CanStep(map, tile, next, m_startStructure)) { continue; }
+
+            const int n = next.y * m_width + next.x;
+            if (dist[n] == -1 || entry.first + 1 < dist[n])
+            {
+                dist[n] = entry.first + 1;
+                open.push(Entry(dist[n], n));
+            }
+        }
+    }
+
+    sortTiles();
+    return true;
 }
 
 void DistanceMap::draw(CCBot & bot) const
 {
     const int tilesToDraw = 200;
-    for (size_t i(0); i < tilesToDraw; ++i)
+    for (size_t i(0); i < tilesToDraw && i < m_numSortedTiles; ++i)
     {
         auto & tile = m_sortedTiles[i];
         int dist = getDistance(tile);
@@ -95,4 +484,9 @@ void DistanceMap::draw(CCBot & bot) const
 const CCTilePosition & DistanceMap::getStartTile() const
 {
     return m_startTile;
+}
+
+size_t DistanceMap::getMemoryUsage() const
+{
+    return m_distStorage.capacity() * sizeof(int) + m_sortedTileStorage.capacity() * sizeof(CCTilePosition);
 }
\ No newline at end of file
@@ -2,35 +2,80 @@
 
 #include "Common.h"
 #include <map>
+#include <memory>
 
 namespace CC
 {
     class CCBot;
 
+    // a read-only view over a contiguous list of tiles, which may live inside a DistanceMap or the map cache
+    class TileList
+    {
+        const CCTilePosition *  m_tiles;
+        size_t                  m_size;
+
+    public:
+
+        TileList(const CCTilePosition * tiles = nullptr, size_t size = 0);
+
+        const CCTilePosition * begin() const;
+        const CCTilePosition * end() const;
+        const CCTilePosition & operator [] (size_t i) const;
+        size_t size() const;
+        bool empty() const;
+    };
+
     class DistanceMap
     {
         int m_width;
         int m_height;
         CCTilePosition m_startTile;
+        int m_startStructure;   // the structure covering the start tile when the map was computed, 0 if none
 
-        // 2D matrix storing distances from the start tile
-        std::vector<std::vector<int>> m_dist;
+        // distances from the start tile stored row-major, and every reachable tile sorted by distance
+        // these point either into the storage vectors below, or into a memory-mapped map cache file
+        const int *             m_dist;
+        const CCTilePosition *  m_sortedTiles;
+        size_t                  m_numSortedTiles;
 
-        std::vector<CCTilePosition> m_sortedTiles;
+        std::vector<int>            m_distStorage;
+        std::vector<CCTilePosition> m_sortedTileStorage;
+
+        void bindStorage();
+        void materialize();
+        void sortTiles();
 
     public:
 
         DistanceMap();
+        DistanceMap(const DistanceMap & rhs);
+        DistanceMap & operator = (const DistanceMap & rhs);
+        DistanceMap(DistanceMap && rhs);
+        DistanceMap & operator = (DistanceMap && rhs);
+
         void computeDistanceMap(CCBot & m_bot, const CCTilePosition & startTile);
 
+        // uses previously computed data (e.g. from the map cache) without copying it, the data must outlive this map
+        void loadDistanceMap(const CCTilePosition & startTile, int width, int height, const int * dist, const CCTilePosition * sortedTiles, size_t numSortedTiles);
+
+        // whether the walk distances of this map depend on any of the given changed tiles
+        bool crosses(const std::vector<CCTilePosition> & changedTiles) const;
+
+        // brings the map up to date after structures were placed or removed on the given tiles, touching only
+        // the tiles whose shortest path went through them. returns false if the map did not depend on them
+        bool repair(CCBot & bot, const std::vector<CCTilePosition> & changedTiles);
+
         int getDistance(int tileX, int tileY) const;
         int getDistance(const CCTilePosition & pos) const;
         int getDistance(const CCPosition & pos) const;
 
         // given a position, get the position we should move to to minimize distance
-        const std::vector<CCTilePosition> & getSortedTiles() const;
+        TileList getSortedTiles() const;
         const CCTilePosition & getStartTile() const;
 
+        // bytes of heap owned by this map, maps viewing the map cache own none
+        size_t getMemoryUsage() const;
+
         void draw(CCBot & bot) const;
     };
-}
\ No newline at end of file
+}
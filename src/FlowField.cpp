@@ -0,0 +1,150 @@
+#include "FlowField.h"
+#include "CCBot.h"
+#include "Util.h"
+
+#include <cmath>
+
+using namespace CC;
+
+namespace
+{
+    // orthogonal directions first, so they win ties against diagonals
+    const int NumDirections = 8;
+    const int directionX[NumDirections] = {1, -1, 0, 0, 1, 1, -1, -1};
+    const int directionY[NumDirections] = {0, 0, 1, -1, 1, -1, 1, -1};
+    const uint8_t NoDirection = NumDirections;
+}
+
+FlowField::FlowField()
+    : m_width(0)
+    , m_height(0)
+{
+
+}
+
+FlowField::FlowField(DistanceMap && buffers)
+    : m_width(0)
+    , m_height(0)
+    , m_distanceMap(std::move(buffers))
+{
+
+}
+
+void FlowField::computeFlowField(CCBot & bot, const CCTilePosition & target)
+{
+    m_target = target;
+    m_width  = bot.Map().width();
+    m_height = bot.Map().height();
+    m_distanceMap.computeDistanceMap(bot, target);
+    m_directions.assign(m_width * m_height, NoDirection);
+
+    // every reachable tile points at its neighbour closest to the target, unreachable tiles have no direction
+    for (auto & tile : m_distanceMap.getSortedTiles())
+    {
+        int bestDist = m_distanceMap.getDistance(tile);
+        uint8_t bestDirection = NoDirection;
+
+        for (int d(0); d < NumDirections; ++d)
+        {
+            int nx = tile.x + directionX[d];
+            int ny = tile.y + directionY[d];
+            if (!bot.Map().isWalkable(nx, ny)) { continue; }
+
+            // diagonal steps can't cut the corner of unwalkable terrain
+            if (directionX[d] != 0 && directionY[d] != 0 && (!bot.Map().isWalkable(nx, tile.y) || !bot.Map().isWalkable(tile.x, ny)))
+            {
+                continue;
+            }
+
+            int dist = m_distanceMap.getDistance(nx, ny);
+            if (dist != -1 && dist < bestDist)
+            {
+                bestDist = dist;
+                bestDirection = (uint8_t)d;
+            }
+        }
+
+        m_directions[tile.y * m_width + tile.x] = bestDirection;
+    }
+}
+
+const CCTilePosition & FlowField::getTarget() const
+{
+    return m_target;
+}
+
+bool FlowField::crosses(const std::vector<CCTilePosition> & changedTiles) const
+{
+    return m_distanceMap.crosses(changedTiles);
+}
+
+int FlowField::getDistance(const CCTilePosition & tile) const
+{
+    if (tile.x < 0 || tile.y < 0 || tile.x >= m_width || tile.y >= m_height)
+    {
+        return -1;
+    }
+
+    return m_distanceMap.getDistance(tile);
+}
+
+int FlowField::getDistance(const CCPosition & pos) const
+{
+    return getDistance(Util::GetTilePosition(pos));
+}
+
+CCPosition FlowField::getDirection(const CCPosition & pos) const
+{
+    CCTilePosition tile = Util::GetTilePosition(pos);
+    if (tile.x < 0 || tile.y < 0 || tile.x >= m_width || tile.y >= m_height)
+    {
+        return CCPosition(0, 0);
+    }
+
+    uint8_t direction = m_directions[tile.y * m_width + tile.x];
+    if (direction == NoDirection)
+    {
+        return CCPosition(0, 0);
+    }
+
+    float length = (directionX[direction] != 0 && directionY[direction] != 0) ? std::sqrt(2.0f) : 1.0f;
+    return CCPosition(directionX[direction] / length, directionY[direction] / length);
+}
+
+CCPosition FlowField::getNextPosition(const CCPosition & pos, int tiles) const
+{
+    CCTilePosition tile = Util::GetTilePosition(pos);
+    if (tile.x < 0 || tile.y < 0 || tile.x >= m_width || tile.y >= m_height)
+    {
+        return pos;
+    }
+
+    for (int i(0); i < tiles; ++i)
+    {
+        uint8_t direction = m_directions[tile.y * m_width + tile.x];
+        if (direction == NoDirection)
+        {
+            break;
+        }
+
+        tile = CCTilePosition(tile.x + directionX[direction], tile.y + directionY[direction]);
+    }
+
+    return CCPosition(Util::TileToPosition(tile.x + 0.5f), Util::TileToPosition(tile.y + 0.5f));
+}
+
+void FlowField::draw(const CCBot & bot) const
+{
+    // only the tiles close to the target, drawing the whole map would be far too slow
+    const size_t tilesToDraw = 400;
+    size_t drawn = 0;
+
+    for (auto & tile : m_distanceMap.getSortedTiles())
+    {
+        if (drawn++ >= tilesToDraw) { break; }
+
+        CCPosition center(Util::TileToPosition(tile.x + 0.5f), Util::TileToPosition(tile.y + 0.5f));
+        CCPosition direction = getDirection(center);
+        bot.Map().drawLine(center, center + direction * Util::TileToPosition(0.4f), CCColor(0, 255, 255));
+    }
+}
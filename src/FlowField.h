@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Common.h"
+#include "DistanceMap.h"
+
+namespace CC
+{
+    class CCBot;
+
+    // The direction every tile should move in to walk toward a target along the shortest ground path.
+    // One field is computed per target and shared by every unit heading there, so steering a unit is a
+    // single lookup instead of a path query per unit.
+    class FlowField
+    {
+        int                     m_width;
+        int                     m_height;
+        CCTilePosition          m_target;
+        DistanceMap             m_distanceMap;
+        std::vector<uint8_t>    m_directions;   // index into the direction table per tile, row-major
+
+    public:
+
+        FlowField();
+
+        // the distance map is only used for its buffers, so a recycled one avoids allocating
+        explicit FlowField(DistanceMap && buffers);
+
+        // recomputing an existing flow field for a new target reuses all of its buffers
+        void computeFlowField(CCBot & bot, const CCTilePosition & target);
+
+        const CCTilePosition & getTarget() const;
+
+        // whether the field depends on tiles whose walkability changed, in which case it has to be computed again
+        bool crosses(const std::vector<CCTilePosition> & changedTiles) const;
+        int getDistance(const CCPosition & pos) const;
+        int getDistance(const CCTilePosition & tile) const;
+
+        // unit vector pointing along the shortest path, or (0, 0) at the target or where the target is unreachable
+        CCPosition getDirection(const CCPosition & pos) const;
+
+        // the position reached by following the field for up to the given number of tiles
+        CCPosition getNextPosition(const CCPosition & pos, int tiles) const;
+
+        void draw(const CCBot & bot) const;
+    };
+}
@@ -41,6 +41,11 @@ void GameCommander::drawDebugInterface()
 
 void GameCommander::drawGameInformation(int x, int y)
 {
+    if (!m_bot.Draw().isEnabled(DebugCategory::GameInfo))
+    {
+        return;
+    }
+
     std::stringstream ss;
     ss << "Players: " << "\n";
     ss << "Strategy: " << m_bot.Config().StrategyName << "\n";
@@ -0,0 +1,628 @@
+#include "MapCache.h"
+#include "MapTools.h"
+#include "BaseLocationManager.h"
+#include "CCBot.h"
+#include "Util.h"
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <map>
+
+#ifdef WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace CC;
+
+namespace
+{
+    const char MapCacheMagic[4] = {'C', 'C', 'M', 'C'};
+
+    // FNV-1a, which is plenty to tell maps apart and stable across platforms
+    class MapHasher
+    {
+        uint64_t m_hash = 14695981039346656037ULL;
+
+    public:
+
+        void add(const void * data, size_t size)
+        {
+            const unsigned char * bytes = static_cast<const unsigned char *>(data);
+            for (size_t i(0); i < size; ++i)
+            {
+                m_hash ^= bytes[i];
+                m_hash *= 1099511628211ULL;
+            }
+        }
+
+        template <class T>
+        void add(const T & value) { add(&value, sizeof(T)); }
+
+        uint64_t hash() const { return m_hash; }
+    };
+
+    // accumulates the cache file contents, keeping every section 8 byte aligned
+    class MapCacheWriter
+    {
+        std::vector<char> m_buffer;
+
+    public:
+
+        uint64_t append(const void * data, size_t size)
+        {
+            uint64_t offset = m_buffer.size();
+            m_buffer.insert(m_buffer.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
+            m_buffer.resize((m_buffer.size() + 7) & ~size_t(7), 0);
+            return offset;
+        }
+
+        template <class T>
+        uint64_t append(const std::vector<T> & data) { return append(data.data(), data.size() * sizeof(T)); }
+
+        char * data() { return m_buffer.data(); }
+        size_t size() const { return m_buffer.size(); }
+    };
+}
+
+MapCache::MapCache()
+    : m_data(nullptr)
+    , m_size(0)
+#ifdef WIN32
+    , m_fileHandle(nullptr)
+    , m_mappingHandle(nullptr)
+#endif
+{
+
+}
+
+MapCache::~MapCache()
+{
+    close();
+}
+
+uint64_t MapCache::ComputeMapHash(CCBot & bot)
+{
+    MapHasher hasher;
+    hasher.add(Version);
+
+#ifdef SC2API
+    const sc2::GameInfo & info = bot.GetGameInfo();
+    hasher.add(info.width);
+    hasher.add(info.height);
+    hasher.add(info.pathing_grid.data.data(), info.pathing_grid.data.size());
+    hasher.add(info.placement_grid.data.data(), info.placement_grid.data.size());
+    hasher.add(info.terrain_height.data.data(), info.terrain_height.data.size());
+#else
+    const std::string mapHash = BWAPI::Broodwar->mapHash();
+    hasher.add(mapHash.data(), mapHash.size());
+#endif
+
+    // the start locations and static resources decide the base locations, hash them in a stable order
+    std::vector<std::pair<CCPositionType, CCPositionType>> positions;
+    for (auto & pos : bot.GetStartLocations())
+    {
+        positions.push_back(std::make_pair(pos.x, pos.y));
+    }
+
+    for (auto & unit : bot.GetUnits())
+    {
+        if (unit.getType().isMineral() || unit.getType().isGeyser())
+        {
+            positions.push_back(std::make_pair(unit.getPosition().x, unit.getPosition().y));
+        }
+    }
+
+    std::sort(positions.begin(), positions.end());
+    for (auto & pos : positions)
+    {
+        hasher.add(pos.first);
+        hasher.add(pos.second);
+    }
+
+    return hasher.hash();
+}
+
+bool MapCache::Save(const std::string & filename, uint64_t mapHash, const MapTools & map, const BaseLocationManager & bases)
+{
+    const int width  = map.width();
+    const int height = map.height();
+    const size_t numTiles = (size_t)width * height;
+    const std::vector<const BaseLocation *> & baseLocations = bases.getBaseLocations();
+
+    std::vector<uint8_t> walkable(numTiles), buildable(numTiles), depotBuildable(numTiles);
+    std::vector<int32_t> sectors(numTiles), tileBases(numTiles, -1);
+    std::vector<float>   terrainHeights(numTiles);
+
+    std::map<const BaseLocation *, int32_t> baseIDs;
+    for (size_t b(0); b < baseLocations.size(); ++b)
+    {
+        baseIDs[baseLocations[b]] = (int32_t)b;
+    }
+
+    for (int y(0); y < height; ++y)
+    {
+        for (int x(0); x < width; ++x)
+        {
+            const size_t i = (size_t)y * width + x;
+            walkable[i]       = map.isTerrainWalkable(x, y);
+            buildable[i]      = map.isBuildable(x, y);
+            depotBuildable[i] = map.isDepotBuildableTile(x, y);
+            sectors[i]        = map.getSectorNumber(x, y);
+            terrainHeights[i] = map.terrainHeight((float)x, (float)y);
+
+            const BaseLocation * base = bases.getBaseLocation(x, y);
+            if (base != nullptr)
+            {
+                tileBases[i] = baseIDs[base];
+            }
+        }
+    }
+
+    MapCacheWriter writer;
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    writer.append(&header, sizeof(Header));
+
+    memcpy(header.magic, MapCacheMagic, sizeof(header.magic));
+    header.version              = Version;
+    header.mapHash              = mapHash;
+    header.width                = width;
+    header.height               = height;
+    header.numBases             = (int32_t)baseLocations.size();
+    header.walkableOffset       = writer.append(walkable);
+    header.buildableOffset      = writer.append(buildable);
+    header.depotBuildableOffset = writer.append(depotBuildable);
+    header.sectorOffset         = writer.append(sectors);
+    header.terrainHeightOffset  = writer.append(terrainHeights);
+    header.tileBaseOffset       = writer.append(tileBases);
+
+    // the per-base data arrays are written first, then the records pointing at them
+    std::vector<BaseRecord> records(baseLocations.size());
+    std::vector<int32_t> distances(numTiles);
+    for (size_t b(0); b < baseLocations.size(); ++b)
+    {
+        const BaseLocation & base = *baseLocations[b];
+        const DistanceMap & distanceMap = base.getDistanceMap();
+        BaseRecord & record = records[b];
+        memset(&record, 0, sizeof(BaseRecord));
+
+        std::vector<float> resources;
+        for (auto & mineral : base.getMinerals())
+        {
+            resources.push_back(mineral.getPosition().x);
+            resources.push_back(mineral.getPosition().y);
+        }
+
+        for (auto & geyser : base.getGeysers())
+        {
+            resources.push_back(geyser.getPosition().x);
+            resources.push_back(geyser.getPosition().y);
+        }
+
+        for (int y(0); y < height; ++y)
+        {
+            for (int x(0); x < width; ++x)
+            {
+                distances[(size_t)y * width + x] = distanceMap.getDistance(x, y);
+            }
+        }
+
+        std::vector<int32_t> sortedTiles;
+        for (auto & tile : distanceMap.getSortedTiles())
+        {
+            sortedTiles.push_back(tile.x);
+            sortedTiles.push_back(tile.y);
+        }
+
+        record.depotX            = base.getDepotPosition().x;
+        record.depotY            = base.getDepotPosition().y;
+        record.startTileX        = distanceMap.getStartTile().x;
+        record.startTileY        = distanceMap.getStartTile().y;
+        record.isStartLocation   = base.isStartLocation();
+        record.numResources      = (int32_t)(resources.size() / 2);
+        record.numSortedTiles    = sortedTiles.size() / 2;
+        record.resourceOffset    = writer.append(resources);
+        record.distanceOffset    = writer.append(distances);
+        record.sortedTilesOffset = writer.append(sortedTiles);
+    }
+
+    header.baseRecordOffset = writer.append(records);
+
+    const RegionMap & regions = map.getRegionMap();
+    std::vector<int32_t> clearance(numTiles), tileRegions(numTiles);
+    for (int y(0); y < height; ++y)
+    {
+        for (int x(0); x < width; ++x)
+        {
+            const size_t i = (size_t)y * width + x;
+            clearance[i]   = regions.getClearance(x, y);
+            tileRegions[i] = regions.getRegionID(x, y);
+        }
+    }
+
+    std::vector<RegionRecord> regionRecords(regions.getRegions().size());
+    for (size_t r(0); r < regionRecords.size(); ++r)
+    {
+        const Region & region = regions.getRegions()[r];
+        RegionRecord & record = regionRecords[r];
+        memset(&record, 0, sizeof(RegionRecord));
+
+        record.maxClearance = region.maxClearance;
+        record.centerX      = region.center.x;
+        record.centerY      = region.center.y;
+        record.numTiles     = (int32_t)region.tiles.size();
+    }
+
+    std::vector<ChokeRecord> chokeRecords(regions.getChokes().size());
+    for (size_t c(0); c < chokeRecords.size(); ++c)
+    {
+        const Choke & choke = regions.getChokes()[c];
+        ChokeRecord & record = chokeRecords[c];
+        memset(&record, 0, sizeof(ChokeRecord));
+
+        std::vector<int32_t> tiles;
+        for (auto & tile : choke.tiles)
+        {
+            tiles.push_back(tile.x);
+            tiles.push_back(tile.y);
+        }
+
+        record.regionA     = choke.regionA;
+        record.regionB     = choke.regionB;
+        record.centerX     = choke.center.x;
+        record.centerY     = choke.center.y;
+        record.numTiles    = choke.tiles.size();
+        record.tilesOffset = writer.append(tiles);
+
+        for (int side(0); side < 2; ++side)
+        {
+            const std::vector<int> & field = regions.getChokeField(choke.id, side);
+            record.fieldOffset[side] = writer.append(std::vector<int32_t>(field.begin(), field.end()));
+        }
+    }
+
+    std::vector<int32_t> chokeDistances(chokeRecords.size() * chokeRecords.size());
+    for (size_t a(0); a < chokeRecords.size(); ++a)
+    {
+        for (size_t b(0); b < chokeRecords.size(); ++b)
+        {
+            chokeDistances[a * chokeRecords.size() + b] = regions.getChokeDistance((int)a, (int)b);
+        }
+    }
+
+    header.numRegions          = (int32_t)regionRecords.size();
+    header.numChokes           = (int32_t)chokeRecords.size();
+    header.clearanceOffset     = writer.append(clearance);
+    header.tileRegionOffset    = writer.append(tileRegions);
+    header.regionRecordOffset  = writer.append(regionRecords);
+    header.chokeRecordOffset   = writer.append(chokeRecords);
+    header.chokeDistanceOffset = writer.append(chokeDistances);
+    header.fileSize         = writer.size();
+    memcpy(writer.data(), &header, sizeof(Header));
+
+    // write to a process-unique temporary file and rename it over the real one, so another bot
+    // process never maps a partially written cache
+#ifdef WIN32
+    const std::string tempFilename = filename + "." + std::to_string(_getpid()) + ".tmp";
+#else
+    const std::string tempFilename = filename + "." + std::to_string(getpid()) + ".tmp";
+#endif
+
+    std::ofstream out(tempFilename, std::ios::binary | std::ios::trunc);
+    if (!out.good())
+    {
+        std::cerr << "Could not write map cache file: " << tempFilename << "\n";
+        return false;
+    }
+
+    out.write(writer.data(), writer.size());
+    out.close();
+
+    if (out.fail() || std::rename(tempFilename.c_str(), filename.c_str()) != 0)
+    {
+        // on windows rename fails if another process already wrote the cache, which is fine
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MapCache::load(const std::string & filename, uint64_t mapHash)
+{
+    close();
+
+#ifdef WIN32
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart >= (LONGLONG)sizeof(Header))
+    {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_data          = static_cast<const char *>(view);
+    m_size          = (size_t)fileSize.QuadPart;
+    m_fileHandle    = file;
+    m_mappingHandle = mapping;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(Header))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void * data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) { return false; }
+
+    m_data = static_cast<const char *>(data);
+    m_size = (size_t)fileStat.st_size;
+#endif
+
+    if (m_data == nullptr || !isValid(mapHash))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool MapCache::isValid(uint64_t mapHash) const
+{
+    const Header & h = header();
+    if (memcmp(h.magic, MapCacheMagic, sizeof(h.magic)) != 0 || h.version != Version || h.mapHash != mapHash || h.fileSize != m_size)
+    {
+        return false;
+    }
+
+    if (h.width <= 0 || h.height <= 0 || h.numBases < 0 || h.numRegions < 0 || h.numChokes < 0)
+    {
+        return false;
+    }
+
+    const uint64_t numTiles = (uint64_t)h.width * h.height;
+    auto inBounds = [this](uint64_t offset, uint64_t size) { return offset % 8 == 0 && offset <= m_size && size <= m_size - offset; };
+
+    if (!inBounds(h.walkableOffset, numTiles)
+        || !inBounds(h.buildableOffset, numTiles)
+        || !inBounds(h.depotBuildableOffset, numTiles)
+        || !inBounds(h.sectorOffset, numTiles * sizeof(int32_t))
+        || !inBounds(h.terrainHeightOffset, numTiles * sizeof(float))
+        || !inBounds(h.tileBaseOffset, numTiles * sizeof(int32_t))
+        || !inBounds(h.baseRecordOffset, (uint64_t)h.numBases * sizeof(BaseRecord))
+        || !inBounds(h.clearanceOffset, numTiles * sizeof(int32_t))
+        || !inBounds(h.tileRegionOffset, numTiles * sizeof(int32_t))
+        || !inBounds(h.regionRecordOffset, (uint64_t)h.numRegions * sizeof(RegionRecord))
+        || !inBounds(h.chokeRecordOffset, (uint64_t)h.numChokes * sizeof(ChokeRecord))
+        || !inBounds(h.chokeDistanceOffset, (uint64_t)h.numChokes * h.numChokes * sizeof(int32_t)))
+    {
+        return false;
+    }
+
+    for (size_t b(0); b < numBases(); ++b)
+    {
+        const BaseRecord & record = getBaseRecord(b);
+        if (record.numResources < 0 || record.numSortedTiles > numTiles
+            || !inBounds(record.resourceOffset, (uint64_t)record.numResources * 2 * sizeof(float))
+            || !inBounds(record.distanceOffset, numTiles * sizeof(int32_t))
+            || !inBounds(record.sortedTilesOffset, record.numSortedTiles * 2 * sizeof(int32_t)))
+        {
+            return false;
+        }
+    }
+
+    const int32_t * tileBases = tileBaseLocations();
+    const int32_t * regions   = tileRegions();
+    std::vector<int32_t> regionSizes(h.numRegions, 0);
+    for (uint64_t i(0); i < numTiles; ++i)
+    {
+        if (tileBases[i] < -1 || tileBases[i] >= h.numBases || regions[i] < -1 || regions[i] >= h.numRegions)
+        {
+            return false;
+        }
+
+        if (regions[i] != -1) { regionSizes[regions[i]]++; }
+    }
+
+    // the choke fields are indexed by region index, so the region sizes have to match the tile regions
+    for (size_t r(0); r < numRegions(); ++r)
+    {
+        if (getRegionRecord(r).numTiles != regionSizes[r])
+        {
+            return false;
+        }
+    }
+
+    for (size_t c(0); c < numChokes(); ++c)
+    {
+        const ChokeRecord & record = getChokeRecord(c);
+        if (record.regionA < 0 || record.regionA >= h.numRegions || record.regionB < 0 || record.regionB >= h.numRegions
+            || record.numTiles > numTiles
+            || !inBounds(record.tilesOffset, record.numTiles * 2 * sizeof(int32_t))
+            || !inBounds(record.fieldOffset[0], (uint64_t)regionSizes[record.regionA] * sizeof(int32_t))
+            || !inBounds(record.fieldOffset[1], (uint64_t)regionSizes[record.regionB] * sizeof(int32_t)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MapCache::close()
+{
+#ifdef WIN32
+    // the handles are released even without a view, so a half opened cache doesn't leak them
+    if (m_data != nullptr)          { UnmapViewOfFile(m_data); }
+    if (m_mappingHandle != nullptr) { CloseHandle(m_mappingHandle); }
+    if (m_fileHandle != nullptr)    { CloseHandle(m_fileHandle); }
+    m_fileHandle    = nullptr;
+    m_mappingHandle = nullptr;
+#else
+    if (m_data != nullptr)
+    {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool MapCache::isLoaded() const
+{
+    return m_data != nullptr;
+}
+
+const MapCache::Header & MapCache::header() const
+{
+    BOT_ASSERT(isLoaded(), "Map cache is not loaded");
+    return *at<Header>(0);
+}
+
+int MapCache::width() const
+{
+    return header().width;
+}
+
+int MapCache::height() const
+{
+    return header().height;
+}
+
+size_t MapCache::numBases() const
+{
+    return (size_t)header().numBases;
+}
+
+size_t MapCache::numRegions() const
+{
+    return (size_t)header().numRegions;
+}
+
+size_t MapCache::numChokes() const
+{
+    return (size_t)header().numChokes;
+}
+
+const uint8_t * MapCache::walkable() const
+{
+    return at<uint8_t>(header().walkableOffset);
+}
+
+const uint8_t * MapCache::buildable() const
+{
+    return at<uint8_t>(header().buildableOffset);
+}
+
+const uint8_t * MapCache::depotBuildable() const
+{
+    return at<uint8_t>(header().depotBuildableOffset);
+}
+
+const int32_t * MapCache::sectorNumbers() const
+{
+    return at<int32_t>(header().sectorOffset);
+}
+
+const float * MapCache::terrainHeights() const
+{
+    return at<float>(header().terrainHeightOffset);
+}
+
+const int32_t * MapCache::tileBaseLocations() const
+{
+    return at<int32_t>(header().tileBaseOffset);
+}
+
+const int32_t * MapCache::clearance() const
+{
+    return at<int32_t>(header().clearanceOffset);
+}
+
+const int32_t * MapCache::tileRegions() const
+{
+    return at<int32_t>(header().tileRegionOffset);
+}
+
+const int32_t * MapCache::chokeDistances() const
+{
+    return at<int32_t>(header().chokeDistanceOffset);
+}
+
+const MapCache::BaseRecord & MapCache::getBaseRecord(size_t baseID) const
+{
+    BOT_ASSERT(baseID < numBases(), "Base record out of range: %d", (int)baseID);
+    return at<BaseRecord>(header().baseRecordOffset)[baseID];
+}
+
+const float * MapCache::getResourcePositions(const BaseRecord & base) const
+{
+    return at<float>(base.resourceOffset);
+}
+
+const int * MapCache::getDistances(const BaseRecord & base) const
+{
+    return at<int>(base.distanceOffset);
+}
+
+const CCTilePosition * MapCache::getSortedTiles(const BaseRecord & base) const
+{
+    static_assert(sizeof(CCTilePosition) == 2 * sizeof(int32_t), "tile positions must be stored as two ints");
+    return at<CCTilePosition>(base.sortedTilesOffset);
+}
+
+const MapCache::RegionRecord & MapCache::getRegionRecord(size_t regionID) const
+{
+    BOT_ASSERT(regionID < numRegions(), "Region record out of range: %d", (int)regionID);
+    return at<RegionRecord>(header().regionRecordOffset)[regionID];
+}
+
+const MapCache::ChokeRecord & MapCache::getChokeRecord(size_t chokeID) const
+{
+    BOT_ASSERT(chokeID < numChokes(), "Choke record out of range: %d", (int)chokeID);
+    return at<ChokeRecord>(header().chokeRecordOffset)[chokeID];
+}
+
+const CCTilePosition * MapCache::getChokeTiles(const ChokeRecord & choke) const
+{
+    return at<CCTilePosition>(choke.tilesOffset);
+}
+
+const int32_t * MapCache::getChokeField(const ChokeRecord & choke, int side) const
+{
+    return at<int32_t>(choke.fieldOffset[side]);
+}
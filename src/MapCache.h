@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Common.h"
+#include <cstdint>
+
+namespace CC
+{
+    class CCBot;
+    class MapTools;
+    class BaseLocationManager;
+
+    // A versioned binary snapshot of the static map analysis: the tile grids, connectivity sectors,
+    // base locations with their distance maps, the tile -> base location lookup, and the regions and chokes
+    // with their distance tables. The file is written once per map to WriteDir and memory-mapped read-only
+    // on later games, so concurrently running bot processes share the same physical pages.
+    class MapCache
+    {
+    public:
+
+        static const uint32_t Version = 3;
+
+        struct Header
+        {
+            char        magic[4];
+            uint32_t    version;
+            uint64_t    mapHash;
+            uint64_t    fileSize;
+            int32_t     width;
+            int32_t     height;
+            int32_t     numBases;
+            int32_t     reserved;
+            uint64_t    walkableOffset;         // width*height uint8, row-major
+            uint64_t    buildableOffset;        // width*height uint8, row-major
+            uint64_t    depotBuildableOffset;   // width*height uint8, row-major
+            uint64_t    sectorOffset;           // width*height int32, row-major
+            uint64_t    terrainHeightOffset;    // width*height float, row-major
+            uint64_t    tileBaseOffset;         // width*height int32 base id or -1, row-major
+            uint64_t    baseRecordOffset;       // numBases BaseRecord
+            int32_t     numRegions;
+            int32_t     numChokes;
+            uint64_t    clearanceOffset;        // width*height int32, row-major
+            uint64_t    tileRegionOffset;       // width*height int32 region id or -1, row-major
+            uint64_t    regionRecordOffset;     // numRegions RegionRecord
+            uint64_t    chokeRecordOffset;      // numChokes ChokeRecord
+            uint64_t    chokeDistanceOffset;    // numChokes*numChokes int32 walk distance or -1, row-major by choke id
+        };
+
+        struct BaseRecord
+        {
+            int32_t     depotX;
+            int32_t     depotY;
+            int32_t     startTileX;             // start tile of the base's distance map
+            int32_t     startTileY;
+            int32_t     isStartLocation;
+            int32_t     numResources;
+            uint64_t    numSortedTiles;
+            uint64_t    resourceOffset;         // numResources float (x, y) pairs
+            uint64_t    distanceOffset;         // width*height int32, row-major
+            uint64_t    sortedTilesOffset;      // numSortedTiles int32 (x, y) pairs
+        };
+
+        struct RegionRecord
+        {
+            int32_t     maxClearance;
+            int32_t     centerX;
+            int32_t     centerY;
+            int32_t     numTiles;
+        };
+
+        struct ChokeRecord
+        {
+            int32_t     regionA;
+            int32_t     regionB;
+            int32_t     centerX;
+            int32_t     centerY;
+            uint64_t    numTiles;
+            uint64_t    tilesOffset;            // numTiles int32 (x, y) pairs
+            uint64_t    fieldOffset[2];         // int32 walk distance or -1 to each tile of region A and B, by region index
+        };
+
+    private:
+
+        const char *    m_data;
+        size_t          m_size;
+#ifdef WIN32
+        void *          m_fileHandle;
+        void *          m_mappingHandle;
+#endif
+
+        const Header & header() const;
+
+        template <class T>
+        const T * at(uint64_t offset) const { return reinterpret_cast<const T *>(m_data + offset); }
+
+        bool isValid(uint64_t mapHash) const;
+
+    public:
+
+        MapCache();
+        ~MapCache();
+
+        MapCache(const MapCache &) = delete;
+        MapCache & operator = (const MapCache &) = delete;
+
+        static uint64_t ComputeMapHash(CCBot & bot);
+        static bool Save(const std::string & filename, uint64_t mapHash, const MapTools & map, const BaseLocationManager & bases);
+
+        bool load(const std::string & filename, uint64_t mapHash);
+        void close();
+        bool isLoaded() const;
+
+        int width() const;
+        int height() const;
+        size_t numBases() const;
+        size_t numRegions() const;
+        size_t numChokes() const;
+
+        const uint8_t * walkable() const;
+        const uint8_t * buildable() const;
+        const uint8_t * depotBuildable() const;
+        const int32_t * sectorNumbers() const;
+        const float *   terrainHeights() const;
+        const int32_t * tileBaseLocations() const;
+        const int32_t * clearance() const;
+        const int32_t * tileRegions() const;
+        const int32_t * chokeDistances() const;
+
+        const BaseRecord & getBaseRecord(size_t baseID) const;
+        const float * getResourcePositions(const BaseRecord & base) const;
+        const int * getDistances(const BaseRecord & base) const;
+        const CCTilePosition * getSortedTiles(const BaseRecord & base) const;
+
+        const RegionRecord & getRegionRecord(size_t regionID) const;
+        const ChokeRecord & getChokeRecord(size_t chokeID) const;
+        const CCTilePosition * getChokeTiles(const ChokeRecord & choke) const;
+        const int32_t * getChokeField(const ChokeRecord & choke, int side) const;
+    };
+}
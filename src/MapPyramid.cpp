@@ -0,0 +1,482 @@
+#include "MapPyramid.h"
+#include "MapTools.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+using namespace CC;
+
+const uint8_t LinkX = 1;
+const uint8_t LinkY = 2;
+
+namespace
+{
+    // positions in tile units, so the same math works for pixel positions
+    float ToTiles(float p)
+    {
+        return p / (float)Util::TileToPosition(1.0f);
+    }
+
+    // squared distance in tiles from a point to the rectangle covering tiles [x0, x1) x [y0, y1)
+    float DistSqToRect(float px, float py, int x0, int y0, int x1, int y1)
+    {
+        float dx = std::max(0.0f, std::max((float)x0 - px, px - (float)x1));
+        float dy = std::max(0.0f, std::max((float)y0 - py, py - (float)y1));
+        return dx * dx + dy * dy;
+    }
+
+    struct Entry
+    {
+        int value;
+        int level;
+        int cx;
+        int cy;
+    };
+
+    struct EntryOrder
+    {
+        bool largest;
+
+        bool operator () (const Entry & a, const Entry & b) const
+        {
+            return largest ? a.value < b.value : a.value > b.value;
+        }
+    };
+}
+
+GridPyramid::GridPyramid()
+{
+    reset(0, 0, 0);
+}
+
+void GridPyramid::reset(int width, int height, int value)
+{
+    for (int level(0); level < Levels; ++level)
+    {
+        m_width[level]  = (width + (1 << level) - 1) >> level;
+        m_height[level] = (height + (1 << level) - 1) >> level;
+
+        if (level > 0)
+        {
+            m_min[level].assign(m_width[level] * m_height[level], value);
+            m_max[level].assign(m_width[level] * m_height[level], value);
+        }
+    }
+
+    m_tiles.assign(width * height, value);
+    m_blockDirty.assign(m_width[Levels - 1] * m_height[Levels - 1], 0);
+    m_dirtyBlocks.clear();
+}
+
+void GridPyramid::markDirty(int x, int y)
+{
+    const int block = (y >> (Levels - 1)) * m_width[Levels - 1] + (x >> (Levels - 1));
+    if (!m_blockDirty[block])
+    {
+        m_blockDirty[block] = 1;
+        m_dirtyBlocks.push_back(block);
+    }
+}
+
+void GridPyramid::set(int x, int y, int value)
+{
+    int & tile = m_tiles[y * m_width[0] + x];
+    if (tile != value)
+    {
+        tile = value;
+        markDirty(x, y);
+    }
+}
+
+void GridPyramid::add(int x, int y, int delta)
+{
+    if (delta != 0)
+    {
+        m_tiles[y * m_width[0] + x] += delta;
+        markDirty(x, y);
+    }
+}
+
+void GridPyramid::reduceCell(int level, int cx, int cy)
+{
+    int lo = INT_MAX;
+    int hi = INT_MIN;
+
+    for (int x(2 * cx); x < std::min(2 * cx + 2, m_width[level - 1]); ++x)
+    {
+        for (int y(2 * cy); y < std::min(2 * cy + 2, m_height[level - 1]); ++y)
+        {
+            lo = std::min(lo, getMin(level - 1, x, y));
+            hi = std::max(hi, getMax(level - 1, x, y));
+        }
+    }
+
+    m_min[level][cy * m_width[level] + cx] = lo;
+    m_max[level][cy * m_width[level] + cx] = hi;
+}
+
+// every dirty block is reduced bottom up, which touches 21 cells per block rather than the whole pyramid
+void GridPyramid::update()
+{
+    for (int block : m_dirtyBlocks)
+    {
+        m_blockDirty[block] = 0;
+
+        const int bx = block % m_width[Levels - 1];
+        const int by = block / m_width[Levels - 1];
+        for (int level(1); level < Levels; ++level)
+        {
+            const int span = 1 << (Levels - 1 - level);
+            for (int cx(bx * span); cx < std::min((bx + 1) * span, m_width[level]); ++cx)
+            {
+                for (int cy(by * span); cy < std::min((by + 1) * span, m_height[level]); ++cy)
+                {
+                    reduceCell(level, cx, cy);
+                }
+            }
+        }
+    }
+
+    m_dirtyBlocks.clear();
+}
+
+int GridPyramid::width(int level) const
+{
+    return m_width[level];
+}
+
+int GridPyramid::height(int level) const
+{
+    return m_height[level];
+}
+
+int GridPyramid::get(int x, int y) const
+{
+    return m_tiles[y * m_width[0] + x];
+}
+
+int GridPyramid::getMin(int level, int cx, int cy) const
+{
+    return level == 0 ? m_tiles[cy * m_width[0] + cx] : m_min[level][cy * m_width[level] + cx];
+}
+
+int GridPyramid::getMax(int level, int cx, int cy) const
+{
+    return level == 0 ? m_tiles[cy * m_width[0] + cx] : m_max[level][cy * m_width[level] + cx];
+}
+
+int GridPyramid::getMinNear(const CCPosition & pos, float radius) const
+{
+    const float r = ToTiles(radius);
+    int level = 0;
+    while (level + 1 < Levels && (1 << (level + 1)) <= r) { ++level; }
+
+    const int size = 1 << level;
+    const float px = ToTiles(pos.x);
+    const float py = ToTiles(pos.y);
+
+    int lo = INT_MAX;
+    for (int cx(std::max(0, (int)std::floor((px - r) / size))); cx <= std::min(m_width[level] - 1, (int)std::floor((px + r) / size)); ++cx)
+    {
+        for (int cy(std::max(0, (int)std::floor((py - r) / size))); cy <= std::min(m_height[level] - 1, (int)std::floor((py + r) / size)); ++cy)
+        {
+            lo = std::min(lo, getMin(level, cx, cy));
+        }
+    }
+
+    return lo;
+}
+
+int GridPyramid::getMaxNear(const CCPosition & pos, float radius) const
+{
+    const float r = ToTiles(radius);
+    int level = 0;
+    while (level + 1 < Levels && (1 << (level + 1)) <= r) { ++level; }
+
+    const int size = 1 << level;
+    const float px = ToTiles(pos.x);
+    const float py = ToTiles(pos.y);
+
+    int hi = INT_MIN;
+    for (int cx(std::max(0, (int)std::floor((px - r) / size))); cx <= std::min(m_width[level] - 1, (int)std::floor((px + r) / size)); ++cx)
+    {
+        for (int cy(std::max(0, (int)std::floor((py - r) / size))); cy <= std::min(m_height[level] - 1, (int)std::floor((py + r) / size)); ++cy)
+        {
+            hi = std::max(hi, getMax(level, cx, cy));
+        }
+    }
+
+    return hi;
+}
+
+bool GridPyramid::intersects(int level, int cx, int cy, const CCPosition & pos, float radius) const
+{
+    if (radius <= 0)
+    {
+        return true;
+    }
+
+    const float r = ToTiles(radius);
+    const int size = 1 << level;
+
+    // tiles count by their center, cells by any part of them
+    if (level == 0)
+    {
+        const float dx = ToTiles(pos.x) - (cx + 0.5f);
+        const float dy = ToTiles(pos.y) - (cy + 0.5f);
+        return dx * dx + dy * dy <= r * r;
+    }
+
+    return DistSqToRect(ToTiles(pos.x), ToTiles(pos.y), cx * size, cy * size, (cx + 1) * size, (cy + 1) * size) <= r * r;
+}
+
+// best first search over the cells: a cell's bound is the best value any tile under it can have, so once a tile
+// is taken off the queue no tile left in the queue or below a queued cell can beat it
+void GridPyramid::getBestTiles(const CCPosition & pos, float radius, size_t k, bool largest, int limit, std::vector<CCTilePosition> & tiles) const
+{
+    tiles.clear();
+
+    EntryOrder order;
+    order.largest = largest;
+    std::priority_queue<Entry, std::vector<Entry>, EntryOrder> queue(order);
+
+    auto push = [&](int level, int cx, int cy)
+    {
+        const int value = largest ? getMax(level, cx, cy) : getMin(level, cx, cy);
+        if ((largest ? value > limit : value < limit) && intersects(level, cx, cy, pos, radius))
+        {
+            Entry entry = { value, level, cx, cy };
+            queue.push(entry);
+        }
+    };
+
+    const int top = Levels - 1;
+    for (int cx(0); cx < m_width[top]; ++cx)
+    {
+        for (int cy(0); cy < m_height[top]; ++cy)
+        {
+            push(top, cx, cy);
+        }
+    }
+
+    while (!queue.empty() && tiles.size() < k)
+    {
+        const Entry entry = queue.top();
+        queue.pop();
+
+        if (entry.level == 0)
+        {
+            tiles.push_back(CCTilePosition(entry.cx, entry.cy));
+            continue;
+        }
+
+        for (int x(2 * entry.cx); x < std::min(2 * entry.cx + 2, m_width[entry.level - 1]); ++x)
+        {
+            for (int y(2 * entry.cy); y < std::min(2 * entry.cy + 2, m_height[entry.level - 1]); ++y)
+            {
+                push(entry.level - 1, x, y);
+            }
+        }
+    }
+}
+
+WalkablePyramid::WalkablePyramid()
+{
+    for (int level(0); level < GridPyramid::Levels; ++level)
+    {
+        m_width[level]  = 0;
+        m_height[level] = 0;
+    }
+}
+
+void WalkablePyramid::build(const MapTools & map)
+{
+    for (int level(0); level < GridPyramid::Levels; ++level)
+    {
+        m_width[level]  = (map.width() + (1 << level) - 1) >> level;
+        m_height[level] = (map.height() + (1 << level) - 1) >> level;
+        m_walkable[level].assign(m_width[level] * m_height[level], 0);
+        m_links[level].assign(m_width[level] * m_height[level], 0);
+    }
+
+    const int top = GridPyramid::Levels - 1;
+    for (int bx(0); bx < m_width[top]; ++bx)
+    {
+        for (int by(0); by < m_height[top]; ++by)
+        {
+            computeBlock(map, bx, by);
+        }
+    }
+}
+
+void WalkablePyramid::update(const MapTools & map, const std::vector<CCTilePosition> & changedTiles)
+{
+    const int top = GridPyramid::Levels - 1;
+
+    // a tile's walkability decides the links of its own block, and those of the blocks left of and below it
+    std::vector<int> blocks;
+    for (auto & tile : changedTiles)
+    {
+        for (auto & t : { tile, CCTilePosition(tile.x - 1, tile.y), CCTilePosition(tile.x, tile.y - 1) })
+        {
+            if (t.x < 0 || t.y < 0) { continue; }
+            blocks.push_back((t.y >> top) * m_width[top] + (t.x >> top));
+        }
+    }
+
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+
+    for (int block : blocks)
+    {
+        computeBlock(map, block % m_width[top], block / m_width[top]);
+    }
+}
+
+// recomputes every level of the cells under one coarsest cell, bottom up
+void WalkablePyramid::computeBlock(const MapTools & map, int bx, int by)
+{
+    const int top = GridPyramid::Levels - 1;
+
+    for (int x(bx << top); x < std::min((bx + 1) << top, m_width[0]); ++x)
+    {
+        for (int y(by << top); y < std::min((by + 1) << top, m_height[0]); ++y)
+        {
+            const bool walkable = map.isWalkable(x, y);
+            uint8_t links = 0;
+            if (walkable && map.isWalkable(x + 1, y)) { links |= LinkX; }
+            if (walkable && map.isWalkable(x, y + 1)) { links |= LinkY; }
+
+            m_walkable[0][y * m_width[0] + x] = walkable;
+            m_links[0][y * m_width[0] + x] = links;
+        }
+    }
+
+    for (int level(1); level <= top; ++level)
+    {
+        const int span = 1 << (top - level);
+        const int fineWidth = m_width[level - 1];
+        const int fineHeight = m_height[level - 1];
+
+        for (int cx(bx * span); cx < std::min((bx + 1) * span, m_width[level]); ++cx)
+        {
+            for (int cy(by * span); cy < std::min((by + 1) * span, m_height[level]); ++cy)
+            {
+                uint8_t walkable = 0;
+                uint8_t links = 0;
+
+                for (int fx(2 * cx); fx < std::min(2 * cx + 2, fineWidth); ++fx)
+                {
+                    for (int fy(2 * cy); fy < std::min(2 * cy + 2, fineHeight); ++fy)
+                    {
+                        const int fine = fy * fineWidth + fx;
+                        walkable |= m_walkable[level - 1][fine];
+
+                        // only the children on the far edge of the cell can link to the next cell
+                        if (fx == 2 * cx + 1 || fx == fineWidth - 1) { links |= m_links[level - 1][fine] & LinkX; }
+                        if (fy == 2 * cy + 1 || fy == fineHeight - 1) { links |= m_links[level - 1][fine] & LinkY; }
+                    }
+                }
+
+                m_walkable[level][cy * m_width[level] + cx] = walkable;
+                m_links[level][cy * m_width[level] + cx] = links;
+            }
+        }
+    }
+}
+
+int WalkablePyramid::width(int level) const
+{
+    return m_width[level];
+}
+
+int WalkablePyramid::height(int level) const
+{
+    return m_height[level];
+}
+
+int WalkablePyramid::getCellSize(int level) const
+{
+    return 1 << level;
+}
+
+bool WalkablePyramid::isWalkable(int level, int cx, int cy) const
+{
+    if (cx < 0 || cy < 0 || cx >= m_width[level] || cy >= m_height[level])
+    {
+        return false;
+    }
+
+    return m_walkable[level][cy * m_width[level] + cx] != 0;
+}
+
+// links are stored on the cell with the smaller coordinate, dx and dy are a step to one of the four neighbours
+bool WalkablePyramid::isLinked(int level, int cx, int cy, int dx, int dy) const
+{
+    if (dx < 0 || dy < 0)
+    {
+        return isLinked(level, cx + dx, cy + dy, -dx, -dy);
+    }
+
+    if (cx < 0 || cy < 0 || cx + dx >= m_width[level] || cy + dy >= m_height[level])
+    {
+        return false;
+    }
+
+    return (m_links[level][cy * m_width[level] + cx] & (dx > 0 ? LinkX : LinkY)) != 0;
+}
+
+void WalkablePyramid::computeDistances(const CCTilePosition & from, int level, std::vector<int> & dist) const
+{
+    const int w = m_width[level];
+    const int h = m_height[level];
+    const int size = getCellSize(level);
+    dist.assign(w * h, -1);
+
+    const int startX = from.x >> level;
+    const int startY = from.y >> level;
+    if (!isWalkable(level, startX, startY))
+    {
+        return;
+    }
+
+    const int stepX[4] = { 1, -1, 0, 0 };
+    const int stepY[4] = { 0, 0, 1, -1 };
+
+    std::vector<int> fringe;
+    fringe.reserve(w * h);
+    fringe.push_back(startY * w + startX);
+    dist[startY * w + startX] = 0;
+
+    for (size_t i(0); i < fringe.size(); ++i)
+    {
+        const int cx = fringe[i] % w;
+        const int cy = fringe[i] / w;
+        for (int a(0); a < 4; ++a)
+        {
+            const int nx = cx + stepX[a];
+            const int ny = cy + stepY[a];
+            if (!isLinked(level, cx, cy, stepX[a], stepY[a]) || dist[ny * w + nx] != -1) { continue; }
+
+            dist[ny * w + nx] = dist[fringe[i]] + size;
+            fringe.push_back(ny * w + nx);
+        }
+    }
+}
+
+int WalkablePyramid::getApproxDistance(const CCTilePosition & from, const CCTilePosition & to, int level) const
+{
+    std::vector<int> dist;
+    computeDistances(from, level, dist);
+
+    const int cx = to.x >> level;
+    const int cy = to.y >> level;
+    if (cx < 0 || cy < 0 || cx >= m_width[level] || cy >= m_height[level])
+    {
+        return -1;
+    }
+
+    return dist[cy * m_width[level] + cx];
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+    class MapTools;
+
+    // A row-major grid of tile values with coarser levels of 2x2, 4x4 and 8x8 tiles on top, where each coarse cell
+    // keeps the smallest and largest value of the tiles under it. A cell therefore bounds every tile it covers, so
+    // "is anything here" questions read a few coarse cells, and searches for the best tiles rank the few hundred cells
+    // of the coarsest level and only descend into the cells that can still hold a better tile than the ones found.
+    class GridPyramid
+    {
+    public:
+
+        static const int Levels = 4;
+
+    private:
+
+        int                     m_width[Levels];
+        int                     m_height[Levels];
+        std::vector<int>        m_tiles;            // the values of level 0
+        std::vector<int>        m_min[Levels];      // smallest tile value under each cell, unused for level 0
+        std::vector<int>        m_max[Levels];      // largest tile value under each cell, unused for level 0
+        std::vector<int>        m_dirtyBlocks;      // coarsest cells whose tiles changed since the last update
+        std::vector<uint8_t>    m_blockDirty;
+
+        void markDirty(int x, int y);
+        void reduceCell(int level, int cx, int cy);
+        bool intersects(int level, int cx, int cy, const CCPosition & pos, float radius) const;
+
+    public:
+
+        GridPyramid();
+
+        void    reset(int width, int height, int value);
+        void    set(int x, int y, int value);
+        void    add(int x, int y, int delta);
+
+        // re-reduces the coarse cells above the tiles changed since the last update
+        void    update();
+
+        int     width(int level) const;
+        int     height(int level) const;
+        int     get(int x, int y) const;
+        int     getMin(int level, int cx, int cy) const;
+        int     getMax(int level, int cx, int cy) const;
+
+        // bounds of the tiles within radius of pos, read from the coarsest cells that fit inside the radius,
+        // so they may include tiles up to one cell beyond it
+        int     getMinNear(const CCPosition & pos, float radius) const;
+        int     getMaxNear(const CCPosition & pos, float radius) const;
+
+        // the k tiles within radius of pos with the largest (or smallest) values, best first, only counting tiles whose
+        // value is beyond the limit (above it when largest, below it otherwise). a radius of zero or less searches the whole map
+        void    getBestTiles(const CCPosition & pos, float radius, size_t k, bool largest, int limit, std::vector<CCTilePosition> & tiles) const;
+    };
+
+    // Walkability at 2x, 4x and 8x coarser resolution. A coarse cell is walkable if any tile under it is, and two
+    // neighbouring cells are linked if a walkable tile of one borders a walkable tile of the other, so every ground
+    // path on the tiles still exists between the coarse cells, and coarse searches never split what is connected.
+    class WalkablePyramid
+    {
+        int                     m_width[GridPyramid::Levels];
+        int                     m_height[GridPyramid::Levels];
+        std::vector<uint8_t>    m_walkable[GridPyramid::Levels];
+        std::vector<uint8_t>    m_links[GridPyramid::Levels];   // LinkX if linked to the cell at x+1, LinkY for y+1
+
+        void    computeBlock(const MapTools & map, int bx, int by);
+
+    public:
+
+        WalkablePyramid();
+
+        void    build(const MapTools & map);
+
+        // recomputes the cells above tiles whose walkability changed
+        void    update(const MapTools & map, const std::vector<CCTilePosition> & changedTiles);
+
+        int     width(int level) const;
+        int     height(int level) const;
+        int     getCellSize(int level) const;
+        bool    isWalkable(int level, int cx, int cy) const;
+        bool    isLinked(int level, int cx, int cy, int dx, int dy) const;
+
+        // walking distances in tiles estimated by searching the cells of a level instead of the tiles, the estimate is
+        // off by up to a cell's size per cell crossed. -1 where the cells aren't connected
+        void    computeDistances(const CCTilePosition & from, int level, std::vector<int> & dist) const;
+        int     getApproxDistance(const CCTilePosition & from, const CCTilePosition & to, int level) const;
+    };
+}
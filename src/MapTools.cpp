@@ -6,10 +6,26 @@
 #include <sstream>
 #include <fstream>
 #include <array>
+#include <cstring>
+#include <algorithm>
+#include <climits>
+
+#ifdef SC2API
+    #include "s2clientprotocol/sc2api.pb.h"
+#endif
 
 using namespace CC;
 
 const size_t LegalActions = 4;
+
+// a destination queried this many times within the query window gets a full distance map instead of point queries
+const int DistanceMapQueryThreshold = 8;
+const int DistanceQueryWindowFrames = 24;
+
+const size_t MaxDistanceMaps = 50;
+const size_t MaxPooledDistanceMaps = 8;
+const size_t MaxFlowFields = 16;
+
 const int actionX[LegalActions] ={1, -1, 0, 0};
 const int actionY[LegalActions] ={0, 0, 1, -1};
 
@@ -23,6 +39,11 @@ typedef std::vector<std::vector<float>>  vvf;
     #define HALF_TILE 0
 #endif
 
+// values of the visibility raster, which match sc2::Visibility so the raw observation data can be used as is
+const uint8_t TileHidden  = 0;
+const uint8_t TileFogged  = 1;
+const uint8_t TileVisible = 2;
+
 // constructor for MapTools
 MapTools::MapTools(CCBot & bot)
     : m_bot     (bot)
@@ -30,6 +51,8 @@ MapTools::MapTools(CCBot & bot)
     , m_height  (0)
     , m_maxZ    (0.0f)
     , m_frame   (0)
+    , m_mapHash (0)
+    , m_nextStructureID(1)
 {
 
 }
@@ -37,8 +60,8 @@ MapTools::MapTools(CCBot & bot)
 void MapTools::onStart()
 {
 #ifdef SC2API
-    m_width  = m_bot.Observation()->GetGameInfo().width;
-    m_height = m_bot.Observation()->GetGameInfo().height;
+    m_width  = m_bot.GetGameInfo().width;
+    m_height = m_bot.GetGameInfo().height;
 #else
     m_width  = BWAPI::Broodwar->mapWidth();
     m_height = BWAPI::Broodwar->mapHeight();
@@ -47,10 +70,67 @@ void MapTools::onStart()
     m_walkable       = vvb(m_width, std::vector<bool>(m_height, true));
     m_buildable      = vvb(m_width, std::vector<bool>(m_height, false));
     m_depotBuildable = vvb(m_width, std::vector<bool>(m_height, false));
-    m_lastSeen       = vvi(m_width, std::vector<int>(m_height, 0));
+    m_lastSeen       = std::vector<int>(m_width * m_height, 0);
+    m_visibility     = std::vector<uint8_t>(m_width * m_height, TileHidden);
+    m_prevVisibility = std::vector<uint8_t>(m_width * m_height, TileHidden);
+    m_powered        = std::vector<uint8_t>(m_width * m_height, 0);
+    m_creep          = std::vector<uint8_t>(m_width * m_height, 0);
     m_sectorNumber   = vvi(m_width, std::vector<int>(m_height, 0));
+    m_structureAt    = std::vector<int>(m_width * m_height, 0);
     m_terrainHeight  = vvf(m_width, std::vector<float>(m_height, 0.0f));
 
+#ifdef SC2API
+    for (auto & unit : m_bot.GetUnits())
+    {
+        m_maxZ = std::max(unit.getUnitPtr()->pos.z, m_maxZ);
+    }
+#endif
+
+    updateVisibility();
+
+    // if a previous game already analyzed this map, the grids and sectors come from the cache
+    if (!loadMapCache())
+    {
+        computeMapData();
+    }
+    computeSectorSizes();
+    m_bot.OnStartupStage("map data");
+
+    if (m_mapCache.isLoaded())
+    {
+        m_regions.load(m_mapCache);
+    }
+    else
+    {
+        m_regions.computeRegions(*this);
+    }
+    m_bot.OnStartupStage("regions");
+
+    m_pathFinder.computeWalkable(*this);
+    m_bot.OnStartupStage("path finder");
+
+    // stale tiles are ranked by walking distance from our start location, ties in staleness go to the closest
+    m_staleTiles.build(*this, getDistanceMap(m_bot.GetStartLocation()).getSortedTiles());
+    m_bot.OnStartupStage("stale tiles");
+
+    m_walkablePyramid.build(*this);
+    m_lastSeenPyramid.reset(m_width, m_height, INT_MAX);
+    for (int x(0); x < m_width; ++x)
+    {
+        for (int y(0); y < m_height; ++y)
+        {
+            if (isTerrainWalkable(x, y) && !isVisible(x, y))
+            {
+                m_lastSeenPyramid.set(x, y, getLastSeen(x, y));
+            }
+        }
+    }
+    m_lastSeenPyramid.update();
+    m_bot.OnStartupStage("pyramids");
+}
+
+void MapTools::computeMapData()
+{
     // Set the boolean grid data from the Map
     for (int x(0); x < m_width; ++x)
     {
@@ -64,11 +144,6 @@ void MapTools::onStart()
     }
 
 #ifdef SC2API
-    for (auto & unit : m_bot.Observation()->GetUnits())
-    {
-        m_maxZ = std::max(unit->pos.z, m_maxZ);
-    }
-
     // set tiles that static resources are on as unbuildable
     for (auto & resource : m_bot.GetUnits())
     {
@@ -148,23 +223,267 @@ void MapTools::onStart()
     computeConnectivity();
 }
 
+bool MapTools::loadMapCache()
+{
+    if (!m_bot.Config().UseMapCache)
+    {
+        return false;
+    }
+
+    m_mapHash = MapCache::ComputeMapHash(m_bot);
+
+    if (!m_mapCache.load(getMapCacheFilename(), m_mapHash))
+    {
+        return false;
+    }
+
+    if (m_mapCache.width() != m_width || m_mapCache.height() != m_height)
+    {
+        m_mapCache.close();
+        return false;
+    }
+
+    const uint8_t * walkable       = m_mapCache.walkable();
+    const uint8_t * buildable      = m_mapCache.buildable();
+    const uint8_t * depotBuildable = m_mapCache.depotBuildable();
+    const int32_t * sectorNumbers  = m_mapCache.sectorNumbers();
+    const float *   terrainHeights = m_mapCache.terrainHeights();
+
+    for (int x(0); x < m_width; ++x)
+    {
+        for (int y(0); y < m_height; ++y)
+        {
+            const size_t i = (size_t)y * m_width + x;
+            m_walkable[x][y]       = walkable[i] != 0;
+            m_buildable[x][y]      = buildable[i] != 0;
+            m_depotBuildable[x][y] = depotBuildable[i] != 0;
+            m_sectorNumber[x][y]   = sectorNumbers[i];
+            m_terrainHeight[x][y]  = terrainHeights[i];
+        }
+    }
+
+    return true;
+}
+
+void MapTools::saveMapCache(const BaseLocationManager & bases) const
+{
+    if (!m_bot.Config().UseMapCache || m_mapCache.isLoaded())
+    {
+        return;
+    }
+
+    MapCache::Save(getMapCacheFilename(), m_mapHash, *this, bases);
+}
+
+const MapCache & MapTools::getMapCache() const
+{
+    return m_mapCache;
+}
+
+std::string MapTools::getMapCacheFilename() const
+{
+    std::stringstream ss;
+    ss << m_bot.Config().WriteDir << "mapcache_" << std::hex << m_mapHash << ".bin";
+    return ss.str();
+}
+
 void MapTools::onFrame()
 {
     m_frame++;
 
-    for (int x=0; x<m_width; ++x)
+    updateVisibility();
+    updatePower();
+    updateCreep();
+    updateStructures();
+    m_staleTiles.update(m_revealedTiles, m_hiddenTiles, m_frame - 1);
+    updateLastSeenPyramid();
+
+    if (m_frame % DistanceQueryWindowFrames == 0)
     {
-        for (int y=0; y<m_height; ++y)
+        m_distanceQueries.clear();
+    }
+
+    draw();
+
+    if (m_bot.Draw().isEnabled(DebugCategory::GameInfo))
+    {
+        drawTextScreen(0.01f, 0.01f, "FPS: " + std::to_string(m_bot.GetFramesPerSecond()));
+    }
+}
+
+void MapTools::readVisibility(std::vector<uint8_t> & visibility) const
+{
+#ifdef SC2API
+    // nothing has been seen yet on a map analyzed without a game
+    if (m_bot.GetStandInObservation())
+    {
+        std::fill(visibility.begin(), visibility.end(), TileHidden);
+        return;
+    }
+
+    // read the whole packed raster from the observation at once rather than querying tile by tile
+    const SC2APIProtocol::Observation * observation = m_bot.Observation()->GetRawObservation();
+    if (observation != nullptr && observation->has_raw_data() && observation->raw_data().has_map_state())
+    {
+        const SC2APIProtocol::ImageData & raster = observation->raw_data().map_state().visibility();
+        if (raster.bits_per_pixel() == 8 && raster.size().x() == m_width && raster.size().y() == m_height && raster.data().size() == visibility.size())
+        {
+            memcpy(visibility.data(), raster.data().data(), visibility.size());
+            return;
+        }
+    }
+
+    for (int y=0; y<m_height; ++y)
+    {
+        for (int x=0; x<m_width; ++x)
+        {
+            visibility[y * m_width + x] = (uint8_t)m_bot.Observation()->GetVisibility(CCPosition(x + HALF_TILE, y + HALF_TILE));
+        }
+    }
+#else
+    for (int y=0; y<m_height; ++y)
+    {
+        for (int x=0; x<m_width; ++x)
+        {
+            uint8_t vis = TileHidden;
+            if (BWAPI::Broodwar->isVisible(BWAPI::TilePosition(x, y)))       { vis = TileVisible; }
+            else if (BWAPI::Broodwar->isExplored(BWAPI::TilePosition(x, y))) { vis = TileFogged; }
+            visibility[y * m_width + x] = vis;
+        }
+    }
+#endif
+}
+
+void MapTools::updateVisibility()
+{
+    m_revealedTiles.clear();
+    m_hiddenTiles.clear();
+
+    std::swap(m_visibility, m_prevVisibility);
+    readVisibility(m_visibility);
+
+    const uint8_t * curr = m_visibility.data();
+    const uint8_t * prev = m_prevVisibility.data();
+    const size_t numTiles = m_visibility.size();
+
+    // compare 8 tiles at a time, most of the map doesn't change between frames
+    for (size_t i(0); i < numTiles; i += 8)
+    {
+        const size_t end = std::min(i + 8, numTiles);
+        if (end - i == 8)
         {
-            if (isVisible(x, y))
+            uint64_t currWord, prevWord;
+            memcpy(&currWord, curr + i, 8);
+            memcpy(&prevWord, prev + i, 8);
+            if (currWord == prevWord) { continue; }
+        }
+
+        for (size_t t(i); t < end; ++t)
+        {
+            const bool wasVisible = prev[t] == TileVisible;
+            const bool isVisible  = curr[t] == TileVisible;
+            if (wasVisible == isVisible) { continue; }
+
+            CCTilePosition tile((int)(t % m_width), (int)(t / m_width));
+            if (isVisible)
             {
-                m_lastSeen[x][y] = m_frame;
+                m_revealedTiles.push_back(tile);
+            }
+            else
+            {
+                // the tile was last seen on the previous frame
+                m_lastSeen[t] = m_frame - 1;
+                m_hiddenTiles.push_back(tile);
             }
         }
     }
+}
 
-    draw();
-    drawTextScreen(0.01f, 0.01f, "FPS: " + std::to_string(m_bot.GetFramesPerSecond()));
+void MapTools::updateLastSeenPyramid()
+{
+    for (auto & tile : m_revealedTiles)
+    {
+        m_lastSeenPyramid.set(tile.x, tile.y, INT_MAX);
+    }
+
+    for (auto & tile : m_hiddenTiles)
+    {
+        if (isTerrainWalkable(tile))
+        {
+            m_lastSeenPyramid.set(tile.x, tile.y, m_lastSeen[tile.y * m_width + tile.x]);
+        }
+    }
+
+    m_lastSeenPyramid.update();
+}
+
+const WalkablePyramid & MapTools::getWalkablePyramid() const
+{
+    return m_walkablePyramid;
+}
+
+const GridPyramid & MapTools::getLastSeenPyramid() const
+{
+    return m_lastSeenPyramid;
+}
+
+void MapTools::sortByGroundDistance(const CCPosition & pos, std::vector<CCPosition> & positions, size_t refine) const
+{
+    const int level = GridPyramid::Levels - 1;
+    const CCTilePosition from = Util::GetTilePosition(pos);
+
+    std::vector<int> cellDist;
+    m_walkablePyramid.computeDistances(from, level, cellDist);
+
+    auto rank = [&](const CCPosition & p)
+    {
+        CCTilePosition tile = Util::GetTilePosition(p);
+        int d = isValidTile(tile) ? cellDist[(tile.y >> level) * m_walkablePyramid.width(level) + (tile.x >> level)] : -1;
+        return d == -1 ? INT_MAX : d;
+    };
+
+    std::vector<std::pair<int, CCPosition>> ranked;
+    for (auto & p : positions)
+    {
+        ranked.push_back(std::make_pair(rank(p), p));
+    }
+
+    std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<int, CCPosition> & a, const std::pair<int, CCPosition> & b) { return a.first < b.first; });
+
+    // only the winners of the coarse ranking are measured exactly and re-sorted among themselves
+    const size_t exact = std::min(refine, ranked.size());
+    for (size_t i(0); i < exact; ++i)
+    {
+        if (ranked[i].first == INT_MAX) { continue; }
+
+        int d = getGroundDistance(ranked[i].second, pos);
+        ranked[i].first = d == -1 ? INT_MAX : d;
+    }
+
+    std::stable_sort(ranked.begin(), ranked.begin() + exact, [](const std::pair<int, CCPosition> & a, const std::pair<int, CCPosition> & b) { return a.first < b.first; });
+
+    for (size_t i(0); i < ranked.size(); ++i)
+    {
+        positions[i] = ranked[i].second;
+    }
+}
+
+const std::vector<CCTilePosition> & MapTools::getNewlyRevealedTiles() const
+{
+    return m_revealedTiles;
+}
+
+const std::vector<CCTilePosition> & MapTools::getNewlyHiddenTiles() const
+{
+    return m_hiddenTiles;
+}
+
+int MapTools::getLastSeen(int tileX, int tileY) const
+{
+    if (!isValidTile(tileX, tileY)) { return 0; }
+
+    // visible tiles are seen right now, the stored frame is only updated when a tile is hidden
+    return isVisible(tileX, tileY) ? m_frame : m_lastSeen[tileY * m_width + tileX];
 }
 
 void MapTools::computeConnectivity()
@@ -177,43 +496,538 @@ void MapTools::computeConnectivity()
     // for every tile on the map, do a connected flood fill using BFS
     for (int x=0; x<m_width; ++x)
     {
-        for (int y=0; y<m_height; ++y)
+        for (int y=0; y<m_height; ++y)
+        {
+            // if the sector is not currently 0, or the map isn't walkable here, then we can skip this tile
+            if (getSectorNumber(x, y) != 0 || !isWalkable(x, y))
+            {
+                continue;
+            }
+
+            // increase the sector number, so that walkable tiles have sectors 1-N
+            sectorNumber++;
+
+            // reset the fringe for the search and add the start tile to it
+            fringe.clear();
+            fringe.push_back({x,y});
+            m_sectorNumber[x][y] = sectorNumber;
+
+            // do the BFS, stopping when we reach the last element of the fringe
+            for (size_t fringeIndex=0; fringeIndex<fringe.size(); ++fringeIndex)
+            {
+                auto & tile = fringe[fringeIndex];
+
+                // check every possible child of this tile
+                for (size_t a=0; a<LegalActions; ++a)
+                {
+                    int nextX = tile[0] + actionX[a];
+                    int nextY = tile[1] + actionY[a];
+
+                    // if the new tile is inside the map bounds, is walkable, and has not been assigned a sector, add it to the current sector and the fringe
+                    if (isValidTile(nextX, nextY) && isWalkable(nextX, nextY) && (getSectorNumber(nextX, nextY) == 0))
+                    {
+                        m_sectorNumber[nextX][nextY] = sectorNumber;
+                        fringe.push_back({nextX, nextY});
+                    }
+                }
+            }
+        }
+    }
+}
+
+void MapTools::computeSectorSizes()
+{
+    m_sectorSizes.assign(1, 0);
+    for (int x=0; x<m_width; ++x)
+    {
+        for (int y=0; y<m_height; ++y)
+        {
+            int sector = m_sectorNumber[x][y];
+            if (sector >= (int)m_sectorSizes.size())
+            {
+                m_sectorSizes.resize(sector + 1, 0);
+            }
+
+            if (sector != 0)
+            {
+                m_sectorSizes[sector]++;
+            }
+        }
+    }
+}
+
+// the tiles a unit blocks for ground units: landed buildings, and the rocks that block paths until destroyed
+bool MapTools::getStructureFootprint(const Unit & unit, Structure & structure) const
+{
+    const UnitType & type = unit.getType();
+    if (!unit.isValid() || unit.isFlying() || type.isMineral() || type.isGeyser())
+    {
+        return false;
+    }
+
+    structure.unitID   = unit.getID();
+    structure.obstacle = unit.getPlayer() == Players::Neutral && type.isDestructibleObstacle();
+    if (!type.isBuilding() && !structure.obstacle)
+    {
+        return false;
+    }
+
+#ifdef SC2API
+    // lowered supply depots can be walked over
+    if (type.is(sc2::UNIT_TYPEID::TERRAN_SUPPLYDEPOTLOWERED))
+    {
+        return false;
+    }
+
+    // rocks aren't in the tech tree, so their square footprint follows from their radius
+    if (structure.obstacle)
+    {
+        structure.width  = std::max(1, (int)(unit.getUnitPtr()->radius * 2));
+        structure.height = structure.width;
+    }
+    else
+    {
+        structure.width  = type.tileWidth();
+        structure.height = type.tileHeight();
+    }
+
+    structure.topLeft = CCTilePosition((int)std::floor(unit.getPosition().x) - (structure.width / 2), (int)std::floor(unit.getPosition().y) - (structure.height / 2));
+#else
+    structure.width   = type.tileWidth();
+    structure.height  = type.tileHeight();
+    structure.topLeft = unit.getTilePosition();
+#endif
+
+    return true;
+}
+
+// diffs the structures in this frame's unit list against the tracked ones, a building that was placed, destroyed,
+// lifted off or landed changes the tiles under it, and everything computed from walkability is updated for those tiles
+void MapTools::updateStructures()
+{
+    m_changedTiles.clear();
+    m_addedStructures.clear();
+
+    std::vector<std::pair<CCUnitID, Structure>> added;
+    for (auto & unit : m_bot.GetUnits())
+    {
+        Structure structure;
+        if (!getStructureFootprint(unit, structure))
+        {
+            continue;
+        }
+
+        structure.lastSeen = m_frame;
+
+        auto it = m_structureIDs.find(unit.getID());
+        if (it != m_structureIDs.end())
+        {
+            Structure & tracked = m_structures[it->second];
+            if (tracked.topLeft.x == structure.topLeft.x && tracked.topLeft.y == structure.topLeft.y && tracked.width == structure.width && tracked.height == structure.height)
+            {
+                tracked.lastSeen = m_frame;
+                continue;
+            }
+        }
+
+        // a building that landed somewhere else is removed from its old footprint below and added at the new one
+        added.push_back(std::make_pair(unit.getID(), structure));
+        m_addedStructures.push_back(unit.getID());
+    }
+
+    std::vector<int> removed;
+    for (auto & kv : m_structures)
+    {
+        if (kv.second.lastSeen != m_frame)
+        {
+            removed.push_back(kv.first);
+        }
+    }
+
+    if (added.empty() && removed.empty())
+    {
+        return;
+    }
+
+    // remember how every tile under a changed footprint looked, what differs afterwards is what changed
+    std::vector<int> tiles;
+    auto addFootprint = [&](const Structure & structure)
+    {
+        for (int x=structure.topLeft.x; x<structure.topLeft.x + structure.width; ++x)
+        {
+            for (int y=structure.topLeft.y; y<structure.topLeft.y + structure.height; ++y)
+            {
+                if (isValidTile(x, y)) { tiles.push_back(y * m_width + x); }
+            }
+        }
+    };
+
+    for (int id : removed)       { addFootprint(m_structures[id]); }
+    for (auto & kv : added)      { addFootprint(kv.second); }
+    std::sort(tiles.begin(), tiles.end());
+    tiles.erase(std::unique(tiles.begin(), tiles.end()), tiles.end());
+
+    std::vector<std::pair<bool, int>> before;
+    before.reserve(tiles.size());
+    for (int index : tiles)
+    {
+        before.push_back(std::make_pair(isWalkable(index % m_width, index / m_width), m_structureAt[index]));
+    }
+
+    for (int id : removed)
+    {
+        const Structure & structure = m_structures[id];
+        for (int index : tiles)
+        {
+            if (m_structureAt[index] != id) { continue; }
+
+            m_structureAt[index] = 0;
+            if (structure.obstacle)
+            {
+                m_walkable[index % m_width][index / m_width] = true;
+            }
+        }
+
+        auto it = m_structureIDs.find(structure.unitID);
+        if (it != m_structureIDs.end() && it->second == id)
+        {
+            m_structureIDs.erase(it);
+        }
+
+        m_structures.erase(id);
+    }
+
+    for (auto & kv : added)
+    {
+        const int id = m_nextStructureID++;
+        m_structures[id] = kv.second;
+        m_structureIDs[kv.first] = id;
+
+        const Structure & structure = kv.second;
+        for (int x=std::max(0, structure.topLeft.x); x<std::min(m_width, structure.topLeft.x + structure.width); ++x)
+        {
+            for (int y=std::max(0, structure.topLeft.y); y<std::min(m_height, structure.topLeft.y + structure.height); ++y)
+            {
+                if (m_structureAt[y * m_width + x] == 0)
+                {
+                    m_structureAt[y * m_width + x] = id;
+                }
+            }
+        }
+    }
+
+    std::vector<CCTilePosition> blocked;
+    std::vector<CCTilePosition> opened;
+    for (size_t i(0); i < tiles.size(); ++i)
+    {
+        const CCTilePosition tile(tiles[i] % m_width, tiles[i] / m_width);
+        const bool walkable = isWalkable(tile);
+
+        if (walkable != before[i].first)
+        {
+            (walkable ? opened : blocked).push_back(tile);
+        }
+
+        if (walkable != before[i].first || m_structureAt[tiles[i]] != before[i].second)
+        {
+            m_changedTiles.push_back(tile);
+        }
+    }
+
+    if (!m_changedTiles.empty())
+    {
+        onTerrainChanged(blocked, opened);
+    }
+}
+
+// only the distance maps and flow fields whose search went through the changed tiles are repaired or dropped
+void MapTools::onTerrainChanged(const std::vector<CCTilePosition> & blocked, const std::vector<CCTilePosition> & opened)
+{
+    for (auto & tile : m_changedTiles)
+    {
+        m_pathFinder.setWalkable(tile.x, tile.y, isWalkable(tile));
+    }
+
+    updateSectors(blocked, opened);
+    m_walkablePyramid.update(*this, m_changedTiles);
+
+    for (auto & kv : m_allMaps)
+    {
+        kv.second->repair(m_bot, m_changedTiles);
+    }
+
+    for (auto it = m_retainedMaps.begin(); it != m_retainedMaps.end(); )
+    {
+        std::shared_ptr<DistanceMap> distanceMap = it->lock();
+        if (!distanceMap)
+        {
+            it = m_retainedMaps.erase(it);
+            continue;
+        }
+
+        distanceMap->repair(m_bot, m_changedTiles);
+        ++it;
+    }
+
+    for (auto it = m_flowFields.begin(); it != m_flowFields.end(); )
+    {
+        if (it->second.crosses(m_changedTiles))
+        {
+            m_flowFieldLastUsed.erase(it->first);
+            it = m_flowFields.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void MapTools::updateSectors(const std::vector<CCTilePosition> & blocked, const std::vector<CCTilePosition> & opened)
+{
+    // blocked tiles leave their sector, which splits it if they closed a wall through it
+    std::vector<int> touched;
+    for (auto & tile : blocked)
+    {
+        int & sector = m_sectorNumber[tile.x][tile.y];
+        if (sector != 0)
+        {
+            m_sectorSizes[sector]--;
+            touched.push_back(sector);
+            sector = 0;
+        }
+    }
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for (int sector : touched)
+    {
+        std::vector<CCTilePosition> seeds;
+        for (auto & tile : blocked)
+        {
+            for (size_t a=0; a<LegalActions; ++a)
+            {
+                CCTilePosition next(tile.x + actionX[a], tile.y + actionY[a]);
+                if (!isValidTile(next) || m_sectorNumber[next.x][next.y] != sector) { continue; }
+
+                bool seen = false;
+                for (auto & seed : seeds) { seen = seen || (seed.x == next.x && seed.y == next.y); }
+                if (!seen) { seeds.push_back(next); }
+            }
+        }
+
+        if (seeds.size() > 1)
+        {
+            splitSector(sector, seeds);
+        }
+    }
+
+    // opened tiles join the sector around them, and merge the sectors they connect into the largest one
+    for (auto & tile : opened)
+    {
+        int sector = 0;
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            CCTilePosition next(tile.x + actionX[a], tile.y + actionY[a]);
+            if (!isValidTile(next)) { continue; }
+
+            int neighbor = m_sectorNumber[next.x][next.y];
+            if (neighbor != 0 && (sector == 0 || m_sectorSizes[neighbor] > m_sectorSizes[sector]))
+            {
+                sector = neighbor;
+            }
+        }
+
+        if (sector == 0)
+        {
+            sector = (int)m_sectorSizes.size();
+            m_sectorSizes.push_back(0);
+        }
+
+        m_sectorNumber[tile.x][tile.y] = sector;
+        m_sectorSizes[sector]++;
+
+        for (size_t a=0; a<LegalActions; ++a)
+        {
+            CCTilePosition next(tile.x + actionX[a], tile.y + actionY[a]);
+            if (!isValidTile(next)) { continue; }
+
+            int neighbor = m_sectorNumber[next.x][next.y];
+            if (neighbor != 0 && neighbor != sector)
+            {
+                relabelSector(next, neighbor, sector);
+            }
+        }
+    }
+}
+
+// searches from every seed at once, one tile per seed in turn, and merges searches that meet. a group of searches
+// that runs out of tiles is cut off from the rest and becomes a sector of its own, so only the smaller parts are walked
+void MapTools::splitSector(int sector, const std::vector<CCTilePosition> & seeds)
+{
+    const int numSeeds = (int)seeds.size();
+    std::vector<int> owner(m_width * m_height, -1);
+    std::vector<int> group(numSeeds);
+    std::vector<std::vector<CCTilePosition>> reached(numSeeds);
+    std::vector<size_t> next(numSeeds, 0);
+
+    auto find = [&](int s)
+    {
+        while (group[s] != s) { group[s] = group[group[s]]; s = group[s]; }
+        return s;
+    };
+
+    for (int s(0); s < numSeeds; ++s)
+    {
+        group[s] = s;
+        reached[s].push_back(seeds[s]);
+        owner[seeds[s].y * m_width + seeds[s].x] = s;
+    }
+
+    int searching = -1;
+    while (true)
+    {
+        for (int s(0); s < numSeeds; ++s)
+        {
+            if (next[s] == reached[s].size()) { continue; }
+
+            const CCTilePosition tile = reached[s][next[s]++];
+            for (size_t a=0; a<LegalActions; ++a)
+            {
+                CCTilePosition n(tile.x + actionX[a], tile.y + actionY[a]);
+                if (!isValidTile(n) || m_sectorNumber[n.x][n.y] != sector) { continue; }
+
+                int & o = owner[n.y * m_width + n.x];
+                if (o == -1)
+                {
+                    o = s;
+                    reached[s].push_back(n);
+                }
+                else
+                {
+                    group[find(o)] = find(s);
+                }
+            }
+        }
+
+        // a group is still searching while any of its searches has tiles left
+        std::vector<uint8_t> isRoot(numSeeds, 0);
+        std::vector<uint8_t> isSearching(numSeeds, 0);
+        for (int s(0); s < numSeeds; ++s)
+        {
+            isRoot[find(s)] = 1;
+            if (next[s] < reached[s].size()) { isSearching[find(s)] = 1; }
+        }
+
+        int roots = 0;
+        int searchingRoots = 0;
+        for (int s(0); s < numSeeds; ++s)
+        {
+            roots += isRoot[s];
+            searchingRoots += isSearching[s];
+            if (isSearching[s]) { searching = s; }
+        }
+
+        // every seed is still connected to every other one, so the sector didn't split
+        if (roots == 1)
+        {
+            return;
+        }
+
+        if (searchingRoots <= 1)
+        {
+            if (searchingRoots == 0) { searching = -1; }
+            break;
+        }
+    }
+
+    // the group still searching keeps the sector number, if every group finished the largest one keeps it
+    std::vector<size_t> groupSize(numSeeds, 0);
+    for (int s(0); s < numSeeds; ++s)
+    {
+        groupSize[find(s)] += reached[s].size();
+    }
+
+    int keep = searching;
+    if (keep == -1)
+    {
+        keep = 0;
+        for (int s(0); s < numSeeds; ++s)
+        {
+            if (groupSize[s] > groupSize[keep]) { keep = s; }
+        }
+    }
+
+    std::map<int, int> newSectors;
+    for (int s(0); s < numSeeds; ++s)
+    {
+        int root = find(s);
+        if (root == keep) { continue; }
+
+        if (newSectors.find(root) == newSectors.end())
+        {
+            newSectors[root] = (int)m_sectorSizes.size();
+            m_sectorSizes.push_back(0);
+        }
+
+        const int newSector = newSectors[root];
+        for (auto & tile : reached[s])
+        {
+            m_sectorNumber[tile.x][tile.y] = newSector;
+        }
+
+        m_sectorSizes[newSector] += (int)reached[s].size();
+        m_sectorSizes[sector]    -= (int)reached[s].size();
+    }
+}
+
+void MapTools::relabelSector(const CCTilePosition & start, int from, int to)
+{
+    std::vector<CCTilePosition> fringe;
+    fringe.push_back(start);
+    m_sectorNumber[start.x][start.y] = to;
+
+    for (size_t fringeIndex=0; fringeIndex<fringe.size(); ++fringeIndex)
+    {
+        const CCTilePosition tile = fringe[fringeIndex];
+        for (size_t a=0; a<LegalActions; ++a)
         {
-            // if the sector is not currently 0, or the map isn't walkable here, then we can skip this tile
-            if (getSectorNumber(x, y) != 0 || !isWalkable(x, y))
+            CCTilePosition next(tile.x + actionX[a], tile.y + actionY[a]);
+            if (isValidTile(next) && m_sectorNumber[next.x][next.y] == from)
             {
-                continue;
+                m_sectorNumber[next.x][next.y] = to;
+                fringe.push_back(next);
             }
+        }
+    }
 
-            // increase the sector number, so that walkable tiles have sectors 1-N
-            sectorNumber++;
+    m_sectorSizes[to]   += (int)fringe.size();
+    m_sectorSizes[from] -= (int)fringe.size();
+}
 
-            // reset the fringe for the search and add the start tile to it
-            fringe.clear();
-            fringe.push_back({x,y});
-            m_sectorNumber[x][y] = sectorNumber;
+// structure tiles belong to the sector around the structure, which is where units walking to it end up
+int MapTools::getStructureSector(int structure) const
+{
+    auto it = m_structures.find(structure);
+    if (it == m_structures.end())
+    {
+        return 0;
+    }
 
-            // do the BFS, stopping when we reach the last element of the fringe
-            for (size_t fringeIndex=0; fringeIndex<fringe.size(); ++fringeIndex)
+    const Structure & s = it->second;
+    for (int x=s.topLeft.x - 1; x<=s.topLeft.x + s.width; ++x)
+    {
+        for (int y=s.topLeft.y - 1; y<=s.topLeft.y + s.height; y += (x < s.topLeft.x || x == s.topLeft.x + s.width) ? 1 : s.height + 1)
+        {
+            if (isValidTile(x, y) && m_sectorNumber[x][y] != 0)
             {
-                auto & tile = fringe[fringeIndex];
-
-                // check every possible child of this tile
-                for (size_t a=0; a<LegalActions; ++a)
-                {
-                    int nextX = tile[0] + actionX[a];
-                    int nextY = tile[1] + actionY[a];
-
-                    // if the new tile is inside the map bounds, is walkable, and has not been assigned a sector, add it to the current sector and the fringe
-                    if (isValidTile(nextX, nextY) && isWalkable(nextX, nextY) && (getSectorNumber(nextX, nextY) == 0))
-                    {
-                        m_sectorNumber[nextX][nextY] = sectorNumber;
-                        fringe.push_back({nextX, nextY});
-                    }
-                }
+                return m_sectorNumber[x][y];
             }
         }
     }
+
+    return 0;
 }
 
 bool MapTools::isExplored(const CCTilePosition & pos) const
@@ -230,39 +1044,76 @@ bool MapTools::isExplored(int tileX, int tileY) const
 {
     if (!isValidTile(tileX, tileY)) { return false; }
 
-#ifdef SC2API
-    sc2::Visibility vis = m_bot.Observation()->GetVisibility(CCPosition(tileX + HALF_TILE, tileY + HALF_TILE));
-    return vis == sc2::Visibility::Fogged || vis == sc2::Visibility::Visible;
-#else
-    return BWAPI::Broodwar->isExplored(tileX, tileY);
-#endif
+    uint8_t vis = m_visibility[tileY * m_width + tileX];
+    return vis == TileFogged || vis == TileVisible;
 }
 
 bool MapTools::isVisible(int tileX, int tileY) const
 {
     if (!isValidTile(tileX, tileY)) { return false; }
 
+    return m_visibility[tileY * m_width + tileX] == TileVisible;
+}
+
+bool MapTools::isPowered(int tileX, int tileY) const
+{
 #ifdef SC2API
-    return m_bot.Observation()->GetVisibility(CCPosition(tileX + HALF_TILE, tileY + HALF_TILE)) == sc2::Visibility::Visible;
+    return isValidTile(tileX, tileY) && m_powered[tileY * m_width + tileX];
 #else
-    return BWAPI::Broodwar->isVisible(BWAPI::TilePosition(tileX, tileY));
+    return BWAPI::Broodwar->hasPower(BWAPI::TilePosition(tileX, tileY));
 #endif
 }
 
-bool MapTools::isPowered(int tileX, int tileY) const
+// only filled for sc2, bwapi answers power queries itself
+const std::vector<CCTilePosition> & MapTools::getPoweredTiles() const
+{
+    return m_poweredTiles;
+}
+
+void MapTools::updatePower()
 {
 #ifdef SC2API
-    for (auto & powerSource : m_bot.Observation()->GetPowerSources())
+    const std::vector<sc2::PowerSource> & powerSources = m_bot.Observation()->GetPowerSources();
+
+    // the raster only has to be rebuilt when a pylon or warp prism appears, disappears or moves
+    bool changed = powerSources.size() != m_powerSources.size();
+    for (size_t i(0); !changed && i < powerSources.size(); ++i)
+    {
+        changed = powerSources[i].tag != m_powerSources[i].tag
+               || powerSources[i].position.x != m_powerSources[i].position.x
+               || powerSources[i].position.y != m_powerSources[i].position.y
+               || powerSources[i].radius != m_powerSources[i].radius;
+    }
+
+    if (!changed)
+    {
+        return;
+    }
+
+    m_powerSources = powerSources;
+    std::fill(m_powered.begin(), m_powered.end(), (uint8_t)0);
+    m_poweredTiles.clear();
+
+    for (auto & powerSource : m_powerSources)
     {
-        if (Util::Dist(CCPosition(tileX + HALF_TILE, tileY + HALF_TILE), powerSource.position) < powerSource.radius)
+        int minX = std::max(0, (int)(powerSource.position.x - powerSource.radius));
+        int minY = std::max(0, (int)(powerSource.position.y - powerSource.radius));
+        int maxX = std::min(m_width - 1, (int)(powerSource.position.x + powerSource.radius));
+        int maxY = std::min(m_height - 1, (int)(powerSource.position.y + powerSource.radius));
+
+        for (int y(minY); y <= maxY; ++y)
         {
-            return true;
+            for (int x(minX); x <= maxX; ++x)
+            {
+                uint8_t & powered = m_powered[y * m_width + x];
+                if (!powered && Util::Dist(CCPosition(x + HALF_TILE, y + HALF_TILE), powerSource.position) < powerSource.radius)
+                {
+                    powered = 1;
+                    m_poweredTiles.push_back(CCTilePosition(x, y));
+                }
+            }
         }
     }
-
-    return false;
-#else
-    return BWAPI::Broodwar->hasPower(BWAPI::TilePosition(tileX, tileY));
 #endif
 }
 
@@ -276,11 +1127,48 @@ float MapTools::terrainHeight(float x, float y) const
 //    return (int)Util::Dist(src, dest);
 //}
 
+// walk distance through the region graph, static terrain only, for estimates that don't need a search
+int MapTools::getApproxGroundDistance(const CCPosition & src, const CCPosition & dest) const
+{
+    return m_regions.getGroundDistance(Util::GetTilePosition(src), Util::GetTilePosition(dest));
+}
+
+const RegionMap & MapTools::getRegionMap() const
+{
+    return m_regions;
+}
+
 int MapTools::getGroundDistance(const CCPosition & src, const CCPosition & dest) const
 {
-    if (m_allMaps.size() > 50)
+    CCTilePosition srcTile = Util::GetTilePosition(src);
+    CCTilePosition destTile = Util::GetTilePosition(dest);
+    std::pair<int, int> destKey(destTile.x, destTile.y);
+
+    // a destination asked about by only a few units is answered with a point to point search,
+    // once it is asked about often enough a distance map for it answers every later query.
+    // the point to point search can't start or end inside a structure, while distance maps reach structure tiles
+    const bool onStructure = getStructureAt(srcTile.x, srcTile.y) != 0 || getStructureAt(destTile.x, destTile.y) != 0;
+    if (!onStructure && m_allMaps.find(destKey) == m_allMaps.end() && ++m_distanceQueries[destKey] < DistanceMapQueryThreshold)
+    {
+        if (!isValidTile(srcTile))
+        {
+            return -1;
+        }
+
+        // tiles in different walkable sectors are never connected, which saves searching the whole sector
+        int srcSector = getSectorNumber(srcTile.x, srcTile.y);
+        int destSector = getSectorNumber(destTile.x, destTile.y);
+        if (srcSector != 0 && destSector != 0 && srcSector != destSector)
+        {
+            return -1;
+        }
+
+        return m_pathFinder.getGroundDistance(srcTile, destTile);
+    }
+
+    if (m_allMaps.size() > MaxDistanceMaps)
     {
-        m_allMaps.clear();
+        clearDistanceMaps();
     }
 
     return getDistanceMap(dest).getDistance(src);
@@ -292,16 +1180,135 @@ const DistanceMap & MapTools::getDistanceMap(const CCPosition & pos) const
 }
 
 const DistanceMap & MapTools::getDistanceMap(const CCTilePosition & tile) const
+{
+    return *getSharedDistanceMap(tile);
+}
+
+std::shared_ptr<const DistanceMap> MapTools::getSharedDistanceMap(const CCPosition & pos) const
+{
+    return getSharedDistanceMap(Util::GetTilePosition(pos));
+}
+
+std::shared_ptr<const DistanceMap> MapTools::getSharedDistanceMap(const CCTilePosition & tile) const
 {
     std::pair<int,int> pairTile(tile.x, tile.y);
 
-    if (m_allMaps.find(pairTile) == m_allMaps.end())
+    std::shared_ptr<DistanceMap> & distanceMap = m_allMaps[pairTile];
+    if (!distanceMap)
+    {
+        // a map evicted while someone still shared it is up to date, so it is taken back rather than computed again
+        for (auto it = m_retainedMaps.begin(); it != m_retainedMaps.end(); ++it)
+        {
+            std::shared_ptr<DistanceMap> retained = it->lock();
+            if (retained && retained->getStartTile().x == tile.x && retained->getStartTile().y == tile.y)
+            {
+                distanceMap = retained;
+                m_retainedMaps.erase(it);
+                return distanceMap;
+            }
+        }
+
+        distanceMap = std::make_shared<DistanceMap>();
+
+        // reuse the buffers of an evicted distance map if there is one
+        if (!m_distanceMapPool.empty())
+        {
+            *distanceMap = std::move(m_distanceMapPool.back());
+            m_distanceMapPool.pop_back();
+        }
+
+        distanceMap->computeDistanceMap(m_bot, tile);
+    }
+
+    return distanceMap;
+}
+
+// lets a distance map computed elsewhere (e.g. read from the map cache) answer this cache's queries
+void MapTools::addSharedDistanceMap(const std::shared_ptr<DistanceMap> & distanceMap) const
+{
+    const CCTilePosition & tile = distanceMap->getStartTile();
+    m_allMaps[std::pair<int, int>(tile.x, tile.y)] = distanceMap;
+}
+
+void MapTools::clearDistanceMaps() const
+{
+    for (auto & kv : m_allMaps)
+    {
+        // maps still shared with someone else stay alive with them, only our own can be recycled
+        if (kv.second.use_count() == 1 && m_distanceMapPool.size() < MaxPooledDistanceMaps)
+        {
+            m_distanceMapPool.push_back(std::move(*kv.second));
+        }
+        else if (kv.second.use_count() > 1)
+        {
+            m_retainedMaps.push_back(kv.second);
+        }
+    }
+
+    m_retainedMaps.erase(std::remove_if(m_retainedMaps.begin(), m_retainedMaps.end(),
+        [](const std::weak_ptr<DistanceMap> & distanceMap) { return distanceMap.expired(); }), m_retainedMaps.end());
+
+    m_allMaps.clear();
+}
+
+size_t MapTools::getDistanceMapMemory(std::set<const DistanceMap *> & counted) const
+{
+    size_t bytes = 0;
+    for (auto & kv : m_allMaps)
+    {
+        if (counted.insert(kv.second.get()).second)
+        {
+            bytes += kv.second->getMemoryUsage();
+        }
+    }
+
+    for (auto & distanceMap : m_distanceMapPool)
+    {
+        bytes += distanceMap.getMemoryUsage();
+    }
+
+    return bytes;
+}
+
+const FlowField & MapTools::getFlowField(const CCPosition & target) const
+{
+    CCTilePosition tile = Util::GetTilePosition(target);
+    std::pair<int, int> pairTile(tile.x, tile.y);
+    m_flowFieldLastUsed[pairTile] = m_frame;
+
+    auto it = m_flowFields.find(pairTile);
+    if (it != m_flowFields.end())
+    {
+        return it->second;
+    }
+
+    // recycle the least recently used flow field, or the buffers of an evicted distance map
+    FlowField flowField;
+    if (m_flowFields.size() >= MaxFlowFields)
+    {
+        auto oldest = m_flowFields.begin();
+        for (auto fit = m_flowFields.begin(); fit != m_flowFields.end(); ++fit)
+        {
+            if (m_flowFieldLastUsed[fit->first] < m_flowFieldLastUsed[oldest->first])
+            {
+                oldest = fit;
+            }
+        }
+
+        flowField = std::move(oldest->second);
+        m_flowFieldLastUsed.erase(oldest->first);
+        m_flowFields.erase(oldest);
+    }
+    else if (!m_distanceMapPool.empty())
     {
-        m_allMaps[pairTile] = DistanceMap();
-        m_allMaps[pairTile].computeDistanceMap(m_bot, tile);
+        flowField = FlowField(std::move(m_distanceMapPool.back()));
+        m_distanceMapPool.pop_back();
     }
 
-    return m_allMaps[pairTile];
+    flowField.computeFlowField(m_bot, tile);
+    FlowField & stored = m_flowFields[pairTile];
+    stored = std::move(flowField);
+    return stored;
 }
 
 int MapTools::getSectorNumber(int x, int y) const
@@ -311,6 +1318,12 @@ int MapTools::getSectorNumber(int x, int y) const
         return 0;
     }
 
+    const int structure = m_structureAt[y * m_width + x];
+    if (structure != 0 && m_sectorNumber[x][y] == 0)
+    {
+        return getStructureSector(structure);
+    }
+
     return m_sectorNumber[x][y];
 }
 
@@ -332,19 +1345,15 @@ bool MapTools::isValidPosition(const CCPosition & pos) const
 void MapTools::drawLine(CCPositionType x1, CCPositionType y1, CCPositionType x2, CCPositionType y2, const CCColor & color) const
 {
 #ifdef SC2API
-    m_bot.Debug()->DebugLineOut(sc2::Point3D(x1, y1, terrainHeight(x1, y1) + 0.2f), sc2::Point3D(x2, y2, terrainHeight(x2, y2) + 0.2f), color);
+    m_bot.Draw().line(CCPosition(x1, y1), terrainHeight(x1, y1) + 0.2f, CCPosition(x2, y2), terrainHeight(x2, y2) + 0.2f, color);
 #else
-    BWAPI::Broodwar->drawLineMap(BWAPI::Position(x1, y1), BWAPI::Position(x2, y2), color);
+    m_bot.Draw().line(CCPosition(x1, y1), 0.0f, CCPosition(x2, y2), 0.0f, color);
 #endif
 }
 
 void MapTools::drawLine(const CCPosition & p1, const CCPosition & p2, const CCColor & color) const
 {
-#ifdef SC2API
     drawLine(p1.x, p1.y, p2.x, p2.y, color);
-#else
-    BWAPI::Broodwar->drawLineMap(p1, p2, color);
-#endif
 }
 
 void MapTools::drawTile(int tileX, int tileY, const CCColor & color) const
@@ -361,59 +1370,36 @@ void MapTools::drawTile(int tileX, int tileY, const CCColor & color) const
 
 void MapTools::drawBox(CCPositionType x1, CCPositionType y1, CCPositionType x2, CCPositionType y2, const CCColor & color) const
 {
-#ifdef SC2API
-    m_bot.Debug()->DebugBoxOut(sc2::Point3D(x1, y1, m_maxZ + 2.0f), sc2::Point3D(x2, y2, m_maxZ-5.0f), color);
-#else
-    drawLine(x1, y1, x1, y2, color);
-    drawLine(x1, y2, x2, y2, color);
-    drawLine(x2, y2, x2, y1, color);
-    drawLine(x2, y1, x1, y1, color);
-#endif
+    m_bot.Draw().box(CCPosition(x1, y1), m_maxZ + 2.0f, CCPosition(x2, y2), m_maxZ - 5.0f, color);
 }
 
 void MapTools::drawBox(const CCPosition & tl, const CCPosition & br, const CCColor & color) const
 {
-#ifdef SC2API
-    m_bot.Debug()->DebugBoxOut(sc2::Point3D(tl.x, tl.y, m_maxZ + 2.0f), sc2::Point3D(br.x, br.y, m_maxZ-5.0f), color);
-#else
-    drawBox(tl.x, tl.y, br.x, br.y, color);
-#endif
+    m_bot.Draw().box(tl, m_maxZ + 2.0f, br, m_maxZ - 5.0f, color);
 }
 
 void MapTools::drawCircle(const CCPosition & pos, CCPositionType radius, const CCColor & color) const
 {
-#ifdef SC2API
-    m_bot.Debug()->DebugSphereOut(sc2::Point3D(pos.x, pos.y, m_maxZ), radius, color);
-#else
-    BWAPI::Broodwar->drawCircleMap(pos, radius, color);
-#endif
+    m_bot.Draw().sphere(pos, m_maxZ, (float)radius, color);
 }
 
 void MapTools::drawCircle(CCPositionType x, CCPositionType y, CCPositionType radius, const CCColor & color) const
 {
-#ifdef SC2API
-    m_bot.Debug()->DebugSphereOut(sc2::Point3D(x, y, m_maxZ), radius, color);
-#else
-    BWAPI::Broodwar->drawCircleMap(BWAPI::Position(x, y), radius, color);
-#endif
+    m_bot.Draw().sphere(CCPosition(x, y), m_maxZ, (float)radius, color);
 }
 
 
 void MapTools::drawText(const CCPosition & pos, const std::string & str, const CCColor & color) const
 {
-#ifdef SC2API
-    m_bot.Debug()->DebugTextOut(str, sc2::Point3D(pos.x, pos.y, m_maxZ), color);
-#else
-    BWAPI::Broodwar->drawTextMap(pos, str.c_str());
-#endif
+    m_bot.Draw().text(pos, m_maxZ, str, color);
 }
 
 void MapTools::drawTextScreen(float xPerc, float yPerc, const std::string & str, const CCColor & color) const
 {
 #ifdef SC2API
-    m_bot.Debug()->DebugTextOut(str, CCPosition(xPerc, yPerc), color);
+    m_bot.Draw().textScreen(CCPosition(xPerc, yPerc), str, color);
 #else
-    BWAPI::Broodwar->drawTextScreen(BWAPI::Position((int)(640*xPerc), (int)(480*yPerc)), str.c_str());
+    m_bot.Draw().textScreen(BWAPI::Position((int)(640*xPerc), (int)(480*yPerc)), str, color);
 #endif
 }
 
@@ -453,9 +1439,97 @@ bool MapTools::isBuildable(int tileX, int tileY) const
     return m_buildable[tileX][tileY];
 }
 
+void MapTools::updateCreep()
+{
+#ifdef SC2API
+    // only zerg buildings need creep, so nobody else pays for unpacking the raster
+    if (m_bot.GetPlayerRace(Players::Self) != sc2::Race::Zerg)
+    {
+        return;
+    }
+
+    const SC2APIProtocol::Observation * observation = m_bot.Observation()->GetRawObservation();
+    if (observation == nullptr || !observation->has_raw_data() || !observation->raw_data().has_map_state())
+    {
+        return;
+    }
+
+    // the creep raster packs one tile per bit, most significant bit first like the pathing grid
+    const SC2APIProtocol::ImageData & raster = observation->raw_data().map_state().creep();
+    if (raster.bits_per_pixel() != 1 || raster.size().x() != m_width || raster.size().y() != m_height || raster.data().size() * 8 < m_creep.size())
+    {
+        return;
+    }
+
+    const std::string & data = raster.data();
+    for (size_t i(0); i < m_creep.size(); ++i)
+    {
+        m_creep[i] = (data[i / 8] >> (7 - (i % 8))) & 0x1;
+    }
+#endif
+}
+
+bool MapTools::hasCreep(int tileX, int tileY) const
+{
+    if (!isValidTile(tileX, tileY))
+    {
+        return false;
+    }
+
+#ifdef SC2API
+    return m_creep[tileY * m_width + tileX] != 0;
+#else
+    return BWAPI::Broodwar->hasCreep(tileX, tileY);
+#endif
+}
+
+void MapTools::canBuildTypeAtPositions(const UnitType & type, const std::vector<CCTilePosition> & tiles, std::vector<bool> & results) const
+{
+    results.clear();
+
+#ifdef SC2API
+    if (!m_bot.GetStandInObservation() && !tiles.empty())
+    {
+        std::vector<sc2::QueryInterface::PlacementQuery> queries;
+        queries.reserve(tiles.size());
+        for (auto & tile : tiles)
+        {
+            queries.push_back(sc2::QueryInterface::PlacementQuery(m_bot.Data(type).buildAbility, CCPosition((float)tile.x, (float)tile.y)));
+        }
+
+        results = m_bot.Query()->Placement(queries);
+        results.resize(tiles.size(), false);
+        return;
+    }
+#endif
+
+    for (auto & tile : tiles)
+    {
+        results.push_back(canBuildTypeAtPosition(tile.x, tile.y, type));
+    }
+}
+
 bool MapTools::canBuildTypeAtPosition(int tileX, int tileY, const UnitType & type) const
 {
 #ifdef SC2API
+    // without a game to ask, the footprint centered on the tile is checked against the static grids
+    if (m_bot.GetStandInObservation())
+    {
+        const bool depot = type.isResourceDepot();
+        for (int x = tileX - type.tileWidth() / 2; x < tileX - type.tileWidth() / 2 + type.tileWidth(); ++x)
+        {
+            for (int y = tileY - type.tileHeight() / 2; y < tileY - type.tileHeight() / 2 + type.tileHeight(); ++y)
+            {
+                if (!isValidTile(x, y) || !(depot ? isDepotBuildableTile(x, y) : isBuildable(x, y)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
     return m_bot.Query()->Placement(m_bot.Data(type).buildAbility, CCPosition((float)tileX, (float)tileY));
 #else
     return BWAPI::Broodwar->canBuildHere(BWAPI::TilePosition(tileX, tileY), type.getAPIUnitType());
@@ -502,7 +1576,7 @@ bool MapTools::isWalkable(int tileX, int tileY) const
         return false;
     }
 
-    return m_walkable[tileX][tileY];
+    return m_walkable[tileX][tileY] && m_structureAt[tileY * m_width + tileX] == 0;
 }
 
 bool MapTools::isWalkable(const CCTilePosition & tile) const
@@ -510,6 +1584,51 @@ bool MapTools::isWalkable(const CCTilePosition & tile) const
     return isWalkable(tile.x, tile.y);
 }
 
+bool MapTools::isTerrainWalkable(int tileX, int tileY) const
+{
+    if (!isValidTile(tileX, tileY))
+    {
+        return false;
+    }
+
+    return m_walkable[tileX][tileY];
+}
+
+bool MapTools::isTerrainWalkable(const CCTilePosition & tile) const
+{
+    return isTerrainWalkable(tile.x, tile.y);
+}
+
+bool MapTools::isBlocked(int tileX, int tileY) const
+{
+    return getStructureAt(tileX, tileY) != 0;
+}
+
+bool MapTools::isBlocked(const CCTilePosition & tile) const
+{
+    return isBlocked(tile.x, tile.y);
+}
+
+int MapTools::getStructureAt(int tileX, int tileY) const
+{
+    if (!isValidTile(tileX, tileY))
+    {
+        return 0;
+    }
+
+    return m_structureAt[tileY * m_width + tileX];
+}
+
+const std::vector<CCTilePosition> & MapTools::getChangedTiles() const
+{
+    return m_changedTiles;
+}
+
+const std::vector<CCUnitID> & MapTools::getAddedStructures() const
+{
+    return m_addedStructures;
+}
+
 int MapTools::width() const
 {
     return m_width;
@@ -520,36 +1639,33 @@ int MapTools::height() const
     return m_height;
 }
 
-const std::vector<CCTilePosition> & MapTools::getClosestTilesTo(const CCTilePosition & pos) const
+TileList MapTools::getClosestTilesTo(const CCTilePosition & pos) const
 {
     return getDistanceMap(pos).getSortedTiles();
 }
 
 CCTilePosition MapTools::getLeastRecentlySeenTile() const
 {
-    int minSeen = std::numeric_limits<int>::max();
     CCTilePosition leastSeen;
-    const BaseLocation * baseLocation = m_bot.Bases().getPlayerStartingBaseLocation(Players::Self);
 
-    for (auto & tile : baseLocation->getClosestTiles())
+    // every tile we can walk to is visible right now, so the closest one is as good as any
+    if (!m_staleTiles.getLeastRecentlySeenTile(leastSeen))
     {
-        BOT_ASSERT(isValidTile(tile), "How is this tile not valid?");
-
-        int lastSeen = m_lastSeen[tile.x][tile.y];
-        if (lastSeen < minSeen)
-        {
-            minSeen = lastSeen;
-            leastSeen = tile;
-        }
+        leastSeen = Util::GetTilePosition(m_bot.GetStartLocation());
     }
 
     return leastSeen;
 }
 
+void MapTools::getStalestTiles(const CCPosition & pos, float radius, size_t k, std::vector<CCTilePosition> & tiles) const
+{
+    m_staleTiles.getStalestTiles(pos, radius, k, tiles);
+}
+
 bool MapTools::canWalk(int tileX, int tileY) 
 {
 #ifdef SC2API
-    auto & info = m_bot.Observation()->GetGameInfo();
+    auto & info = m_bot.GetGameInfo();
     sc2::Point2DI pointI(tileX, tileY);
     if (pointI.x < 0 || pointI.x >= info.width || pointI.y < 0 || pointI.y >= info.height)
     {
@@ -581,7 +1697,7 @@ bool MapTools::canWalk(int tileX, int tileY)
 bool MapTools::canBuild(int tileX, int tileY) 
 {
 #ifdef SC2API
-    auto & info = m_bot.Observation()->GetGameInfo();
+    auto & info = m_bot.GetGameInfo();
     sc2::Point2DI pointI(tileX, tileY);
     if (pointI.x < 0 || pointI.x >= info.width || pointI.y < 0 || pointI.y >= info.height)
     {
@@ -602,7 +1718,7 @@ bool MapTools::canBuild(int tileX, int tileY)
 float MapTools::terrainHeight(const CCPosition & point) const
 {
 #ifdef SC2API
-    auto & info = m_bot.Observation()->GetGameInfo();
+    auto & info = m_bot.GetGameInfo();
     sc2::Point2DI pointI((int)point.x, (int)point.y);
     if (pointI.x < 0 || pointI.x >= info.width || pointI.y < 0 || pointI.y >= info.height)
     {
@@ -622,6 +1738,18 @@ float MapTools::terrainHeight(const CCPosition & point) const
 
 void MapTools::draw() const
 {
+    bool drawSectors = m_bot.Draw().isEnabled(DebugCategory::WalkableSectors);
+    bool drawTiles = m_bot.Draw().isEnabled(DebugCategory::TileInfo);
+    if (!drawSectors && !drawTiles)
+    {
+        return;
+    }
+
+    if (drawSectors)
+    {
+        m_regions.draw(*this);
+    }
+
 #ifdef SC2API
     CCPosition camera = m_bot.Observation()->GetCameraPos();
     int sx = (int)(camera.x - 12.0f);
@@ -646,14 +1774,14 @@ void MapTools::draw() const
                 continue;
             }
 
-            if (m_bot.Config().DrawWalkableSectors)
+            if (drawSectors)
             {
                 std::stringstream ss;
                 ss << getSectorNumber(x, y);
                 drawText(CCPosition(Util::TileToPosition(x + 0.5f), Util::TileToPosition(y + 0.5f)), ss.str());
             }
 
-            if (m_bot.Config().DrawTileInfo)
+            if (drawTiles)
             {
                 CCColor color = isWalkable(x, y) ? CCColor(0, 255, 0) : CCColor(255, 0, 0);
                 if (isWalkable(x, y) && !isBuildable(x, y)) { color = CCColor(255, 255, 0); }
@@ -2,34 +2,110 @@
 
 #include <vector>
 #include "DistanceMap.h"
+#include "MapCache.h"
+#include "RegionMap.h"
+#include "PathFinder.h"
+#include "FlowField.h"
+#include "MapPyramid.h"
+#include "StaleTileIndex.h"
 #include "UnitType.h"
 
 namespace CC
 {
     class CCBot;
+    class Unit;
+    class BaseLocationManager;
 
     class MapTools
     {
+        // the tiles a building or destructible obstacle blocks for ground units
+        struct Structure
+        {
+            CCUnitID        unitID;
+            CCTilePosition  topLeft;
+            int             width;
+            int             height;
+            bool            obstacle;   // rocks sit on unwalkable terrain, which becomes walkable once they are destroyed
+            int             lastSeen;   // the last frame the unit was in the unit list with this footprint
+        };
+
         CCBot & m_bot;
         int     m_width;
         int     m_height;
         float   m_maxZ;
         int     m_frame;
+        uint64_t m_mapHash;
+
+        // the static analysis of this map saved by a previous game, if there was one
+        MapCache m_mapCache;
+
+        // regions and chokepoints of the walkable map, used for fast approximate ground distances
+        RegionMap m_regions;
 
+        // point to point ground distance search for destinations that are only queried a few times
+        PathFinder m_pathFinder;
 
         // a cache of already computed distance maps, which is mutable since it only acts as a cache
-        mutable std::map<std::pair<int, int>, DistanceMap>   m_allMaps;
+        mutable std::map<std::pair<int, int>, std::shared_ptr<DistanceMap>> m_allMaps;
+
+        // maps evicted from the cache while someone else still shared them, which are kept up to date as long as they live
+        mutable std::vector<std::weak_ptr<DistanceMap>>      m_retainedMaps;
+
+        // how often each destination was asked for a ground distance recently, decides when a full distance map pays off
+        mutable std::map<std::pair<int, int>, int>           m_distanceQueries;
 
-        std::vector<std::vector<bool>>  m_walkable;         // whether a tile is buildable (includes static resources)
+        // evicted distance maps, whose buffers are reused by the next distance maps and flow fields computed
+        mutable std::vector<DistanceMap>                     m_distanceMapPool;
+
+        // flow fields shared by every unit heading to the same target, and the frame each was last used
+        mutable std::map<std::pair<int, int>, FlowField>     m_flowFields;
+        mutable std::map<std::pair<int, int>, int>           m_flowFieldLastUsed;
+
+        std::vector<std::vector<bool>>  m_walkable;         // whether the terrain of a tile is walkable, ignoring structures
         std::vector<std::vector<bool>>  m_buildable;        // whether a tile is buildable (includes static resources)
         std::vector<std::vector<bool>>  m_depotBuildable;   // whether a depot is buildable on a tile (illegal within 3 tiles of static resource)
-        std::vector<std::vector<int>>   m_lastSeen;         // the last time any of our units has seen this position on the map
+        std::vector<int>                m_lastSeen;         // the last frame a tile was visible, only updated when it stops being visible (row-major)
+        std::vector<uint8_t>            m_visibility;       // this frame's visibility raster (row-major, hidden / fogged / visible)
+        std::vector<uint8_t>            m_prevVisibility;   // last frame's visibility raster, diffed against the current one
+        std::vector<CCTilePosition>     m_revealedTiles;    // tiles that became visible this frame
+        std::vector<CCTilePosition>     m_hiddenTiles;      // tiles that stopped being visible this frame
+        StaleTileIndex                  m_staleTiles;       // hidden tiles ordered by when they were last seen
+        WalkablePyramid                 m_walkablePyramid;  // walkability and connectivity at 2x, 4x and 8x coarser resolution
+        GridPyramid                     m_lastSeenPyramid;  // last seen frame of hidden walkable tiles, INT_MAX for the rest
+        std::vector<uint8_t>            m_powered;          // whether one of our power sources covers a tile (row-major)
+        std::vector<CCTilePosition>     m_poweredTiles;     // every powered tile, for placement and warp-in searches
+        std::vector<uint8_t>            m_creep;            // whether a tile has creep, only read when we are zerg (row-major)
+#ifdef SC2API
+        std::vector<sc2::PowerSource>   m_powerSources;     // the power sources the power raster was built from
+#endif
         std::vector<std::vector<int>>   m_sectorNumber;     // connectivity sector number, two tiles are ground connected if they have the same number
+        std::vector<int>                m_sectorSizes;      // the number of tiles in each sector, indexed by sector number
+        std::map<int, Structure>        m_structures;       // every structure blocking tiles, by structure id
+        std::map<CCUnitID, int>         m_structureIDs;     // the structure id of each unit that blocks tiles
+        int                             m_nextStructureID;
+        std::vector<int>                m_structureAt;      // the id of the structure covering a tile, 0 if none (row-major)
+        std::vector<CCTilePosition>     m_changedTiles;     // tiles whose walkability or covering structure changed this frame
+        std::vector<CCUnitID>           m_addedStructures;  // units whose footprint appeared or moved this frame
         std::vector<std::vector<float>> m_terrainHeight;        // height of the map at x+0.5, y+0.5
 
+        void computeMapData();
         void computeConnectivity();
-
-        int getSectorNumber(int x, int y) const;
+        void computeSectorSizes();
+        void updateStructures();
+        bool getStructureFootprint(const Unit & unit, Structure & structure) const;
+        void onTerrainChanged(const std::vector<CCTilePosition> & blocked, const std::vector<CCTilePosition> & opened);
+        void updateSectors(const std::vector<CCTilePosition> & blocked, const std::vector<CCTilePosition> & opened);
+        void splitSector(int sector, const std::vector<CCTilePosition> & seeds);
+        void relabelSector(const CCTilePosition & start, int from, int to);
+        int  getStructureSector(int structure) const;
+        void clearDistanceMaps() const;
+        void updateVisibility();
+        void updatePower();
+        void updateCreep();
+        void updateLastSeenPyramid();
+        void readVisibility(std::vector<uint8_t> & visibility) const;
+        bool loadMapCache();
+        std::string getMapCacheFilename() const;
 
         void printMap();
 
@@ -48,6 +124,11 @@ namespace CC
         int     width() const;
         int     height() const;
         float   terrainHeight(float x, float y) const;
+        int     getSectorNumber(int x, int y) const;
+
+        // the map cache is only loaded if a previous game saved the analysis of this map
+        const   MapCache & getMapCache() const;
+        void    saveMapCache(const BaseLocationManager & bases) const;
 
         void    drawLine(CCPositionType x1, CCPositionType y1, CCPositionType x2, CCPositionType y2, const CCColor & color = CCColor(255, 255, 255)) const;
         void    drawLine(const CCPosition & p1, const CCPosition & p2, const CCColor & color = CCColor(255, 255, 255)) const;
@@ -63,28 +144,69 @@ namespace CC
         bool    isValidTile(const CCTilePosition & tile) const;
         bool    isValidPosition(const CCPosition & pos) const;
         bool    isPowered(int tileX, int tileY) const;
+        const   std::vector<CCTilePosition> & getPoweredTiles() const;
         bool    isExplored(int tileX, int tileY) const;
         bool    isExplored(const CCPosition & pos) const;
         bool    isExplored(const CCTilePosition & pos) const;
         bool    isVisible(int tileX, int tileY) const;
+        int     getLastSeen(int tileX, int tileY) const;
+        bool    hasCreep(int tileX, int tileY) const;
         bool    canBuildTypeAtPosition(int tileX, int tileY, const UnitType & type) const;
 
+        // asks the game about every position in a single round trip, results[i] tells whether tiles[i] is valid
+        void    canBuildTypeAtPositions(const UnitType & type, const std::vector<CCTilePosition> & tiles, std::vector<bool> & results) const;
+
         const   DistanceMap & getDistanceMap(const CCTilePosition & tile) const;
         const   DistanceMap & getDistanceMap(const CCPosition & tile) const;
+
+        // anything that keeps a distance map shares it with this cache, which repairs it in place when structures change the terrain
+        std::shared_ptr<const DistanceMap> getSharedDistanceMap(const CCTilePosition & tile) const;
+        std::shared_ptr<const DistanceMap> getSharedDistanceMap(const CCPosition & pos) const;
+        void    addSharedDistanceMap(const std::shared_ptr<DistanceMap> & distanceMap) const;
+        size_t  getDistanceMapMemory(std::set<const DistanceMap *> & counted) const;
         int     getGroundDistance(const CCPosition & src, const CCPosition & dest) const;
+        int     getApproxGroundDistance(const CCPosition & src, const CCPosition & dest) const;
+        const   FlowField & getFlowField(const CCPosition & target) const;
+        const   RegionMap & getRegionMap() const;
         bool    isConnected(int x1, int y1, int x2, int y2) const;
         bool    isConnected(const CCTilePosition & from, const CCTilePosition & to) const;
         bool    isConnected(const CCPosition & from, const CCPosition & to) const;
         bool    isWalkable(int tileX, int tileY) const;
         bool    isWalkable(const CCTilePosition & tile) const;
+        bool    isTerrainWalkable(int tileX, int tileY) const;
+        bool    isTerrainWalkable(const CCTilePosition & tile) const;
+
+        // structure tiles can't be walked through, but can be walked to
+        bool    isBlocked(int tileX, int tileY) const;
+        bool    isBlocked(const CCTilePosition & tile) const;
+        int     getStructureAt(int tileX, int tileY) const;
+
+        // tiles that structures started or stopped blocking this frame
+        const   std::vector<CCTilePosition> & getChangedTiles() const;
+
+        // units whose structure appeared or moved this frame, including buildings that just started construction
+        const   std::vector<CCUnitID> & getAddedStructures() const;
 
         bool    isBuildable(int tileX, int tileY) const;
         bool    isBuildable(const CCTilePosition & tile) const;
         bool    isDepotBuildableTile(int tileX, int tileY) const;
 
+        // coarse versions of the map layers, for queries that don't need tile precision
+        const   WalkablePyramid & getWalkablePyramid() const;
+        const   GridPyramid & getLastSeenPyramid() const;
+
+        // orders positions by ground distance from pos, ranking all of them on coarse cells and only measuring
+        // the exact distance of the first few. positions that can't be reached by ground go last
+        void    sortByGroundDistance(const CCPosition & pos, std::vector<CCPosition> & positions, size_t refine) const;
+
         CCTilePosition getLeastRecentlySeenTile() const;
+        void    getStalestTiles(const CCPosition & pos, float radius, size_t k, std::vector<CCTilePosition> & tiles) const;
+
+        // tiles whose visibility changed since the previous frame
+        const   std::vector<CCTilePosition> & getNewlyRevealedTiles() const;
+        const   std::vector<CCTilePosition> & getNewlyHiddenTiles() const;
 
         // returns a list of all tiles on the map, sorted by 4-direcitonal walk distance from the given position
-        const std::vector<CCTilePosition> & getClosestTilesTo(const CCTilePosition & pos) const;
+        TileList getClosestTilesTo(const CCTilePosition & pos) const;
     };
 }
\ No newline at end of file
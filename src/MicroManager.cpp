@@ -4,6 +4,9 @@
 
 using namespace CC;
 
+// how far along the flow field each move order sends a ground unit
+const int SteeringTiles = 8;
+
 MicroManager::MicroManager(CCBot & bot)
     : m_bot(bot)
 {
@@ -135,7 +138,7 @@ void MicroManager::regroup(const CCPosition & regroupPosition) const
         //else if (Util::Dist(unit, regroupPosition) > 4)
         //{
             // regroup it
-            unit.attackMove(regroupPosition);
+            moveAlongFlowField(unit, regroupPosition, true);
         //}
         //else
         //{
@@ -147,4 +150,42 @@ void MicroManager::regroup(const CCPosition & regroupPosition) const
 void MicroManager::trainSubUnits(const Unit & unit) const
 {
     // TODO: something here
+}
+
+// ground units walk the target's flow field a few tiles at a time, so every unit heading there shares one field
+// instead of the engine pathing each of them. air units, and units close to the target or off the field, go straight there
+void MicroManager::moveAlongFlowField(const Unit & unit, const CCPosition & target, bool attack) const
+{
+    CCPosition waypoint = target;
+    const FlowField & flowField = m_bot.Map().getFlowField(target);
+    const int distance = unit.isFlying() ? -1 : flowField.getDistance(unit.getPosition());
+    if (distance > SteeringTiles)
+    {
+        waypoint = flowField.getNextPosition(unit.getPosition(), SteeringTiles);
+    }
+
+#ifdef SC2API
+    const bool hasOrder = !unit.getUnitPtr()->orders.empty();
+    const CCPosition current = hasOrder ? CCPosition(unit.getUnitPtr()->orders[0].target_pos) : CCPosition(0, 0);
+#else
+    const CCPosition current = unit.getUnitPtr()->getTargetPosition();
+    const bool hasOrder = current != BWAPI::Positions::None;
+#endif
+
+    // don't spam the command: a unit keeps its waypoint until it is halfway there, as long as the waypoint is on the way
+    if (hasOrder && (current == waypoint || (distance > SteeringTiles
+        && flowField.getDistance(current) != -1 && flowField.getDistance(current) < distance
+        && Util::Dist(unit.getPosition(), current) > Util::TileToPosition(SteeringTiles / 2.0f))))
+    {
+        return;
+    }
+
+    if (attack)
+    {
+        unit.attackMove(waypoint);
+    }
+    else
+    {
+        unit.move(waypoint);
+    }
 }
\ No newline at end of file
@@ -19,6 +19,7 @@ namespace CC
 
         virtual void executeMicro(const std::vector<Unit> & targets) = 0;
         void trainSubUnits(const Unit & unit) const;
+        void moveAlongFlowField(const Unit & unit, const CCPosition & target, bool attack) const;
 
     public:
 
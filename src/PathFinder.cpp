@@ -0,0 +1,290 @@
+#include "PathFinder.h"
+#include "MapTools.h"
+
+#include <algorithm>
+
+using namespace CC;
+
+namespace
+{
+    struct OpenNode
+    {
+        int f;
+        int g;
+        int tile;
+
+        // std heaps are max-heaps, so the node with the lowest f (then highest g) compares greatest
+        bool operator < (const OpenNode & rhs) const
+        {
+            return f > rhs.f || (f == rhs.f && g < rhs.g);
+        }
+    };
+
+    // search state for one thread, g and parent are only valid for tiles stamped with the current generation
+    struct SearchBuffers
+    {
+        std::vector<uint32_t>   stamp;
+        std::vector<uint8_t>    closed;
+        std::vector<int>        g;
+        std::vector<int>        parent;
+        std::vector<OpenNode>   openList;
+        uint32_t                generation = 0;
+
+        void prepare(size_t numTiles)
+        {
+            if (stamp.size() < numTiles)
+            {
+                stamp.assign(numTiles, 0);
+                closed.resize(numTiles);
+                g.resize(numTiles);
+                parent.resize(numTiles);
+                openList.reserve(numTiles);
+            }
+
+            if (++generation == 0)
+            {
+                std::fill(stamp.begin(), stamp.end(), 0);
+                generation = 1;
+            }
+
+            openList.clear();
+        }
+
+        bool visited(int tile) const
+        {
+            return stamp[tile] == generation;
+        }
+
+        void open(int tile, int gValue, int parentTile, int f)
+        {
+            stamp[tile]  = generation;
+            closed[tile] = 0;
+            g[tile]      = gValue;
+            parent[tile] = parentTile;
+            openList.push_back({f, gValue, tile});
+            std::push_heap(openList.begin(), openList.end());
+        }
+    };
+
+    thread_local SearchBuffers Buffers;
+
+    int Sign(int v)
+    {
+        return (v > 0) - (v < 0);
+    }
+}
+
+PathFinder::PathFinder()
+    : m_width(0)
+    , m_height(0)
+{
+
+}
+
+void PathFinder::computeWalkable(const MapTools & map)
+{
+    m_width  = map.width();
+    m_height = map.height();
+    m_walkable.assign(m_width * m_height, 0);
+
+    for (int y(0); y < m_height; ++y)
+    {
+        for (int x(0); x < m_width; ++x)
+        {
+            m_walkable[y * m_width + x] = map.isWalkable(x, y);
+        }
+    }
+}
+
+void PathFinder::setWalkable(int tileX, int tileY, bool walkable)
+{
+    if (tileX < 0 || tileY < 0 || tileX >= m_width || tileY >= m_height) { return; }
+
+    m_walkable[tileY * m_width + tileX] = walkable;
+}
+
+bool PathFinder::isFree(int x, int y, int goal) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height) { return false; }
+
+    int tile = y * m_width + x;
+    return m_walkable[tile] || tile == goal;
+}
+
+// paths are searched in horizontal-first canonical order: after a vertical step the search only turns
+// horizontally when the tile diagonally behind is blocked, since otherwise going horizontal first is as short
+int PathFinder::jumpVertical(int x, int y, int dy, int goal) const
+{
+    while (true)
+    {
+        y += dy;
+        if (!isFree(x, y, goal)) { return -1; }
+
+        int tile = y * m_width + x;
+        if (tile == goal) { return tile; }
+
+        if ((isFree(x - 1, y, goal) && !isFree(x - 1, y - dy, goal)) ||
+            (isFree(x + 1, y, goal) && !isFree(x + 1, y - dy, goal)))
+        {
+            return tile;
+        }
+    }
+}
+
+// a horizontal step may always turn vertical, so it stops wherever a vertical jump finds something
+int PathFinder::jumpHorizontal(int x, int y, int dx, int goal) const
+{
+    while (true)
+    {
+        x += dx;
+        if (!isFree(x, y, goal)) { return -1; }
+
+        int tile = y * m_width + x;
+        if (tile == goal) { return tile; }
+
+        if (jumpVertical(x, y, 1, goal) != -1 || jumpVertical(x, y, -1, goal) != -1)
+        {
+            return tile;
+        }
+    }
+}
+
+int PathFinder::search(const CCTilePosition & from, const CCTilePosition & to) const
+{
+    if (!isFree(from.x, from.y, -1) || to.x < 0 || to.y < 0 || to.x >= m_width || to.y >= m_height)
+    {
+        return -1;
+    }
+
+    const int start = from.y * m_width + from.x;
+    const int goal  = to.y * m_width + to.x;
+
+    SearchBuffers & buffers = Buffers;
+    buffers.prepare(m_width * m_height);
+
+    buffers.open(start, 0, -1, std::abs(from.x - to.x) + std::abs(from.y - to.y));
+
+    int successors[4];
+    while (!buffers.openList.empty())
+    {
+        std::pop_heap(buffers.openList.begin(), buffers.openList.end());
+        OpenNode node = buffers.openList.back();
+        buffers.openList.pop_back();
+
+        // skip stale heap entries for tiles that were reached more cheaply since they were pushed
+        if (buffers.closed[node.tile] || node.g != buffers.g[node.tile]) { continue; }
+        buffers.closed[node.tile] = 1;
+
+        if (node.tile == goal)
+        {
+            return node.g;
+        }
+
+        const int x = node.tile % m_width;
+        const int y = node.tile / m_width;
+        const int parent = buffers.parent[node.tile];
+        int numSuccessors = 0;
+
+        if (parent == -1)
+        {
+            successors[numSuccessors++] = jumpHorizontal(x, y, 1, goal);
+            successors[numSuccessors++] = jumpHorizontal(x, y, -1, goal);
+            successors[numSuccessors++] = jumpVertical(x, y, 1, goal);
+            successors[numSuccessors++] = jumpVertical(x, y, -1, goal);
+        }
+        else
+        {
+            const int dx = Sign(x - parent % m_width);
+            const int dy = Sign(y - parent / m_width);
+
+            if (dx != 0)
+            {
+                successors[numSuccessors++] = jumpHorizontal(x, y, dx, goal);
+                successors[numSuccessors++] = jumpVertical(x, y, 1, goal);
+                successors[numSuccessors++] = jumpVertical(x, y, -1, goal);
+            }
+            else
+            {
+                successors[numSuccessors++] = jumpVertical(x, y, dy, goal);
+
+                for (int sx = -1; sx <= 1; sx += 2)
+                {
+                    if (isFree(x + sx, y, goal) && !isFree(x + sx, y - dy, goal))
+                    {
+                        successors[numSuccessors++] = jumpHorizontal(x, y, sx, goal);
+                    }
+                }
+            }
+        }
+
+        for (int s(0); s < numSuccessors; ++s)
+        {
+            const int next = successors[s];
+            if (next == -1) { continue; }
+
+            const int nx = next % m_width;
+            const int ny = next / m_width;
+            const int g = node.g + std::abs(nx - x) + std::abs(ny - y);
+
+            // the manhattan heuristic is consistent, so closed tiles never need to be reopened
+            if (buffers.visited(next) && (buffers.closed[next] || g >= buffers.g[next]))
+            {
+                continue;
+            }
+
+            buffers.open(next, g, node.tile, g + std::abs(nx - to.x) + std::abs(ny - to.y));
+        }
+    }
+
+    return -1;
+}
+
+int PathFinder::getGroundDistance(const CCTilePosition & from, const CCTilePosition & to) const
+{
+    if (from.x == to.x && from.y == to.y)
+    {
+        return 0;
+    }
+
+    return search(from, to);
+}
+
+bool PathFinder::getPath(const CCTilePosition & from, const CCTilePosition & to, std::vector<CCTilePosition> & path) const
+{
+    path.clear();
+
+    if (getGroundDistance(from, to) == -1)
+    {
+        return false;
+    }
+
+    path.push_back(to);
+    if (from.x == to.x && from.y == to.y)
+    {
+        return true;
+    }
+
+    // walk the jump points back to the start, filling in the straight segments between them
+    const SearchBuffers & buffers = Buffers;
+    int tile = to.y * m_width + to.x;
+    while (buffers.parent[tile] != -1)
+    {
+        const int parent = buffers.parent[tile];
+        const int px = parent % m_width;
+        const int py = parent / m_width;
+        CCTilePosition current(tile % m_width, tile / m_width);
+
+        const int dx = Sign(px - current.x);
+        const int dy = Sign(py - current.y);
+        while (current.x != px || current.y != py)
+        {
+            current = CCTilePosition(current.x + dx, current.y + dy);
+            path.push_back(current);
+        }
+
+        tile = parent;
+    }
+
+    std::reverse(path.begin(), path.end());
+    return true;
+}
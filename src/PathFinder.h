@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+    class MapTools;
+
+    // Point to point ground paths on the 4-connected walkable grid using jump point search.
+    // Search buffers are kept per thread and reused between queries, so a query never allocates
+    // once the buffers have grown to the size of the map.
+    class PathFinder
+    {
+        int                     m_width;
+        int                     m_height;
+        std::vector<uint8_t>    m_walkable;     // row-major copy of the walkable grid
+
+        bool isFree(int x, int y, int goal) const;
+        int  jumpHorizontal(int x, int y, int dx, int goal) const;
+        int  jumpVertical(int x, int y, int dy, int goal) const;
+        int  search(const CCTilePosition & from, const CCTilePosition & to) const;
+
+    public:
+
+        PathFinder();
+
+        void computeWalkable(const MapTools & map);
+        void setWalkable(int tileX, int tileY, bool walkable);
+
+        // the 4-connected walk distance between two tiles, or -1 if there is no path
+        // the destination may be unwalkable (e.g. a building), in which case the path ends next to it
+        int  getGroundDistance(const CCTilePosition & from, const CCTilePosition & to) const;
+
+        // fills path with every tile from -> to, returns false if there is no path
+        bool getPath(const CCTilePosition & from, const CCTilePosition & to, std::vector<CCTilePosition> & path) const;
+    };
+}
@@ -0,0 +1,96 @@
+#include "ProducerIndex.h"
+#include "CCBot.h"
+
+using namespace CC;
+
+ProducerIndex::ProducerIndex(CCBot & bot)
+    : m_bot(bot)
+{
+
+}
+
+void ProducerIndex::onFrame()
+{
+    for (auto & unit : m_bot.UnitInfo().getUnitsDied(Players::Self))
+    {
+        remove(unit.getID());
+    }
+
+    // an order the game rejected doesn't change the unit, so the units we set busy are looked at again
+    for (auto & unit : m_ordered)
+    {
+        if (m_entries.find(unit.getID()) != m_entries.end() && !unit.isTraining())
+        {
+            remove(unit.getID());
+            insert(unit, Idle);
+        }
+    }
+    m_ordered.clear();
+
+    // new units, and units that morphed, finished, lifted off, landed, or started or finished an order
+    for (auto & unit : m_bot.UnitInfo().getUnitsChanged(Players::Self))
+    {
+        remove(unit.getID());
+
+        if (unit.isCompleted() && !unit.isFlying())
+        {
+            insert(unit, unit.isTraining() ? Busy : Idle);
+        }
+    }
+}
+
+void ProducerIndex::setBusy(const Unit & unit)
+{
+    auto it = m_entries.find(unit.getID());
+    if (it == m_entries.end() || it->second.state == Busy)
+    {
+        return;
+    }
+
+    remove(unit.getID());
+    insert(unit, Busy);
+    m_ordered.push_back(unit);
+}
+
+void ProducerIndex::insert(const Unit & unit, State state)
+{
+    m_units[state][unit.getType()].push_back(unit);
+
+    Entry & entry = m_entries[unit.getID()];
+    entry.type  = unit.getType();
+    entry.state = state;
+}
+
+void ProducerIndex::remove(const CCUnitID & id)
+{
+    auto it = m_entries.find(id);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+
+    std::vector<Unit> & units = m_units[it->second.state][it->second.type];
+    for (size_t i = 0; i < units.size(); ++i)
+    {
+        if (units[i].getID() == id)
+        {
+            units[i] = units.back();
+            units.pop_back();
+            break;
+        }
+    }
+
+    m_entries.erase(it);
+}
+
+const std::vector<Unit> & ProducerIndex::getIdle(const UnitType & type) const
+{
+    auto it = m_units[Idle].find(type);
+    return it == m_units[Idle].end() ? m_empty : it->second;
+}
+
+const std::vector<Unit> & ProducerIndex::getBusy(const UnitType & type) const
+{
+    auto it = m_units[Busy].find(type);
+    return it == m_units[Busy].end() ? m_empty : it->second;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Common.h"
+#include "Unit.h"
+#include "UnitType.h"
+
+namespace CC
+{
+    class CCBot;
+
+    // Our completed units on the ground by type, split into idle ones and ones busy with orders. Instead of scanning
+    // every unit we own for each producer lookup, the index only looks at the units UnitInfoManager reports as new,
+    // changed or dead each frame, and at the units we just gave an order to, so a lookup reads the few candidates of
+    // the producer types.
+    class ProducerIndex
+    {
+        enum State { Idle, Busy, NumStates };
+
+        struct Entry
+        {
+            UnitType    type;
+            State       state;
+        };
+
+        CCBot &                                 m_bot;
+        std::map<UnitType, std::vector<Unit>>   m_units[NumStates];
+        std::map<CCUnitID, Entry>               m_entries;          // where each indexed unit is kept
+        std::vector<Unit>                       m_ordered;          // units set busy by us since the last frame
+        std::vector<Unit>                       m_empty;
+
+        void    insert(const Unit & unit, State state);
+        void    remove(const CCUnitID & id);
+
+    public:
+
+        ProducerIndex(CCBot & bot);
+
+        void    onFrame();
+
+        // moves a unit we just gave an order to out of the idle units, until the observation catches up
+        void    setBusy(const Unit & unit);
+
+        const std::vector<Unit> & getIdle(const UnitType & type) const;
+        const std::vector<Unit> & getBusy(const UnitType & type) const;
+    };
+}
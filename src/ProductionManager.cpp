@@ -4,10 +4,21 @@
 
 using namespace CC;
 
+const int IncomeSampleFrames = 16;          // frames between two income samples
+const size_t IncomeSamples   = 16;          // samples the income rate is measured over
+
 ProductionManager::ProductionManager(CCBot & bot)
     : m_bot             (bot)
     , m_buildingManager (bot)
     , m_BOSSManager     (bot, m_buildingManager)
+    , m_warpInPlacer    (bot)
+    , m_producers       (bot)
+    , m_spentMinerals   (0)
+    , m_spentGas        (0)
+    , m_spentSupply     (0)
+#ifdef SC2API
+    , m_abilityFrame    (-1)
+#endif
 {
 
 }
@@ -20,6 +31,9 @@ void ProductionManager::onStart()
 
 void ProductionManager::onFrame()
 {
+    m_producers.onFrame();
+    updateIncome();
+
     if (m_bot.Config().UseBOSS)
     {
         m_BOSSManager.onFrame();
@@ -43,6 +57,12 @@ void ProductionManager::onUnitDestroy(const Unit & unit)
 
 void ProductionManager::manageBuildOrderQueue()
 {
+    // nothing is spent by this frame's orders yet
+    m_spentMinerals = 0;
+    m_spentGas      = 0;
+    m_spentSupply   = 0;
+    m_usedProducers.clear();
+
     // if there is nothing in the queue, oh well
     if (m_BOSSManager.m_queue.isEmpty())
     {
@@ -50,43 +70,57 @@ void ProductionManager::manageBuildOrderQueue()
     }
 
     // the current item to be used
-    BuildOrderItem & currentItem = m_BOSSManager.m_queue.getHighestPriorityItem();
+    BuildOrderItem * currentItem = &m_BOSSManager.m_queue.getHighestPriorityItem();
+
+    // only the first building we can't afford yet gets a builder sent ahead
+    bool prepared = false;
 
-    // while there is still something left in the queue
+    // make every item we have the producer, resources and supply for, until a blocking item can't be made
     while (!m_BOSSManager.m_queue.isEmpty())
     {
         // this is the unit which can produce the currentItem
-        Unit producer = getProducer(currentItem.type);
+        Unit producer = getProducer(currentItem->type);
 
         // check to see if we can make it right now
-        bool canMake = canMakeNow(producer, currentItem.type);
+        bool canMake = canMakeNow(producer, currentItem->type);
 
-        // TODO: if it's a building and we can't make it yet, predict the worker movement to the location
+        // if it's a building we can't afford yet, a builder can already walk to where it will go,
+        // so it arrives about when we can afford it
+        if (!prepared && !canMake && producer.isValid() && currentItem->type.isBuilding() && !currentItem->type.getUnitType().isMorphedBuilding())
+        {
+            prepared = true;
+            const int framesUntilAffordable = getFramesUntilAffordable(currentItem->type);
+            if (framesUntilAffordable > 0)
+            {
+                m_buildingManager.prepareBuilding(currentItem->type.getUnitType(), Util::GetTilePosition(m_bot.GetStartLocation()), framesUntilAffordable);
+            }
+        }
 
-        // if we can make the current item
-        if (producer.isValid() && canMake)
+        // if we can make the current item, create it and remove it from the queue,
+        // the items skipped so far stay skipped so the next one is the item below it
+        if (producer.isValid() && canMake && create(producer, *currentItem))
         {
-            // create it and remove it from the _queue
-            create(producer, currentItem);
             m_BOSSManager.m_queue.removeCurrentHighestPriorityItem();
-
-            // don't actually loop around in here
-            break;
         }
         // otherwise, if we can skip the current item
         else if (m_BOSSManager.m_queue.canSkipItem())
         {
             // skip it
             m_BOSSManager.m_queue.skipItem();
-
-            // and get the next one
-            currentItem = m_BOSSManager.m_queue.getNextHighestPriorityItem();
         }
         else
         {
             // so break out
             break;
         }
+
+        if (!m_BOSSManager.m_queue.hasNextHighestPriorityItem())
+        {
+            break;
+        }
+
+        // and get the next one
+        currentItem = &m_BOSSManager.m_queue.getNextHighestPriorityItem();
     }
 }
 
@@ -151,34 +185,38 @@ Unit ProductionManager::getProducer(const MetaType & type, CCPosition closestTo)
     // get all the types of units that can build this type
     auto & producerTypes = m_bot.Data(type).whatBuilds;
 
-    // make a set of all candidate producers
+    // make a set of all candidate producers, the index only holds our completed units on the ground
     std::vector<Unit> candidateProducers;
-    for (auto unit : m_bot.UnitInfo().getUnits(Players::Self))
+    for (auto & producerType : producerTypes)
     {
-        // reasons a unit can not train the desired type
-        if (std::find(producerTypes.begin(), producerTypes.end(), unit.getType()) == producerTypes.end()) { continue; }
-        if (!unit.isCompleted()) { continue; }
-        if (!type.isAbility() && m_bot.Data(unit).isBuilding && unit.isTraining()) { continue; }
-        if (unit.isFlying()) { continue; }
-        // WarpGates need special consideration because the building doesn't actually produce the unit, it casts an ability that does
-        if (m_bot.GetPlayerRace(Players::Self) == CCRace::Protoss && unit.getType().isMorphedBuilding()) 
-        { 
-            auto & abilities = m_bot.Query()->GetAbilitiesForUnit(unit.getUnitPtr()).abilities;
-            if (std::find_if(abilities.begin(), abilities.end(), 
-                [type](const sc2::AvailableAbility & ability) { return ability.ability_id == type.getAbility().first; }) == abilities.end())
-            {
-                continue;
-            }
+        auto & idle = m_producers.getIdle(producerType);
+        candidateProducers.insert(candidateProducers.end(), idle.begin(), idle.end());
+
+        // buildings busy training can't train another unit, but workers with orders can still build and abilities can still be cast
+        if (type.isAbility() || !m_bot.Data(producerType).isBuilding)
+        {
+            auto & busy = m_producers.getBusy(producerType);
+            candidateProducers.insert(candidateProducers.end(), busy.begin(), busy.end());
+        }
+    }
+
+    const bool protoss = m_bot.GetPlayerRace(Players::Self) == CCRace::Protoss;
+    candidateProducers.erase(std::remove_if(candidateProducers.begin(), candidateProducers.end(), [this, &type, protoss](const Unit & unit)
+    {
+        // a producer given an order this frame doesn't show it yet
+        if (m_usedProducers.count(unit.getID()) > 0)
+        {
+            return true;
         }
 
-        // TODO: if unit is not powered continue
-        //if (m_bot.GetPlayerRace(Players::Self) == CCRace::Protoss && unit.getType().isBuilding() && !unit.isPowered()) { continue; }
-        // TODO: if the type is an addon, some special cases
-        // TODO: if the type requires an addon and the producer doesn't have one
+        // WarpGates need special consideration because the building doesn't actually produce the unit, it casts an ability that does
+        return protoss && unit.getType().isMorphedBuilding() && !hasAbility(unit, type.getAbility().first);
+    }), candidateProducers.end());
 
-        // if we haven't cut it, add it to the set of candidates
-        candidateProducers.push_back(unit);
-    }
+    // TODO: if unit is not powered continue
+    //if (m_bot.GetPlayerRace(Players::Self) == CCRace::Protoss && unit.getType().isBuilding() && !unit.isPowered()) { continue; }
+    // TODO: if the type is an addon, some special cases
+    // TODO: if the type requires an addon and the producer doesn't have one
 
     return getClosestUnitToPosition(candidateProducers, closestTo);
 }
@@ -213,11 +251,12 @@ Unit ProductionManager::getClosestUnitToPosition(const std::vector<Unit> & units
 }
 
 // this function will check to see if all preconditions are met and then create a unit
-void ProductionManager::create(const Unit & producer, BuildOrderItem & item)
+// gives the order for the item, returns false if it couldn't be given
+bool ProductionManager::create(const Unit & producer, BuildOrderItem & item)
 {
     if (!producer.isValid())
     {
-        return;
+        return false;
     }
 
     // if we're dealing with a building
@@ -226,6 +265,8 @@ void ProductionManager::create(const Unit & producer, BuildOrderItem & item)
         if (item.type.getUnitType().isMorphedBuilding())
         {
             producer.morph(item.type.getUnitType());
+            m_producers.setBusy(producer);
+            spend(producer, item.type);
             std::cout << producer.getPosition().x << "," << producer.getPosition().y << std::endl;
             //std::cout << "morphing!" << std::endl;
         }
@@ -239,83 +280,16 @@ void ProductionManager::create(const Unit & producer, BuildOrderItem & item)
     // warp in unit
     else if (item.type.isUnit() && item.type.getName().find("Warped") != std::string::npos)
     {
-        //std::cout << "warping unit!" << std::endl;
-        // get the closest warp in pylon or warpprism to the enemy base
-        std::vector<Unit> pylonsAndWarpPrisms;
-        float closest_to_enemy_pylon_pos = std::numeric_limits<float>::max();
-        CCPosition powerPos;
-        for (auto & unit : m_bot.UnitInfo().getUnits(Players::Self))
-        {
-            if (unit.getType().getAPIUnitType() == sc2::UNIT_TYPEID::PROTOSS_PYLON || unit.getType().getAPIUnitType() == sc2::UNIT_TYPEID::PROTOSS_WARPPRISMPHASING)
-            {
-                pylonsAndWarpPrisms.push_back(unit);
-                float distance = m_bot.Query()->PathingDistance(unit.getPosition(), m_bot.Bases().getPlayerStartingBaseLocation(Players::Enemy)->getPosition());
-                if (distance < closest_to_enemy_pylon_pos)
-                {
-                    closest_to_enemy_pylon_pos = distance;
-                    powerPos = unit.getPosition();
-                }
-            }
-        }
-
-        CCPosition warpPosition(-1, -1);
-        float closest_distance = std::numeric_limits<float>::max();
-
-        // get the closest point in the power sphere to the enemy base
-        for (int x = -5; x < 6; ++x)
-        {
-            for (int y = -5; y < 6; ++y)
-            {
-                CCPosition pos = CCPosition(powerPos.x + x, powerPos.y + y);
-                if (m_bot.Map().isVisible(int(pos.x), int(pos.y)) && m_bot.Query()->Placement(m_bot.Data(item.type.getUnitType()).warpAbility, pos)
-                    && Util::Dist(getClosestUnitToPosition(m_bot.UnitInfo().getUnits(Players::Self), pos).getPosition(), pos) > item.type.getUnitType().tileWidth() / 2)
-                {
-                    float distToEnemyBase = m_bot.Query()->PathingDistance(pos, m_bot.Bases().getPlayerStartingBaseLocation(Players::Enemy)->getPosition());
-                    if (distToEnemyBase < closest_distance)
-                    {
-                        warpPosition = pos;
-                        closest_distance = distToEnemyBase;
-                    }
-                    //std::cout << "warp-in is possible in location: " << powerPos.x + x << "," << powerPos.y + y << std::endl;
-                }
-                else
-                {
-                    //std::cout << "unable to warp in location: " << powerPos.x + x << "," << powerPos.y + y << std::endl;
-                }
-            }
-        }
-
-        // couldn't find a location to warp with this pylon
+        // the best free cell in the power fields, ranked once a frame for every warp-in of the frame
+        CCPosition warpPosition = m_warpInPlacer.getWarpPosition(item.type.getUnitType());
+        // the power fields are full, the item waits for a later frame
         if (!m_bot.Map().isValidPosition(warpPosition))
         {
-            std::cout << "closest pylon wasn't valid!" << std::endl;
-            std::random_device dev;
-            std::mt19937 rng(dev());
-            std::uniform_int_distribution<std::mt19937::result_type> dist(-5, 6); // distribution in range [-5, 5]
-
-            // go through every pylon and warp prism
-            for (auto & powerStructure : pylonsAndWarpPrisms)
-            {
-                CCPosition powerPos = powerStructure.getPosition();
-                // try 30 random positions within the power grid
-                for (int count = 0; count < 30; ++count)
-                {
-                    int dx = dist(rng);
-                    int dy = dist(rng);
-
-                    CCPosition pos = CCPosition(powerPos.x + dx, powerPos.y + dy);
-                    // take the first valid position you find
-                    if (m_bot.Map().isVisible(int(pos.x), int(pos.y)) && m_bot.Query()->Placement(m_bot.Data(item.type.getUnitType()).warpAbility, pos) 
-                        && Util::Dist(getClosestUnitToPosition(m_bot.UnitInfo().getUnits(Players::Self), pos).getPosition(), pos) > item.type.getUnitType().tileWidth() / 2)
-                    {
-                        warpPosition = pos;
-                        break;
-                    }
-                }
-            }
+            return false;
         }
 
         producer.warp(item.type.getUnitType(), warpPosition);
+        spend(producer, item.type);
         //system("pause");
         //std::cout << "warping! " << warpPosition.x << "," << warpPosition.y << std::endl;
     }
@@ -323,12 +297,16 @@ void ProductionManager::create(const Unit & producer, BuildOrderItem & item)
     else if (item.type.isUnit())
     {
         producer.train(item.type.getUnitType());
+        m_producers.setBusy(producer);
+        spend(producer, item.type);
         //system("pause");
         //std::cout << "training unit!" << std::endl;
     }
     else if (item.type.isUpgrade())
     {
         producer.research(item.type.getAbility().first);
+        m_producers.setBusy(producer);
+        spend(producer, item.type);
         //system("pause");
         //std::cout << "researching upgrade!" << std::endl;
     }
@@ -343,14 +321,28 @@ void ProductionManager::create(const Unit & producer, BuildOrderItem & item)
                 if (unit.getUnitPtr()->orders[0].ability_id == action.second.targetProduction_ability)
                 {
                     producer.cast(m_bot.GetUnit(unit.getID()), action.first);
+                    spend(producer, item.type);
                     //system("pause");
                     //std::cout << "casting ability!" << std::endl;
-                    return;
+                    return true;
                 }
             }
         }        
         std::cerr << "Could not find target for chronoboost!" << std::endl;
+        return false;
     }
+
+    return true;
+}
+
+// buildings placed by the building manager reserve their resources there, everything else
+// is spent the moment the order is given
+void ProductionManager::spend(const Unit & producer, const MetaType & type)
+{
+    m_spentMinerals += m_bot.Data(type).mineralCost;
+    m_spentGas      += m_bot.Data(type).gasCost;
+    m_spentSupply   += m_bot.Data(type).supplyCost;
+    m_usedProducers.insert(producer.getID());
 }
 
 bool ProductionManager::canMakeNow(const Unit & producer, const MetaType & type)
@@ -372,36 +364,18 @@ bool ProductionManager::canMakeNow(const Unit & producer, const MetaType & type)
     }
 
 #ifdef SC2API
-    sc2::AvailableAbilities available_abilities = m_bot.Query()->GetAbilitiesForUnit(producer.getUnitPtr(), true);
-
-    // quick check if the unit can't do anything it certainly can't build the thing we want
-    if (available_abilities.abilities.empty())
+    // check to see if one of the unit's available abilities matches the build ability type
+    sc2::AbilityID MetaTypeAbility;
+    if (type.getName().find("Warped") != std::string::npos)
     {
-        return false;
+        MetaTypeAbility = m_bot.Data(type).warpAbility;
     }
     else
     {
-        // check to see if one of the unit's available abilities matches the build ability type
-        sc2::AbilityID MetaTypeAbility;
-        if (type.getName().find("Warped") != std::string::npos)
-        {
-            MetaTypeAbility = m_bot.Data(type).warpAbility;
-        }
-        else
-        {
-            MetaTypeAbility = m_bot.Data(type).buildAbility; 
-        }
-
-        for (const sc2::AvailableAbility & available_ability : available_abilities.abilities)
-        {
-            if (available_ability.ability_id == MetaTypeAbility)
-            {
-                return true;
-            }
-        }
+        MetaTypeAbility = m_bot.Data(type).buildAbility; 
     }
 
-    return false;
+    return hasAbility(producer, MetaTypeAbility);
 #else
     bool canMake = meetsReservedResources(type);
     if (canMake)
@@ -436,12 +410,129 @@ bool ProductionManager::detectBuildOrderDeadlock()
 
 int ProductionManager::getFreeMinerals()
 {
-    return m_bot.GetMinerals() - m_buildingManager.getReservedMinerals();
+    return m_bot.GetMinerals() - m_buildingManager.getReservedMinerals() - m_spentMinerals;
 }
 
 int ProductionManager::getFreeGas()
 {
-    return m_bot.GetGas() - m_buildingManager.getReservedGas();
+    return m_bot.GetGas() - m_buildingManager.getReservedGas() - m_spentGas;
+}
+
+#ifdef SC2API
+// one batched query a frame for every unit that can produce something in the queue, so the number of
+// queries doesn't grow with the number of production buildings
+void ProductionManager::updateAbilities()
+{
+    m_abilityFrame = m_bot.GetCurrentFrame();
+    m_abilities.clear();
+
+    std::set<UnitType> producerTypes;
+    for (size_t i(0); i < m_BOSSManager.m_queue.size(); ++i)
+    {
+        for (auto & producerType : m_bot.Data(m_BOSSManager.m_queue[(int)i].type).whatBuilds)
+        {
+            producerTypes.insert(producerType);
+        }
+    }
+
+    sc2::Units producers;
+    for (auto & producerType : producerTypes)
+    {
+        for (auto & unit : m_producers.getIdle(producerType))
+        {
+            producers.push_back(unit.getUnitPtr());
+        }
+
+        for (auto & unit : m_producers.getBusy(producerType))
+        {
+            producers.push_back(unit.getUnitPtr());
+        }
+    }
+
+    if (producers.empty())
+    {
+        return;
+    }
+
+    for (auto & abilities : m_bot.Query()->GetAbilitiesForUnits(producers, true))
+    {
+        m_abilities[abilities.unit_tag] = abilities;
+    }
+}
+
+bool ProductionManager::hasAbility(const Unit & unit, const sc2::AbilityID & ability)
+{
+    if (m_abilityFrame != m_bot.GetCurrentFrame())
+    {
+        updateAbilities();
+    }
+
+    // a unit the batch didn't cover is asked about on its own, once this frame
+    auto it = m_abilities.find(unit.getID());
+    if (it == m_abilities.end())
+    {
+        it = m_abilities.insert(std::make_pair(unit.getID(), m_bot.Query()->GetAbilitiesForUnit(unit.getUnitPtr(), true))).first;
+    }
+
+    for (const sc2::AvailableAbility & available : it->second.abilities)
+    {
+        if (available.ability_id == ability)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
+void ProductionManager::updateIncome()
+{
+    const int frame = m_bot.GetCurrentFrame();
+    if (!m_incomeSamples.empty() && frame - m_incomeSamples.back().frame < IncomeSampleFrames)
+    {
+        return;
+    }
+
+    m_incomeSamples.push_back({ frame, m_bot.GetCollectedMinerals(), m_bot.GetCollectedGas() });
+    if (m_incomeSamples.size() > IncomeSamples)
+    {
+        m_incomeSamples.pop_front();
+    }
+}
+
+// frames until the free resources cover the type at the income of the last few seconds, -1 if they never will
+int ProductionManager::getFramesUntilAffordable(const MetaType & type)
+{
+    if (m_incomeSamples.size() < 2)
+    {
+        return -1;
+    }
+
+    const IncomeSample & first = m_incomeSamples.front();
+    const IncomeSample & last  = m_incomeSamples.back();
+    const float frames = (float)(last.frame - first.frame);
+
+    const int needed[2] = { m_bot.Data(type).mineralCost - getFreeMinerals(), m_bot.Data(type).gasCost - getFreeGas() };
+    const float rate[2] = { (last.minerals - first.minerals) / frames, (last.gas - first.gas) / frames };
+
+    int wait = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (needed[i] <= 0)
+        {
+            continue;
+        }
+
+        if (rate[i] <= 0)
+        {
+            return -1;
+        }
+
+        wait = std::max(wait, (int)std::ceil(needed[i] / rate[i]));
+    }
+
+    return wait;
 }
 
 // return whether or not we meet resources, including building reserves
@@ -451,12 +542,12 @@ bool ProductionManager::meetsReservedResources(const MetaType & type)
     int minerals = m_bot.Data(type).mineralCost;
     int gas = m_bot.Data(type).gasCost;
 
-    return (m_bot.Data(type).mineralCost <= getFreeMinerals()) && (m_bot.Data(type).gasCost <= getFreeGas()) && (m_bot.Data(type).supplyCost <= (m_bot.GetMaxSupply() - m_bot.GetCurrentSupply()));
+    return (m_bot.Data(type).mineralCost <= getFreeMinerals()) && (m_bot.Data(type).gasCost <= getFreeGas()) && (m_bot.Data(type).supplyCost <= (m_bot.GetMaxSupply() - m_bot.GetCurrentSupply() - m_spentSupply));
 }
 
 void ProductionManager::drawProductionInformation()
 {
-    if (!m_bot.Config().DrawProductionInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::ProductionInfo))
     {
         return;
     }
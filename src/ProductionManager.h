@@ -5,6 +5,9 @@
 #include "BuildingManager.h"
 #include "BuildOrderQueue.h"
 #include "BOSSManager.h"
+#include "WarpInPlacer.h"
+#include "ProducerIndex.h"
+#include <deque>
 
 namespace CC
 {
@@ -16,15 +19,43 @@ namespace CC
 
         BuildingManager m_buildingManager;
         BOSSManager     m_BOSSManager;
+        WarpInPlacer    m_warpInPlacer;
+        ProducerIndex   m_producers;
+
+        struct IncomeSample
+        {
+            int frame;
+            int minerals;       // collected since the game started
+            int gas;
+        };
+
+        std::deque<IncomeSample> m_incomeSamples;     // the last few seconds of collected resources
+
+        int                 m_spentMinerals;    // spent by the orders given this frame, which the observation doesn't show yet
+        int                 m_spentGas;
+        int                 m_spentSupply;
+        std::set<CCUnitID>  m_usedProducers;    // producers given an order this frame
+
+#ifdef SC2API
+        int                                             m_abilityFrame;     // the frame the abilities were queried in
+        std::map<CCUnitID, sc2::AvailableAbilities>     m_abilities;        // what our producers can do this frame, resources ignored
+#endif
 
         Unit    getClosestUnitToPosition(const std::vector<Unit> & units, CCPosition closestTo);
         bool    meetsReservedResources(const MetaType & type);
         bool    canMakeNow(const Unit & producer, const MetaType & type);
         bool    detectBuildOrderDeadlock();
-        void    create(const Unit & producer, BuildOrderItem & item);
+        bool    create(const Unit & producer, BuildOrderItem & item);
+        void    spend(const Unit & producer, const MetaType & type);
         void    manageBuildOrderQueue();
         int     getFreeMinerals();
         int     getFreeGas();
+        void    updateIncome();
+#ifdef SC2API
+        void    updateAbilities();
+        bool    hasAbility(const Unit & unit, const sc2::AbilityID & ability);
+#endif
+        int     getFramesUntilAffordable(const MetaType & type);
 
         void    fixBuildOrderDeadlock();
     public:
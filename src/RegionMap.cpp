@@ -0,0 +1,597 @@
+#include "RegionMap.h"
+#include "MapTools.h"
+#include "MapCache.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+using namespace CC;
+
+namespace
+{
+    const int LegalActions = 4;
+    const int actionX[LegalActions] = {1, -1, 0, 0};
+    const int actionY[LegalActions] = {0, 0, 1, -1};
+
+    // regions smaller than this are always merged into their neighbours, they are just terrain noise
+    const int MinRegionSize = 64;
+
+    // a tile is a choke between two regions if its clearance is below this fraction of the smaller region's widest point
+    const float ChokeClearanceRatio = 0.7f;
+
+    // frontier tiles of the same two regions closer than this belong to the same choke
+    const int ChokeClusterDistance = 2;
+
+    const int Unreachable = std::numeric_limits<int>::max();
+
+    int FindRoot(std::vector<int> & parent, int i)
+    {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+
+        return i;
+    }
+}
+
+RegionMap::RegionMap()
+    : m_width(0)
+    , m_height(0)
+{
+
+}
+
+void RegionMap::computeRegions(const MapTools & map)
+{
+    m_width  = map.width();
+    m_height = map.height();
+
+    std::vector<bool> walkable(m_width * m_height);
+    for (int y(0); y < m_height; ++y)
+    {
+        for (int x(0); x < m_width; ++x)
+        {
+            walkable[y * m_width + x] = map.isTerrainWalkable(x, y);
+        }
+    }
+
+    computeClearance(walkable);
+    computeWatershed(walkable);
+    computeChokeDistances();
+}
+
+// the regions of a map cache written by an earlier game, tiles and chokes of each region are listed
+// in the same order computeRegions lists them, so the stored choke fields line up with the region indices
+void RegionMap::load(const MapCache & cache)
+{
+    m_width  = cache.width();
+    m_height = cache.height();
+
+    const int numTiles = m_width * m_height;
+    const int32_t * clearance = cache.clearance();
+    const int32_t * regionIDs = cache.tileRegions();
+    m_clearance.assign(clearance, clearance + numTiles);
+    m_regionID.assign(regionIDs, regionIDs + numTiles);
+    m_regionIndex.assign(numTiles, -1);
+
+    m_regions.assign(cache.numRegions(), Region());
+    for (size_t r(0); r < m_regions.size(); ++r)
+    {
+        const MapCache::RegionRecord & record = cache.getRegionRecord(r);
+        m_regions[r].id           = (int)r;
+        m_regions[r].maxClearance = record.maxClearance;
+        m_regions[r].center       = CCTilePosition(record.centerX, record.centerY);
+    }
+
+    for (int i(0); i < numTiles; ++i)
+    {
+        if (m_regionID[i] != -1)
+        {
+            m_regionIndex[i] = (int)m_regions[m_regionID[i]].tiles.size();
+            m_regions[m_regionID[i]].tiles.push_back(i);
+        }
+    }
+
+    m_chokes.assign(cache.numChokes(), Choke());
+    m_chokeFields.assign(m_chokes.size(), std::array<std::vector<int>, 2>());
+    for (size_t c(0); c < m_chokes.size(); ++c)
+    {
+        const MapCache::ChokeRecord & record = cache.getChokeRecord(c);
+        const CCTilePosition * tiles = cache.getChokeTiles(record);
+        const int32_t * fieldA = cache.getChokeField(record, 0);
+        const int32_t * fieldB = cache.getChokeField(record, 1);
+
+        Choke & choke = m_chokes[c];
+        choke.id      = (int)c;
+        choke.regionA = record.regionA;
+        choke.regionB = record.regionB;
+        choke.center  = CCTilePosition(record.centerX, record.centerY);
+        choke.tiles.assign(tiles, tiles + record.numTiles);
+
+        m_chokeFields[c][0].assign(fieldA, fieldA + m_regions[choke.regionA].tiles.size());
+        m_chokeFields[c][1].assign(fieldB, fieldB + m_regions[choke.regionB].tiles.size());
+
+        m_regions[choke.regionA].chokes.push_back(choke.id);
+        m_regions[choke.regionB].chokes.push_back(choke.id);
+    }
+
+    const int32_t * chokeDist = cache.chokeDistances();
+    m_chokeDist.assign(chokeDist, chokeDist + m_chokes.size() * m_chokes.size());
+}
+
+// multi-source BFS from every unwalkable tile, so each walkable tile knows how far it is from a wall
+void RegionMap::computeClearance(const std::vector<bool> & walkable)
+{
+    m_clearance.assign(m_width * m_height, -1);
+
+    std::vector<int> fringe;
+    fringe.reserve(m_width * m_height);
+
+    for (int i(0); i < m_width * m_height; ++i)
+    {
+        int x = i % m_width;
+        int y = i / m_width;
+
+        if (!walkable[i])
+        {
+            m_clearance[i] = 0;
+            fringe.push_back(i);
+        }
+        else if (x == 0 || y == 0 || x == m_width - 1 || y == m_height - 1)
+        {
+            // the edge of the map is as good as a wall
+            m_clearance[i] = 1;
+            fringe.push_back(i);
+        }
+    }
+
+    for (size_t fringeIndex=0; fringeIndex<fringe.size(); ++fringeIndex)
+    {
+        int tile = fringe[fringeIndex];
+        int x = tile % m_width;
+        int y = tile / m_width;
+
+        // clearance is measured in all 8 directions, which gives rounder regions
+        for (int dx=-1; dx<=1; ++dx)
+        {
+            for (int dy=-1; dy<=1; ++dy)
+            {
+                int nx = x + dx;
+                int ny = y + dy;
+                if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height) { continue; }
+
+                int next = ny * m_width + nx;
+                if (m_clearance[next] == -1)
+                {
+                    m_clearance[next] = m_clearance[tile] + 1;
+                    fringe.push_back(next);
+                }
+            }
+        }
+    }
+}
+
+// grows regions from the widest open areas inwards toward the narrow parts of the map
+// two regions meeting at a tile much narrower than both of them are kept apart, and that tile becomes part of a choke
+void RegionMap::computeWatershed(const std::vector<bool> & walkable)
+{
+    const int numTiles = m_width * m_height;
+
+    // bucket the walkable tiles by clearance so they can be visited widest first
+    int maxClearance = 0;
+    for (int i(0); i < numTiles; ++i)
+    {
+        if (walkable[i]) { maxClearance = std::max(maxClearance, m_clearance[i]); }
+    }
+
+    std::vector<std::vector<int>> buckets(maxClearance + 1);
+    for (int i(0); i < numTiles; ++i)
+    {
+        if (walkable[i]) { buckets[m_clearance[i]].push_back(i); }
+    }
+
+    std::vector<int> label(numTiles, -1);
+    std::vector<int> parent;
+    std::vector<int> peak;
+    std::vector<int> size;
+    std::vector<std::array<int, 3>> frontier;   // tile, region, region
+
+    for (int c(maxClearance); c >= 0; --c)
+    {
+        for (int tile : buckets[c])
+        {
+            int x = tile % m_width;
+            int y = tile / m_width;
+
+            int roots[LegalActions];
+            int numRoots = 0;
+            for (int a(0); a < LegalActions; ++a)
+            {
+                int nx = x + actionX[a];
+                int ny = y + actionY[a];
+                if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height) { continue; }
+
+                int neighbour = label[ny * m_width + nx];
+                if (neighbour == -1) { continue; }
+
+                int root = FindRoot(parent, neighbour);
+                if (std::find(roots, roots + numRoots, root) == roots + numRoots)
+                {
+                    roots[numRoots++] = root;
+                }
+            }
+
+            // a local maximum of clearance starts a new region
+            if (numRoots == 0)
+            {
+                label[tile] = (int)parent.size();
+                parent.push_back(label[tile]);
+                peak.push_back(c);
+                size.push_back(1);
+                continue;
+            }
+
+            int region = roots[0];
+            for (int r(1); r < numRoots; ++r)
+            {
+                int other = roots[r];
+                bool small  = size[region] < MinRegionSize || size[other] < MinRegionSize;
+                bool narrow = c < ChokeClearanceRatio * std::min(peak[region], peak[other]);
+
+                if (small || !narrow)
+                {
+                    // the bigger region absorbs the other one
+                    if (size[other] > size[region]) { std::swap(region, other); }
+                    parent[other] = region;
+                    size[region] += size[other];
+                    peak[region] = std::max(peak[region], peak[other]);
+                }
+                else
+                {
+                    frontier.push_back({tile, region, other});
+                }
+            }
+
+            label[tile] = region;
+            size[region]++;
+        }
+    }
+
+    // give the final regions consecutive ids
+    std::vector<int> regionOf(parent.size(), -1);
+    m_regions.clear();
+    m_regionID.assign(numTiles, -1);
+    m_regionIndex.assign(numTiles, -1);
+
+    for (int i(0); i < numTiles; ++i)
+    {
+        if (label[i] == -1) { continue; }
+
+        int root = FindRoot(parent, label[i]);
+        if (regionOf[root] == -1)
+        {
+            regionOf[root] = (int)m_regions.size();
+            m_regions.push_back(Region());
+            m_regions.back().id = regionOf[root];
+            m_regions.back().maxClearance = 0;
+        }
+
+        Region & region = m_regions[regionOf[root]];
+        m_regionID[i]    = region.id;
+        m_regionIndex[i] = (int)region.tiles.size();
+        region.tiles.push_back(i);
+
+        if (m_clearance[i] > region.maxClearance || region.tiles.size() == 1)
+        {
+            region.maxClearance = m_clearance[i];
+            region.center = CCTilePosition(i % m_width, i / m_width);
+        }
+    }
+
+    for (auto & f : frontier)
+    {
+        f[1] = regionOf[FindRoot(parent, f[1])];
+        f[2] = regionOf[FindRoot(parent, f[2])];
+    }
+
+    computeChokes(frontier);
+}
+
+void RegionMap::computeChokes(const std::vector<std::array<int, 3>> & frontier)
+{
+    m_chokes.clear();
+
+    // group the frontier tiles by the regions they separate, then split each group into nearby clusters
+    std::map<std::pair<int, int>, std::vector<int>> chokesBetween;
+    for (auto & f : frontier)
+    {
+        if (f[1] == f[2]) { continue; }
+
+        std::pair<int, int> regions(std::min(f[1], f[2]), std::max(f[1], f[2]));
+        CCTilePosition tile(f[0] % m_width, f[0] / m_width);
+
+        Choke * choke = nullptr;
+        for (int chokeID : chokesBetween[regions])
+        {
+            for (auto & t : m_chokes[chokeID].tiles)
+            {
+                if (std::abs(t.x - tile.x) <= ChokeClusterDistance && std::abs(t.y - tile.y) <= ChokeClusterDistance)
+                {
+                    choke = &m_chokes[chokeID];
+                    break;
+                }
+            }
+
+            if (choke) { break; }
+        }
+
+        if (choke == nullptr)
+        {
+            chokesBetween[regions].push_back((int)m_chokes.size());
+            m_chokes.push_back(Choke());
+            choke = &m_chokes.back();
+            choke->id = (int)m_chokes.size() - 1;
+            choke->regionA = regions.first;
+            choke->regionB = regions.second;
+        }
+
+        choke->tiles.push_back(tile);
+    }
+
+    // the center of a choke is its tile closest to the average of all its tiles
+    for (auto & choke : m_chokes)
+    {
+        float cx = 0;
+        float cy = 0;
+        for (auto & tile : choke.tiles)
+        {
+            cx += tile.x;
+            cy += tile.y;
+        }
+
+        cx /= choke.tiles.size();
+        cy /= choke.tiles.size();
+
+        float bestDist = std::numeric_limits<float>::max();
+        for (auto & tile : choke.tiles)
+        {
+            float dist = (tile.x - cx) * (tile.x - cx) + (tile.y - cy) * (tile.y - cy);
+            if (dist < bestDist)
+            {
+                bestDist = dist;
+                choke.center = tile;
+            }
+        }
+
+        m_regions[choke.regionA].chokes.push_back(choke.id);
+        m_regions[choke.regionB].chokes.push_back(choke.id);
+    }
+}
+
+// each choke gets a BFS over its two regions, then the chokes are joined into an all pairs distance table
+void RegionMap::computeChokeDistances()
+{
+    const int numChokes = (int)m_chokes.size();
+    m_chokeFields.assign(numChokes, std::array<std::vector<int>, 2>());
+
+    std::vector<int> dist(m_width * m_height, -1);
+    std::vector<int> fringe;
+    fringe.reserve(m_width * m_height);
+
+    for (auto & choke : m_chokes)
+    {
+        fringe.clear();
+        int start = choke.center.y * m_width + choke.center.x;
+        dist[start] = 0;
+        fringe.push_back(start);
+
+        for (size_t fringeIndex=0; fringeIndex<fringe.size(); ++fringeIndex)
+        {
+            int tile = fringe[fringeIndex];
+            int x = tile % m_width;
+            int y = tile / m_width;
+
+            for (int a(0); a < LegalActions; ++a)
+            {
+                int nx = x + actionX[a];
+                int ny = y + actionY[a];
+                if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height) { continue; }
+
+                int next = ny * m_width + nx;
+                int region = m_regionID[next];
+                if (dist[next] != -1 || (region != choke.regionA && region != choke.regionB)) { continue; }
+
+                dist[next] = dist[tile] + 1;
+                fringe.push_back(next);
+            }
+        }
+
+        // store the result by region index and reset the touched tiles for the next choke
+        auto & fields = m_chokeFields[choke.id];
+        fields[0].assign(m_regions[choke.regionA].tiles.size(), -1);
+        fields[1].assign(m_regions[choke.regionB].tiles.size(), -1);
+
+        for (int tile : fringe)
+        {
+            int side = m_regionID[tile] == choke.regionA ? 0 : 1;
+            fields[side][m_regionIndex[tile]] = dist[tile];
+            dist[tile] = -1;
+        }
+    }
+
+    // direct distances between chokes sharing a region, measured to the closest tile of the other choke
+    std::vector<int> chokeDist(numChokes * numChokes, Unreachable);
+    for (int c(0); c < numChokes; ++c)
+    {
+        chokeDist[c * numChokes + c] = 0;
+    }
+
+    for (auto & region : m_regions)
+    {
+        for (int from : region.chokes)
+        {
+            for (int to : region.chokes)
+            {
+                if (from == to) { continue; }
+
+                const CCTilePosition & center = m_chokes[to].center;
+                int best = Unreachable;
+                for (auto & tile : m_chokes[to].tiles)
+                {
+                    // the choke tile itself or one of its neighbours lies in the shared region
+                    for (int a(-1); a < LegalActions; ++a)
+                    {
+                        int tx = tile.x + (a >= 0 ? actionX[a] : 0);
+                        int ty = tile.y + (a >= 0 ? actionY[a] : 0);
+                        if (tx < 0 || ty < 0 || tx >= m_width || ty >= m_height) { continue; }
+
+                        int d = getDistanceToChoke(from, ty * m_width + tx);
+                        if (d < 0) { continue; }
+
+                        best = std::min(best, d + std::abs(tx - center.x) + std::abs(ty - center.y));
+                    }
+                }
+
+                int & current = chokeDist[from * numChokes + to];
+                current = std::min(current, best);
+            }
+        }
+    }
+
+    // the choke graph is small, so floyd-warshall is simplest
+    for (int k(0); k < numChokes; ++k)
+    {
+        for (int i(0); i < numChokes; ++i)
+        {
+            int ik = chokeDist[i * numChokes + k];
+            if (ik == Unreachable) { continue; }
+
+            for (int j(0); j < numChokes; ++j)
+            {
+                int kj = chokeDist[k * numChokes + j];
+                if (kj == Unreachable) { continue; }
+
+                int & ij = chokeDist[i * numChokes + j];
+                ij = std::min(ij, ik + kj);
+            }
+        }
+    }
+
+    m_chokeDist.resize(chokeDist.size());
+    for (size_t i(0); i < chokeDist.size(); ++i)
+    {
+        m_chokeDist[i] = chokeDist[i] == Unreachable ? -1 : chokeDist[i];
+    }
+}
+
+int RegionMap::getDistanceToChoke(int chokeID, int tileIndex) const
+{
+    const Choke & choke = m_chokes[chokeID];
+    int region = m_regionID[tileIndex];
+
+    if (region == choke.regionA) { return m_chokeFields[chokeID][0][m_regionIndex[tileIndex]]; }
+    if (region == choke.regionB) { return m_chokeFields[chokeID][1][m_regionIndex[tileIndex]]; }
+
+    return -1;
+}
+
+int RegionMap::getGroundDistance(const CCTilePosition & from, const CCTilePosition & to) const
+{
+    int fromRegion = getRegionID(from.x, from.y);
+    int toRegion   = getRegionID(to.x, to.y);
+    if (fromRegion == -1 || toRegion == -1)
+    {
+        return -1;
+    }
+
+    if (fromRegion == toRegion)
+    {
+        return std::abs(from.x - to.x) + std::abs(from.y - to.y);
+    }
+
+    const int numChokes = (int)m_chokes.size();
+    const int fromIndex = from.y * m_width + from.x;
+    const int toIndex   = to.y * m_width + to.x;
+
+    int best = Unreachable;
+    for (int fromChoke : m_regions[fromRegion].chokes)
+    {
+        int fromDist = getDistanceToChoke(fromChoke, fromIndex);
+        if (fromDist < 0) { continue; }
+
+        for (int toChoke : m_regions[toRegion].chokes)
+        {
+            int toDist = getDistanceToChoke(toChoke, toIndex);
+            int between = m_chokeDist[fromChoke * numChokes + toChoke];
+            if (toDist < 0 || between < 0) { continue; }
+
+            best = std::min(best, fromDist + between + toDist);
+        }
+    }
+
+    return best == Unreachable ? -1 : best;
+}
+
+int RegionMap::getRegionID(int tileX, int tileY) const
+{
+    if (tileX < 0 || tileY < 0 || tileX >= m_width || tileY >= m_height)
+    {
+        return -1;
+    }
+
+    return m_regionID[tileY * m_width + tileX];
+}
+
+int RegionMap::getClearance(int tileX, int tileY) const
+{
+    if (tileX < 0 || tileY < 0 || tileX >= m_width || tileY >= m_height)
+    {
+        return 0;
+    }
+
+    return m_clearance[tileY * m_width + tileX];
+}
+
+const std::vector<Region> & RegionMap::getRegions() const
+{
+    return m_regions;
+}
+
+const std::vector<Choke> & RegionMap::getChokes() const
+{
+    return m_chokes;
+}
+
+const std::vector<int> & RegionMap::getChokeField(int chokeID, int side) const
+{
+    return m_chokeFields[chokeID][side];
+}
+
+int RegionMap::getChokeDistance(int fromChoke, int toChoke) const
+{
+    return m_chokeDist[fromChoke * m_chokes.size() + toChoke];
+}
+
+void RegionMap::draw(const MapTools & map) const
+{
+    for (auto & region : m_regions)
+    {
+        std::stringstream ss;
+        ss << "Region " << region.id << "\n" << region.tiles.size() << " tiles, " << region.chokes.size() << " chokes";
+        map.drawText(Util::GetPosition(region.center), ss.str(), CCColor(255, 255, 0));
+    }
+
+    for (auto & choke : m_chokes)
+    {
+        for (auto & tile : choke.tiles)
+        {
+            map.drawTile(tile.x, tile.y, CCColor(255, 128, 0));
+        }
+
+        map.drawCircle(Util::GetPosition(choke.center), Util::TileToPosition(1.0f), CCColor(255, 0, 0));
+    }
+}
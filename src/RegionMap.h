@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+    class MapTools;
+    class MapCache;
+
+    struct Choke
+    {
+        int                         id;
+        int                         regionA;
+        int                         regionB;
+        CCTilePosition              center;
+        std::vector<CCTilePosition> tiles;
+    };
+
+    struct Region
+    {
+        int                         id;
+        int                         maxClearance;
+        CCTilePosition              center;
+        std::vector<int>            tiles;      // row-major tile indices belonging to this region
+        std::vector<int>            chokes;     // ids of the chokes on this region's border
+    };
+
+    // Splits the walkable tiles of the map into open regions joined by chokepoints, using a watershed
+    // on each tile's clearance from unwalkable terrain. Every choke stores the walk distance to the tiles
+    // of its two regions and the shortest walk distance to every other choke, so ground distance between
+    // any two tiles is answered from a handful of table lookups instead of a full map search.
+    // All of it is stored in the map cache, so only the first game on a map computes it.
+    class RegionMap
+    {
+        int m_width;
+        int m_height;
+
+        std::vector<int>                m_clearance;        // walk distance to the nearest unwalkable tile, row-major
+        std::vector<int>                m_regionID;         // region of each tile or -1 if unwalkable, row-major
+        std::vector<int>                m_regionIndex;      // index of each tile within its region's tile list, row-major
+        std::vector<Region>             m_regions;
+        std::vector<Choke>              m_chokes;
+
+        // m_chokeFields[c][0 or 1] = distance from choke c to each tile of its region A or B, by region index
+        std::vector<std::array<std::vector<int>, 2>> m_chokeFields;
+
+        // m_chokeDist[a * numChokes + b] = shortest walk distance between chokes a and b, -1 if not connected
+        std::vector<int>                m_chokeDist;
+
+        void computeClearance(const std::vector<bool> & walkable);
+        void computeWatershed(const std::vector<bool> & walkable);
+        void computeChokes(const std::vector<std::array<int, 3>> & frontier);
+        void computeChokeDistances();
+
+        int  getDistanceToChoke(int chokeID, int tileIndex) const;
+
+    public:
+
+        RegionMap();
+
+        void computeRegions(const MapTools & map);
+        void load(const MapCache & cache);
+
+        int  getRegionID(int tileX, int tileY) const;
+        int  getClearance(int tileX, int tileY) const;
+        const std::vector<Region> & getRegions() const;
+        const std::vector<Choke> & getChokes() const;
+
+        // the tables stored in the map cache: a choke's distances to the tiles of region A (side 0) or B (side 1)
+        // by region index, and the walk distance between two chokes or -1 if they aren't connected
+        const std::vector<int> & getChokeField(int chokeID, int side) const;
+        int  getChokeDistance(int fromChoke, int toChoke) const;
+
+        // approximate 4-connected walk distance between two tiles, or -1 if they aren't connected
+        // tiles in the same region use their manhattan distance, otherwise the best route through the chokes
+        int  getGroundDistance(const CCTilePosition & from, const CCTilePosition & to) const;
+
+        void draw(const MapTools & map) const;
+    };
+}
@@ -49,7 +49,7 @@ void ScoutManager::setCombatUnitScout(const Unit& unit)
 
 void ScoutManager::drawScoutInformation()
 {
-    if (!m_bot.Config().DrawScoutInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::ScoutInfo))
     {
         return;
     }
@@ -35,10 +35,12 @@ void Squad::onFrame()
     // update all necessary unit information within this squad
     updateUnits();
 
-    // we are currently regrouping
+    // we are currently regrouping, the units are stepped along the flow field toward the regroup position
     if (m_regroupingFrames > 0)
     {
         m_regroupingFrames--;
+        m_meleeManager.regroup(m_regroupPosition);
+        m_rangedManager.regroup(m_regroupPosition);
         return;
     }
     // determine whether or not we should regroup
@@ -49,12 +51,15 @@ void Squad::onFrame()
     {
         m_regroupingFrames = 80;
         
-        CCPosition regroupPosition = calcRegroupPosition();
+        m_regroupPosition = calcRegroupPosition();
 
-        m_bot.Map().drawCircle(regroupPosition, 3, CCColor(255, 0, 255));
+        if (m_bot.Draw().isEnabled(DebugCategory::SquadInfo))
+        {
+            m_bot.Map().drawCircle(m_regroupPosition, 3, CCColor(255, 0, 255));
+        }
 
-        m_meleeManager.regroup(regroupPosition);
-        m_rangedManager.regroup(regroupPosition);
+        m_meleeManager.regroup(m_regroupPosition);
+        m_rangedManager.regroup(m_regroupPosition);
     }
     else // otherwise, execute micro
     {
@@ -175,11 +180,12 @@ bool Squad::needsToRegroup() const
 
     float minDist = std::numeric_limits<float>::max();
     Unit minDistUnit;
+    const FlowField & flowField = m_bot.Map().getFlowField(m_order.getPosition());
 
     // regroup if there is a big gap between the units attacking. 
     for (auto & unit : m_units)
     {
-        float dist = Util::Dist(m_order.getPosition(), unit.getPosition());
+        float dist = getDistanceToOrder(flowField, unit);
         if (dist < minDist)
         {
             minDist = dist;
@@ -233,9 +239,11 @@ bool Squad::isUnitNearEnemy(const Unit & unit) const
 {
     BOT_ASSERT(unit.isValid(), "null unit in squad");
 
-    for (auto & u : m_bot.GetUnits())
+    // any enemy we can see counts, buildings, workers and unarmed units included, so the threat map
+    // can't answer this: it leaves unarmed units out and keeps the threat of units we no longer see
+    for (auto & u : m_bot.UnitInfo().getUnits(Players::Enemy))
     {
-        if ((u.getPlayer() == Players::Enemy) && (Util::Dist(unit, u) < 20))
+        if (Util::Dist(unit, u) < 20)
         {
             return true;
         }
@@ -268,12 +276,13 @@ CCPosition Squad::calcRegroupPosition() const
     float minDist = std::numeric_limits<float>::max();
 
     //regroup = calcCenter();
+    const FlowField & flowField = m_bot.Map().getFlowField(m_order.getPosition());
 
     for (auto unit : m_units)
     {
         //if (!m_nearEnemy.at(unit))
         //{
-            float dist = Util::Dist(m_order.getPosition(), unit.getPosition());
+            float dist = getDistanceToOrder(flowField, unit);
             if (dist < minDist)
             {
                 minDist = dist;
@@ -296,13 +305,14 @@ Unit Squad::unitClosestToEnemy() const
 {
     Unit closest;
     float closestDist = std::numeric_limits<float>::max();
+    const FlowField & flowField = m_bot.Map().getFlowField(m_order.getPosition());
 
     for (auto & unit : m_units)
     {
         BOT_ASSERT(unit.isValid(), "null unit");
 
         // the distance to the order position
-        int dist = m_bot.Map().getGroundDistance(unit.getPosition(), m_order.getPosition());
+        int dist = flowField.getDistance(unit.getPosition());
 
         if (dist != -1 && (!closest.isValid() || dist < closestDist))
         {
@@ -314,6 +324,19 @@ Unit Squad::unitClosestToEnemy() const
     return closest;
 }
 
+// ground distance along the order's flow field, or straight line distance for units that can't walk there,
+// both in position units
+float Squad::getDistanceToOrder(const FlowField & flowField, const Unit & unit) const
+{
+    int groundDist = flowField.getDistance(unit.getPosition());
+    if (groundDist == -1 || unit.isFlying())
+    {
+        return Util::Dist(m_order.getPosition(), unit.getPosition());
+    }
+
+    return Util::TileToPosition((float)groundDist);
+}
+
 int Squad::squadUnitsNear(const CCPosition & p) const
 {
     int numUnits = 0;
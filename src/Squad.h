@@ -8,6 +8,7 @@
 namespace CC
 {
     class CCBot;
+    class FlowField;
 
     class Squad
     {
@@ -17,6 +18,7 @@ namespace CC
         std::set<Unit> m_units;
         std::string         m_regroupStatus;
         int					m_regroupingFrames;
+        CCPosition          m_regroupPosition;
         int                 m_lastRetreatSwitch;
         bool                m_lastRetreatSwitchVal;
         size_t              m_priority;
@@ -35,6 +37,7 @@ namespace CC
         void setAllUnits();
 
         bool isUnitNearEnemy(const Unit & unit) const;
+        float getDistanceToOrder(const FlowField & flowField, const Unit & unit) const;
         bool needsToRegroup() const;
         int  squadUnitsNear(const CCPosition & pos) const;
 
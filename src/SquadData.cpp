@@ -85,7 +85,7 @@ void SquadData::updateAllSquads()
 
 void SquadData::drawSquadInformation()
 {
-    if (!m_bot.Config().DrawSquadInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::SquadInfo))
     {
         return;
     }
@@ -0,0 +1,205 @@
+#include "StaleTileIndex.h"
+#include "MapTools.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace CC;
+
+StaleTileIndex::StaleTileIndex()
+    : m_width(0)
+    , m_height(0)
+{
+
+}
+
+void StaleTileIndex::build(const MapTools & map, const TileList & tiles)
+{
+    const RegionMap & regions = map.getRegionMap();
+
+    m_width  = map.width();
+    m_height = map.height();
+    m_next.assign(m_width * m_height, -1);
+    m_prev.assign(m_width * m_height, -1);
+    m_bucket.assign(m_width * m_height, -1);
+    m_rank.assign(m_width * m_height, -1);
+    m_region.assign(m_width * m_height, -1);
+    m_regionBuckets.assign(regions.getRegions().size(), std::deque<Bucket>());
+    m_firstBucket.assign(regions.getRegions().size(), 0);
+    m_regionCenters.clear();
+
+    for (auto & region : regions.getRegions())
+    {
+        m_regionCenters.push_back(region.center);
+    }
+
+    // nothing else has been seen yet, so every hidden tile starts in the first bucket of its region in walking order.
+    // tiles visible at the start only enter a bucket once they are hidden, since updates only report changes
+    for (size_t i(0); i < tiles.size(); ++i)
+    {
+        const CCTilePosition & tile = tiles[i];
+        int region = regions.getRegionID(tile.x, tile.y);
+        if (region == -1) { continue; }
+
+        int index = tile.y * m_width + tile.x;
+        m_rank[index] = (int)i;
+        m_region[index] = region;
+
+        if (!map.isVisible(tile.x, tile.y))
+        {
+            insert(index, 0);
+        }
+    }
+}
+
+void StaleTileIndex::update(const std::vector<CCTilePosition> & revealed, const std::vector<CCTilePosition> & hidden, int lastSeenFrame)
+{
+    for (auto & tile : revealed)
+    {
+        int index = tile.y * m_width + tile.x;
+        if (m_bucket[index] != -1)
+        {
+            remove(index);
+        }
+    }
+
+    // tiles hidden together share a bucket, keep them in walking order so the head is the closest one
+    m_hidden.clear();
+    for (auto & tile : hidden)
+    {
+        int index = tile.y * m_width + tile.x;
+        if (m_rank[index] != -1 && m_bucket[index] == -1)
+        {
+            m_hidden.push_back(index);
+        }
+    }
+
+    std::sort(m_hidden.begin(), m_hidden.end(), [this](int a, int b) { return m_rank[a] < m_rank[b]; });
+
+    for (int index : m_hidden)
+    {
+        insert(index, lastSeenFrame);
+    }
+}
+
+void StaleTileIndex::insert(int tile, int frame)
+{
+    const int region = m_region[tile];
+    std::deque<Bucket> & buckets = m_regionBuckets[region];
+
+    // tiles are always hidden at the current frame, so only the back bucket can match
+    if (buckets.empty() || buckets.back().frame != frame)
+    {
+        buckets.push_back({ frame, -1, -1 });
+    }
+
+    Bucket & bucket = buckets.back();
+    m_prev[tile] = bucket.tail;
+    m_next[tile] = -1;
+
+    if (bucket.tail != -1) { m_next[bucket.tail] = tile; }
+    else                   { bucket.head = tile; }
+
+    bucket.tail = tile;
+    m_bucket[tile] = m_firstBucket[region] + (int)buckets.size() - 1;
+}
+
+void StaleTileIndex::remove(int tile)
+{
+    const int region = m_region[tile];
+    std::deque<Bucket> & buckets = m_regionBuckets[region];
+    Bucket & bucket = buckets[m_bucket[tile] - m_firstBucket[region]];
+
+    if (m_prev[tile] != -1) { m_next[m_prev[tile]] = m_next[tile]; }
+    else                    { bucket.head = m_next[tile]; }
+
+    if (m_next[tile] != -1) { m_prev[m_next[tile]] = m_prev[tile]; }
+    else                    { bucket.tail = m_prev[tile]; }
+
+    m_next[tile] = -1;
+    m_prev[tile] = -1;
+    m_bucket[tile] = -1;
+
+    // empty buckets in the middle are dropped once they reach either end
+    while (!buckets.empty() && buckets.front().head == -1)
+    {
+        buckets.pop_front();
+        m_firstBucket[region]++;
+    }
+
+    while (!buckets.empty() && buckets.back().head == -1)
+    {
+        buckets.pop_back();
+    }
+}
+
+int StaleTileIndex::getStalestTile(int region, int & frame) const
+{
+    for (auto & bucket : m_regionBuckets[region])
+    {
+        if (bucket.head != -1)
+        {
+            frame = bucket.frame;
+            return bucket.head;
+        }
+    }
+
+    return -1;
+}
+
+bool StaleTileIndex::getLeastRecentlySeenTile(CCTilePosition & tile) const
+{
+    int bestTile = -1;
+    int bestFrame = 0;
+
+    for (size_t r(0); r < m_regionBuckets.size(); ++r)
+    {
+        int frame = 0;
+        int head = getStalestTile((int)r, frame);
+        if (head == -1) { continue; }
+
+        if (bestTile == -1 || frame < bestFrame || (frame == bestFrame && m_rank[head] < m_rank[bestTile]))
+        {
+            bestTile = head;
+            bestFrame = frame;
+        }
+    }
+
+    if (bestTile == -1)
+    {
+        return false;
+    }
+
+    tile = CCTilePosition(bestTile % m_width, bestTile / m_width);
+    return true;
+}
+
+void StaleTileIndex::getStalestTiles(const CCPosition & pos, float radius, size_t k, std::vector<CCTilePosition> & tiles) const
+{
+    tiles.clear();
+
+    // (last seen frame, distance, tile) of each region's stalest tile
+    std::vector<std::tuple<int, float, int>> candidates;
+    for (size_t r(0); r < m_regionBuckets.size(); ++r)
+    {
+        float dist = Util::Dist(pos, Util::GetPosition(m_regionCenters[r]));
+        if (radius > 0 && dist > radius) { continue; }
+
+        int frame = 0;
+        int head = getStalestTile((int)r, frame);
+        if (head != -1)
+        {
+            candidates.push_back(std::make_tuple(frame, dist, head));
+        }
+    }
+
+    size_t count = std::min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+
+    for (size_t i(0); i < count; ++i)
+    {
+        int head = std::get<2>(candidates[i]);
+        tiles.push_back(CCTilePosition(head % m_width, head / m_width));
+    }
+}
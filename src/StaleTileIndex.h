@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Common.h"
+#include "DistanceMap.h"
+
+#include <deque>
+
+namespace CC
+{
+    class MapTools;
+
+    // Every hidden tile we can walk to, bucketed by its region and the frame it was last seen.
+    // Tiles only ever enter the newest bucket of their region when they are hidden and leave their bucket
+    // when they are revealed, so each region's buckets stay sorted oldest first and the stalest tile of a
+    // region is always the head of its front bucket. Nothing is rescanned when asking for stale tiles.
+    class StaleTileIndex
+    {
+        struct Bucket
+        {
+            int frame;
+            int head;
+            int tail;
+        };
+
+        int                                 m_width;
+        int                                 m_height;
+        std::vector<int>                    m_next;             // next tile in the same bucket or -1, row-major
+        std::vector<int>                    m_prev;             // previous tile in the same bucket or -1, row-major
+        std::vector<int>                    m_bucket;           // bucket sequence number of a tile or -1 if it isn't in one, row-major
+        std::vector<int>                    m_rank;             // walk order from our start location or -1 if not indexed, row-major
+        std::vector<int>                    m_region;           // region of each tile, row-major
+        std::vector<std::deque<Bucket>>     m_regionBuckets;    // each region's buckets, oldest first
+        std::vector<int>                    m_firstBucket;      // sequence number of the front bucket of each region
+        std::vector<CCTilePosition>         m_regionCenters;
+        std::vector<int>                    m_hidden;           // this update's hidden tiles, sorted by rank
+
+        void insert(int tile, int frame);
+        void remove(int tile);
+        int  getStalestTile(int region, int & frame) const;
+
+    public:
+
+        StaleTileIndex();
+
+        // tiles are ranked in the order given, which should be walking order from our start location
+        void build(const MapTools & map, const TileList & tiles);
+        void update(const std::vector<CCTilePosition> & revealed, const std::vector<CCTilePosition> & hidden, int lastSeenFrame);
+
+        // the hidden tile seen longest ago, ties going to the tile closest to our start location
+        // returns false if every tile is visible
+        bool getLeastRecentlySeenTile(CCTilePosition & tile) const;
+
+        // the stalest tile of each of the k stalest regions with a center within radius of pos, stalest first
+        // a radius of zero or less considers the whole map
+        void getStalestTiles(const CCPosition & pos, float radius, size_t k, std::vector<CCTilePosition> & tiles) const;
+    };
+}
@@ -0,0 +1,80 @@
+#include "StandInObservation.h"
+#include <algorithm>
+
+using namespace CC;
+
+#ifdef SC2API
+
+StandInObservation::StandInObservation()
+    : race(sc2::Race::Protoss)
+{
+
+}
+
+// every tile starts out unwalkable, unbuildable and at ground level
+void StandInObservation::reset(int width, int height)
+{
+    BOT_ASSERT((width * height) % 8 == 0, "Stand-in map size must fill whole bytes: %d x %d", width, height);
+
+    gameInfo = sc2::GameInfo();
+    gameInfo.width  = width;
+    gameInfo.height = height;
+    gameInfo.playable_min = sc2::Point2D(0.0f, 0.0f);
+    gameInfo.playable_max = sc2::Point2D((float)width, (float)height);
+
+    // the pathing and placement grids pack one tile per bit, the height grid one tile per byte
+    for (sc2::ImageData * grid : { &gameInfo.pathing_grid, &gameInfo.placement_grid, &gameInfo.terrain_height })
+    {
+        grid->width  = width;
+        grid->height = height;
+    }
+
+    gameInfo.pathing_grid.bits_per_pixel   = 1;
+    gameInfo.placement_grid.bits_per_pixel = 1;
+    gameInfo.terrain_height.bits_per_pixel = 8;
+    gameInfo.pathing_grid.data   = std::string(width * height / 8, (char)0xFF);
+    gameInfo.placement_grid.data = std::string(width * height / 8, (char)0x00);
+    gameInfo.terrain_height.data = std::string(width * height, (char)128);
+
+    units.clear();
+    startLocation = CCPosition(0.0f, 0.0f);
+}
+
+// a set pathing bit marks a tile units can't walk on, which is how MapTools::canWalk decodes it
+void StandInObservation::setWalkable(int tileX, int tileY, bool walkable)
+{
+    const int index = tileY * gameInfo.width + tileX;
+    const char bit = (char)(1 << (7 - (index % 8)));
+    char & byte = gameInfo.pathing_grid.data[index / 8];
+    byte = walkable ? (char)(byte & ~bit) : (char)(byte | bit);
+}
+
+void StandInObservation::setBuildable(int tileX, int tileY, bool buildable)
+{
+    const int index = tileY * gameInfo.width + tileX;
+    const char bit = (char)(1 << (7 - (index % 8)));
+    char & byte = gameInfo.placement_grid.data[index / 8];
+    byte = buildable ? (char)(byte | bit) : (char)(byte & ~bit);
+}
+
+void StandInObservation::setTerrainHeight(int tileX, int tileY, float height)
+{
+    const float encoded = (height + 16.0f) * 255.0f / 32.0f;
+    gameInfo.terrain_height.data[tileY * gameInfo.width + tileX] = (char)(uint8_t)std::max(0.0f, std::min(255.0f, encoded));
+}
+
+void StandInObservation::addUnit(const sc2::UnitTypeID & type, const CCPosition & pos, sc2::Unit::Alliance alliance)
+{
+    sc2::Unit unit;
+    unit.display_type   = sc2::Unit::DisplayType::Visible;
+    unit.alliance       = alliance;
+    unit.tag            = (sc2::Tag)(units.size() + 1);
+    unit.unit_type      = type;
+    unit.owner          = alliance == sc2::Unit::Alliance::Self ? 1 : (alliance == sc2::Unit::Alliance::Enemy ? 2 : 16);
+    unit.pos            = sc2::Point3D(pos.x, pos.y, 0.0f);
+    unit.is_alive       = true;
+    unit.build_progress = 1.0f;
+    units.push_back(unit);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+#ifdef SC2API
+    // The parts of a game observation the map analysis reads at game start, filled in without a game.
+    // CCBot::OnStandInGameStart runs the map analysis against it, which lets the map stack be measured
+    // on generated maps. The grids use the same encoding as the ones the game sends.
+    class StandInObservation
+    {
+    public:
+
+        sc2::GameInfo           gameInfo;
+        std::vector<sc2::Unit>  units;
+        CCPosition              startLocation;
+        CCRace                  race;
+
+        StandInObservation();
+
+        void    reset(int width, int height);
+        void    setWalkable(int tileX, int tileY, bool walkable);
+        void    setBuildable(int tileX, int tileY, bool buildable);
+        void    setTerrainHeight(int tileX, int tileY, float height);
+        void    addUnit(const sc2::UnitTypeID & type, const CCPosition & pos, sc2::Unit::Alliance alliance);
+    };
+#endif
+}
@@ -0,0 +1,85 @@
+#include "SummedAreaTable.h"
+
+#include <algorithm>
+
+using namespace CC;
+
+SummedAreaTable::SummedAreaTable()
+{
+    reset(0, 0);
+}
+
+void SummedAreaTable::reset(int width, int height)
+{
+    m_width  = width;
+    m_height = height;
+    m_values.assign(width * height, 0);
+    m_sums.assign((width + 1) * (height + 1), 0);
+    m_dirtyX = width;
+    m_dirtyY = height;
+}
+
+void SummedAreaTable::set(int x, int y, bool value)
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return;
+    }
+
+    uint8_t & tile = m_values[y * m_width + x];
+    if (tile != (uint8_t)value)
+    {
+        tile = (uint8_t)value;
+        m_dirtyX = std::min(m_dirtyX, x);
+        m_dirtyY = std::min(m_dirtyY, y);
+    }
+}
+
+// sums left of or above the first changed tile don't include it, so only the rest is recomputed
+void SummedAreaTable::update()
+{
+    const int stride = m_width + 1;
+    for (int y(m_dirtyY); y < m_height; ++y)
+    {
+        for (int x(m_dirtyX); x < m_width; ++x)
+        {
+            m_sums[(y + 1) * stride + x + 1] = m_values[y * m_width + x]
+                                             + m_sums[(y + 1) * stride + x]
+                                             + m_sums[y * stride + x + 1]
+                                             - m_sums[y * stride + x];
+        }
+    }
+
+    m_dirtyX = m_width;
+    m_dirtyY = m_height;
+}
+
+bool SummedAreaTable::get(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+    {
+        return false;
+    }
+
+    return m_values[y * m_width + x] != 0;
+}
+
+int SummedAreaTable::count(int x0, int y0, int x1, int y1) const
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_width);
+    y1 = std::min(y1, m_height);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return 0;
+    }
+
+    const int stride = m_width + 1;
+    return m_sums[y1 * stride + x1] - m_sums[y0 * stride + x1] - m_sums[y1 * stride + x0] + m_sums[y0 * stride + x0];
+}
+
+bool SummedAreaTable::any(int x0, int y0, int x1, int y1) const
+{
+    return count(x0, y0, x1, y1) > 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+    // A grid of flags and its integral image, so the number of set tiles in any rectangle is four lookups.
+    // Changing tiles only records the smallest changed coordinates, and update() recomputes the sums right of
+    // and below them, which for a handful of changed tiles is a fraction of rebuilding the table.
+    class SummedAreaTable
+    {
+        int                     m_width;
+        int                     m_height;
+        std::vector<uint8_t>    m_values;   // row-major
+        std::vector<int>        m_sums;     // sum of the values in [0, x) x [0, y), row-major with a row and column of zeros
+        int                     m_dirtyX;   // smallest changed coordinates since the last update
+        int                     m_dirtyY;
+
+    public:
+
+        SummedAreaTable();
+
+        void    reset(int width, int height);
+        void    set(int x, int y, bool value);
+        void    update();
+
+        bool    get(int x, int y) const;
+
+        // the number of set tiles in [x0, x1) x [y0, y1), clipped to the grid
+        int     count(int x0, int y0, int x1, int y1) const;
+        bool    any(int x0, int y0, int x1, int y1) const;
+    };
+}
@@ -0,0 +1,219 @@
+#include "TerritoryMap.h"
+#include "BaseLocation.h"
+#include "CCBot.h"
+#include "Util.h"
+
+#include <queue>
+
+using namespace CC;
+
+TerritoryMap::TerritoryMap(CCBot & bot)
+    : m_bot(bot)
+    , m_width(0)
+    , m_height(0)
+{
+
+}
+
+void TerritoryMap::onStart()
+{
+    m_width  = m_bot.Map().width();
+    m_height = m_bot.Map().height();
+    m_distance.assign(m_width * m_height, -1);
+    m_source.assign(m_width * m_height, -1);
+    m_sources.clear();
+}
+
+void TerritoryMap::update(const std::set<const BaseLocation *> & selfBases, const std::set<const BaseLocation *> & enemyBases)
+{
+    // drop the bases that are no longer occupied by the player they were added for
+    for (size_t i(0); i < m_sources.size(); ++i)
+    {
+        const Source & source = m_sources[i];
+        if (!source.active) { continue; }
+
+        const std::set<const BaseLocation *> & bases = source.player == Players::Self ? selfBases : enemyBases;
+        if (bases.find(source.base) == bases.end())
+        {
+            removeSource((int)i);
+        }
+    }
+
+    // our bases go first, so they keep the tiles that are exactly as close to an enemy base
+    for (int player : {Players::Self, Players::Enemy})
+    {
+        for (const BaseLocation * base : player == Players::Self ? selfBases : enemyBases)
+        {
+            bool exists = false;
+            for (const Source & source : m_sources)
+            {
+                if (source.active && source.base == base && source.player == player)
+                {
+                    exists = true;
+                    break;
+                }
+            }
+
+            if (!exists)
+            {
+                addSource(base, player);
+            }
+        }
+    }
+}
+
+void TerritoryMap::addSource(const BaseLocation * base, int player)
+{
+    // reuse the slot of a base that was lost
+    int sourceIndex = (int)m_sources.size();
+    for (size_t i(0); i < m_sources.size(); ++i)
+    {
+        if (!m_sources[i].active)
+        {
+            sourceIndex = (int)i;
+            break;
+        }
+    }
+
+    if (sourceIndex == (int)m_sources.size())
+    {
+        m_sources.push_back(Source());
+    }
+
+    m_sources[sourceIndex] = { base, player, true };
+
+    const CCTilePosition & tile = base->getDepotPosition();
+    if (!m_bot.Map().isValidTile(tile)) { return; }
+
+    int index = tile.y * m_width + tile.x;
+    if (m_distance[index] == 0) { return; }
+
+    m_distance[index] = 0;
+    m_source[index] = sourceIndex;
+    flood({ std::make_pair(0, index) });
+}
+
+void TerritoryMap::removeSource(int sourceIndex)
+{
+    m_sources[sourceIndex].active = false;
+
+    // forget every tile the base owned, then let the neighbouring territories grow back into them
+    std::vector<int> cleared;
+    for (int i(0); i < m_width * m_height; ++i)
+    {
+        if (m_source[i] == sourceIndex)
+        {
+            m_source[i] = -1;
+            m_distance[i] = -1;
+            cleared.push_back(i);
+        }
+    }
+
+    std::vector<std::pair<int, int>> open;
+
+    // another player's base on the same depot tile was hidden behind this one
+    for (size_t i(0); i < m_sources.size(); ++i)
+    {
+        if (!m_sources[i].active) { continue; }
+
+        const CCTilePosition & tile = m_sources[i].base->getDepotPosition();
+        if (!m_bot.Map().isValidTile(tile)) { continue; }
+
+        int index = tile.y * m_width + tile.x;
+        if (m_source[index] == -1)
+        {
+            m_distance[index] = 0;
+            m_source[index] = (int)i;
+            open.push_back(std::make_pair(0, index));
+        }
+    }
+
+    for (int index : cleared)
+    {
+        int x = index % m_width;
+        int y = index / m_width;
+        for (auto & n : { CCTilePosition(x + 1, y), CCTilePosition(x - 1, y), CCTilePosition(x, y + 1), CCTilePosition(x, y - 1) })
+        {
+            if (!m_bot.Map().isValidTile(n)) { continue; }
+
+            int neighbor = n.y * m_width + n.x;
+            if (m_source[neighbor] != -1)
+            {
+                open.push_back(std::make_pair(m_distance[neighbor], neighbor));
+            }
+        }
+    }
+
+    flood(open);
+}
+
+// dijkstra with unit edge costs from tiles whose distances are already set, only ever lowers distances
+// territory follows the terrain, so bases flood out from under their own depots and buildings don't wall it off
+void TerritoryMap::flood(const std::vector<std::pair<int, int>> & open)
+{
+    typedef std::pair<int, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue(open.begin(), open.end());
+
+    while (!queue.empty())
+    {
+        Entry entry = queue.top();
+        queue.pop();
+
+        int index = entry.second;
+        if (entry.first != m_distance[index]) { continue; }
+
+        int x = index % m_width;
+        int y = index / m_width;
+        for (auto & n : { CCTilePosition(x + 1, y), CCTilePosition(x - 1, y), CCTilePosition(x, y + 1), CCTilePosition(x, y - 1) })
+        {
+            if (!m_bot.Map().isTerrainWalkable(n)) { continue; }
+
+            int neighbor = n.y * m_width + n.x;
+            if (m_distance[neighbor] == -1 || entry.first + 1 < m_distance[neighbor])
+            {
+                m_distance[neighbor] = entry.first + 1;
+                m_source[neighbor] = m_source[index];
+                queue.push(std::make_pair(entry.first + 1, neighbor));
+            }
+        }
+    }
+}
+
+int TerritoryMap::getTileIndex(const CCPosition & pos) const
+{
+    CCTilePosition tile = Util::GetTilePosition(pos);
+    if (tile.x < 0 || tile.y < 0 || tile.x >= m_width || tile.y >= m_height)
+    {
+        return -1;
+    }
+
+    return tile.y * m_width + tile.x;
+}
+
+int TerritoryMap::getDistance(const CCPosition & pos) const
+{
+    int index = getTileIndex(pos);
+    return index == -1 ? -1 : m_distance[index];
+}
+
+const BaseLocation * TerritoryMap::getClosestBase(const CCPosition & pos) const
+{
+    int index = getTileIndex(pos);
+    if (index == -1 || m_source[index] == -1)
+    {
+        return nullptr;
+    }
+
+    return m_sources[m_source[index]].base;
+}
+
+int TerritoryMap::getOwner(const CCPosition & pos) const
+{
+    int index = getTileIndex(pos);
+    if (index == -1 || m_source[index] == -1)
+    {
+        return Players::None;
+    }
+
+    return m_sources[m_source[index]].player;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+    class CCBot;
+    class BaseLocation;
+
+    // For every tile, the closest occupied base of either player by ground distance, how far away it is
+    // and who owns it. The field is flooded outward from every occupied base at once, and when a base is
+    // gained or lost only the tiles whose closest base changes are touched.
+    class TerritoryMap
+    {
+        struct Source
+        {
+            const BaseLocation *    base;
+            int                     player;
+            bool                    active;
+        };
+
+        CCBot &             m_bot;
+        int                 m_width;
+        int                 m_height;
+        std::vector<Source> m_sources;
+        std::vector<int>    m_distance;     // ground distance to the closest occupied base or -1 if none reaches it, row-major
+        std::vector<int>    m_source;       // index of the closest source or -1, row-major
+
+        void addSource(const BaseLocation * base, int player);
+        void removeSource(int sourceIndex);
+        void flood(const std::vector<std::pair<int, int>> & open);
+        int  getTileIndex(const CCPosition & pos) const;
+
+    public:
+
+        TerritoryMap(CCBot & bot);
+
+        void onStart();
+        void update(const std::set<const BaseLocation *> & selfBases, const std::set<const BaseLocation *> & enemyBases);
+
+        // ground distance to the closest occupied base, or -1 if no occupied base can walk there
+        int  getDistance(const CCPosition & pos) const;
+
+        const BaseLocation * getClosestBase(const CCPosition & pos) const;
+
+        // the player owning the closest occupied base, or Players::None
+        int  getOwner(const CCPosition & pos) const;
+    };
+}
@@ -0,0 +1,243 @@
+#include "ThreatMap.h"
+#include "CCBot.h"
+#include "Util.h"
+
+#include <cmath>
+#include <sstream>
+
+using namespace CC;
+
+// dps is stored as fixed point so stamping and unstamping a unit cancel out exactly
+const int DPSScale = 16;
+
+// tiles added to every weapon range, covering unit radii and the distance a unit closes before it fires
+const float ThreatMargin = 3.0f;
+
+ThreatMap::ThreatMap(CCBot & bot)
+    : m_bot(bot)
+    , m_width(0)
+    , m_height(0)
+    , m_frame(0)
+{
+
+}
+
+void ThreatMap::onStart()
+{
+    m_width  = m_bot.Map().width();
+    m_height = m_bot.Map().height();
+    m_groundThreat.reset(m_width, m_height, 0);
+    m_airThreat.reset(m_width, m_height, 0);
+    m_stamps.clear();
+}
+
+void ThreatMap::onFrame()
+{
+    m_frame++;
+
+    for (auto & kv : m_bot.UnitInfo().getUnitInfoMap(Players::Enemy))
+    {
+        const UnitInfo & info = kv.second;
+
+        Stamp stamp;
+        bool threatens = computeStamp(info.type, info.lastPosition, stamp) && info.progress >= 1.0f;
+
+        auto it = m_stamps.find(info.id);
+        if (it != m_stamps.end())
+        {
+            // the unit hasn't moved to another tile or changed type, its stamp is still correct
+            if (threatens && it->second.type == info.type && it->second.tile == stamp.tile)
+            {
+                it->second.frame = m_frame;
+                continue;
+            }
+
+            applyStamp(it->second, -1);
+            m_stamps.erase(it);
+        }
+
+        if (threatens)
+        {
+            stamp.frame = m_frame;
+            applyStamp(stamp, 1);
+            m_stamps[info.id] = stamp;
+        }
+    }
+
+    // units that died or were forgotten by the unit info take their threat with them
+    for (auto it = m_stamps.begin(); it != m_stamps.end();)
+    {
+        if (it->second.frame != m_frame)
+        {
+            applyStamp(it->second, -1);
+            it = m_stamps.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // only the coarse cells above tiles whose threat changed are reduced again
+    m_groundThreat.update();
+    m_airThreat.update();
+}
+
+const std::vector<CCTilePosition> & ThreatMap::getKernel(int radius)
+{
+    auto it = m_kernels.find(radius);
+    if (it != m_kernels.end())
+    {
+        return it->second;
+    }
+
+    std::vector<CCTilePosition> & kernel = m_kernels[radius];
+    for (int dx(-radius); dx <= radius; ++dx)
+    {
+        for (int dy(-radius); dy <= radius; ++dy)
+        {
+            if (dx * dx + dy * dy <= radius * radius)
+            {
+                kernel.push_back(CCTilePosition(dx, dy));
+            }
+        }
+    }
+
+    return kernel;
+}
+
+// workers, and units without a weapon, don't count as a threat
+bool ThreatMap::computeStamp(const UnitType & type, const CCPosition & pos, Stamp & stamp) const
+{
+    if (type.isWorker()) { return false; }
+
+    float groundDPS = 0;
+    float airDPS = 0;
+    float range = 0;
+
+#ifdef SC2API
+    for (auto & weapon : m_bot.Observation()->GetUnitTypeData()[type.getAPIUnitType()].weapons)
+    {
+        if (weapon.speed <= 0) { continue; }
+
+        float dps = weapon.damage_ * weapon.attacks / weapon.speed;
+        if (weapon.type != sc2::Weapon::TargetType::Air)    { groundDPS += dps; }
+        if (weapon.type != sc2::Weapon::TargetType::Ground) { airDPS += dps; }
+        range = std::max(range, weapon.range);
+    }
+#else
+    BWAPI::UnitType t = type.getAPIUnitType();
+    BWAPI::WeaponType ground = t.groundWeapon();
+    BWAPI::WeaponType air = t.airWeapon();
+
+    if (ground != BWAPI::WeaponTypes::None && ground.damageCooldown() > 0)
+    {
+        groundDPS = 24.0f * ground.damageAmount() * ground.damageFactor() * t.maxGroundHits() / ground.damageCooldown();
+        range = std::max(range, ground.maxRange() / 32.0f);
+    }
+
+    if (air != BWAPI::WeaponTypes::None && air.damageCooldown() > 0)
+    {
+        airDPS = 24.0f * air.damageAmount() * air.damageFactor() * t.maxAirHits() / air.damageCooldown();
+        range = std::max(range, air.maxRange() / 32.0f);
+    }
+#endif
+
+    if (groundDPS <= 0 && airDPS <= 0) { return false; }
+
+    stamp.tile      = Util::GetTilePosition(pos);
+    stamp.type      = type;
+    stamp.radius    = (int)std::ceil(range + ThreatMargin);
+    stamp.groundDPS = (int)std::round(groundDPS * DPSScale);
+    stamp.airDPS    = (int)std::round(airDPS * DPSScale);
+    stamp.frame     = 0;
+    return true;
+}
+
+void ThreatMap::applyStamp(const Stamp & stamp, int sign)
+{
+    const int groundDPS = sign * stamp.groundDPS;
+    const int airDPS = sign * stamp.airDPS;
+
+    for (auto & offset : getKernel(stamp.radius))
+    {
+        int x = stamp.tile.x + offset.x;
+        int y = stamp.tile.y + offset.y;
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height) { continue; }
+
+        m_groundThreat.add(x, y, groundDPS);
+        m_airThreat.add(x, y, airDPS);
+    }
+}
+
+int ThreatMap::getThreat(const GridPyramid & grid, const CCPosition & pos) const
+{
+    CCTilePosition tile = Util::GetTilePosition(pos);
+    if (tile.x < 0 || tile.y < 0 || tile.x >= m_width || tile.y >= m_height)
+    {
+        return 0;
+    }
+
+    return grid.get(tile.x, tile.y);
+}
+
+float ThreatMap::getGroundThreat(const CCPosition & pos) const
+{
+    return (float)getThreat(m_groundThreat, pos) / DPSScale;
+}
+
+float ThreatMap::getAirThreat(const CCPosition & pos) const
+{
+    return (float)getThreat(m_airThreat, pos) / DPSScale;
+}
+
+float ThreatMap::getThreat(const CCPosition & pos, bool flying) const
+{
+    return flying ? getAirThreat(pos) : getGroundThreat(pos);
+}
+
+float ThreatMap::getThreatNear(const CCPosition & pos, float radius, bool flying) const
+{
+    return (float)std::max(0, getThreatPyramid(flying).getMaxNear(pos, radius)) / DPSScale;
+}
+
+void ThreatMap::getMostThreatenedTiles(const CCPosition & pos, float radius, size_t k, bool flying, std::vector<CCTilePosition> & tiles) const
+{
+    getThreatPyramid(flying).getBestTiles(pos, radius, k, true, 0, tiles);
+}
+
+const GridPyramid & ThreatMap::getThreatPyramid(bool flying) const
+{
+    return flying ? m_airThreat : m_groundThreat;
+}
+
+void ThreatMap::draw() const
+{
+#ifdef SC2API
+    CCPosition camera = m_bot.Observation()->GetCameraPos();
+    int sx = (int)(camera.x - 12.0f);
+    int sy = (int)(camera.y - 8);
+    int ex = sx + 24;
+    int ey = sy + 20;
+#else
+    BWAPI::TilePosition screen(BWAPI::Broodwar->getScreenPosition());
+    int sx = screen.x;
+    int sy = screen.y;
+    int ex = sx + 20;
+    int ey = sy + 15;
+#endif
+
+    for (int x = std::max(sx, 0); x < std::min(ex, m_width); ++x)
+    {
+        for (int y = std::max(sy, 0); y < std::min(ey, m_height); ++y)
+        {
+            int ground = m_groundThreat.get(x, y) / DPSScale;
+            int air = m_airThreat.get(x, y) / DPSScale;
+            if (ground == 0 && air == 0) { continue; }
+
+            std::stringstream ss;
+            ss << ground << "/" << air;
+            m_bot.Map().drawText(CCPosition(Util::TileToPosition(x + 0.1f), Util::TileToPosition(y + 0.5f)), ss.str(), CCColor(255, 128, 0));
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.h"
+#include "UnitType.h"
+#include "MapPyramid.h"
+
+namespace CC
+{
+    class CCBot;
+
+    // Damage per second enemy units can deal to ground and air units standing on each tile.
+    // Every known enemy stamps a disc covering its weapon range onto the grids, and the stamp is only
+    // undone and redone when the unit changes tile or type, so keeping the grids current costs nothing
+    // for units that stand still and a threat lookup is a single read.
+    class ThreatMap
+    {
+        struct Stamp
+        {
+            CCTilePosition  tile;
+            UnitType        type;
+            int             radius;
+            int             groundDPS;      // fixed point, see DPSScale in ThreatMap.cpp
+            int             airDPS;
+            int             frame;          // last update the unit was still known
+        };
+
+        CCBot &                                     m_bot;
+        int                                         m_width;
+        int                                         m_height;
+        int                                         m_frame;
+        GridPyramid                                 m_groundThreat;     // with 2x, 4x and 8x coarse levels for area queries
+        GridPyramid                                 m_airThreat;
+        std::map<CCUnitID, Stamp>                   m_stamps;
+        std::map<int, std::vector<CCTilePosition>>  m_kernels;          // disc offsets by radius in tiles
+
+        const std::vector<CCTilePosition> & getKernel(int radius);
+        bool computeStamp(const UnitType & type, const CCPosition & pos, Stamp & stamp) const;
+        void applyStamp(const Stamp & stamp, int sign);
+        int  getThreat(const GridPyramid & grid, const CCPosition & pos) const;
+
+    public:
+
+        ThreatMap(CCBot & bot);
+
+        void    onStart();
+        void    onFrame();
+
+        float   getGroundThreat(const CCPosition & pos) const;
+        float   getAirThreat(const CCPosition & pos) const;
+        float   getThreat(const CCPosition & pos, bool flying) const;
+
+        // the largest threat on any tile within roughly radius of pos, read from a few coarse cells
+        float   getThreatNear(const CCPosition & pos, float radius, bool flying) const;
+
+        // the k tiles within radius of pos under the most threat, most dangerous first
+        void    getMostThreatenedTiles(const CCPosition & pos, float radius, size_t k, bool flying, std::vector<CCTilePosition> & tiles) const;
+        const   GridPyramid & getThreatPyramid(bool flying) const;
+
+        void    draw() const;
+    };
+}
@@ -0,0 +1,51 @@
+#include "TileSpiral.h"
+
+using namespace CC;
+
+TileSpiral::TileSpiral(const CCTilePosition & center, int maxRadius, int mapWidth, int mapHeight)
+    : m_center(center)
+    , m_width(mapWidth)
+    , m_height(mapHeight)
+    , m_maxRadius(maxRadius)
+    , m_radius(0)
+    , m_index(0)
+{
+
+}
+
+bool TileSpiral::next(CCTilePosition & tile)
+{
+    while (m_radius <= m_maxRadius)
+    {
+        // ring r has 8r tiles, four sides of 2r starting at each corner, and the center is a ring of one
+        const int side   = m_radius == 0 ? 0 : m_index / (2 * m_radius);
+        const int offset = m_radius == 0 ? 0 : m_index % (2 * m_radius);
+        const int ringSize = m_radius == 0 ? 1 : 8 * m_radius;
+
+        int dx = 0;
+        int dy = 0;
+        switch (side)
+        {
+            case 0: dx = -m_radius + offset; dy = -m_radius;          break;
+            case 1: dx = m_radius;           dy = -m_radius + offset; break;
+            case 2: dx = m_radius - offset;  dy = m_radius;           break;
+            case 3: dx = -m_radius;          dy = m_radius - offset;  break;
+        }
+
+        if (++m_index >= ringSize)
+        {
+            m_index = 0;
+            ++m_radius;
+        }
+
+        const int x = m_center.x + dx;
+        const int y = m_center.y + dy;
+        if (x >= 0 && y >= 0 && x < m_width && y < m_height)
+        {
+            tile = CCTilePosition(x, y);
+            return true;
+        }
+    }
+
+    return false;
+}
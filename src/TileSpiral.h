@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Common.h"
+
+namespace CC
+{
+    // Visits the tiles around a center ring by ring, the center first and then every tile at a chessboard distance
+    // of 1, 2, ... up to a maximum radius. Tiles off the map are skipped, nothing is allocated, and no tile beyond
+    // the ring being visited is ever looked at, so a search that stops early only pays for what it visited.
+    class TileSpiral
+    {
+        CCTilePosition  m_center;
+        int             m_width;
+        int             m_height;
+        int             m_maxRadius;
+        int             m_radius;       // the ring being visited
+        int             m_index;        // the next tile on the ring, counted clockwise from its top left corner
+
+    public:
+
+        TileSpiral(const CCTilePosition & center, int maxRadius, int mapWidth, int mapHeight);
+
+        // the next tile on the map, false once every ring up to the maximum radius has been visited
+        bool next(CCTilePosition & tile);
+    };
+}
@@ -10,7 +10,8 @@ UnitData::UnitData()
 
 }
 
-void UnitData::updateUnit(const Unit & unit)
+// returns whether the unit is new or its type, completion, orders or flying changed since the last update
+bool UnitData::updateUnit(const Unit & unit)
 {
     bool firstSeen = false;
 
@@ -26,6 +27,12 @@ void UnitData::updateUnit(const Unit & unit)
     }
 
     UnitInfo & ui   = m_unitMap[unit];
+    const bool changed = firstSeen
+                      || !(ui.type == unit.getType())
+                      || ui.completed != unit.isCompleted()
+                      || ui.training != unit.isTraining()
+                      || ui.flying != unit.isFlying();
+
     ui.unit         = unit;
     ui.player       = unit.getPlayer();
     ui.lastPosition = unit.getPosition();
@@ -34,6 +41,9 @@ void UnitData::updateUnit(const Unit & unit)
     ui.type         = unit.getType();
     ui.progress     = unit.getBuildPercentage();
     ui.id           = unit.getID();
+    ui.completed    = unit.isCompleted();
+    ui.training     = unit.isTraining();
+    ui.flying       = unit.isFlying();
 
     if (firstSeen)
     {
@@ -44,6 +54,8 @@ void UnitData::updateUnit(const Unit & unit)
 
         m_numUnits[ui.type]++;
     }
+
+    return changed;
 }
 
 void UnitData::killUnit(const Unit & unit)
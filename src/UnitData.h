@@ -20,6 +20,9 @@ namespace CC
         CCPosition      lastPosition;
         UnitType        type;
         float           progress;
+        bool            completed;
+        bool            training;
+        bool            flying;
 
         UnitInfo()
             : id(0)
@@ -27,6 +30,9 @@ namespace CC
             , player(-1)
             , lastPosition(0, 0)
             , progress(1.0)
+            , completed(false)
+            , training(false)
+            , flying(false)
         {
 
         }
@@ -63,7 +69,7 @@ namespace CC
 
         UnitData();
 
-        void	updateUnit(const Unit & unit);
+        bool	updateUnit(const Unit & unit);
         void	killUnit(const Unit & unit);
         void	removeBadUnits();
 
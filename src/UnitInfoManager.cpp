@@ -9,13 +9,15 @@ using namespace CC;
 
 UnitInfoManager::UnitInfoManager(CCBot & bot)
     : m_bot(bot)
+    , m_threatMap(bot)
 {
 
 }
 
 void UnitInfoManager::onStart()
 {
-
+    m_threatMap.onStart();
+    m_bot.OnStartupStage("threat map");
 }
 
 void UnitInfoManager::onFrame()
@@ -23,6 +25,11 @@ void UnitInfoManager::onFrame()
     updateUnitInfo();
     drawUnitInformation(100, 100);
     drawSelectedUnitDebugInfo();
+
+    if (m_bot.Draw().isEnabled(DebugCategory::EnemyUnitInfo))
+    {
+        m_threatMap.draw();
+    }
 }
 
 void UnitInfoManager::updateUnitInfo()
@@ -30,10 +37,16 @@ void UnitInfoManager::updateUnitInfo()
     m_units[Players::Self].clear();
     m_units[Players::Enemy].clear();
     m_units[Players::Neutral].clear();
+    m_unitsChangedLastFrame[Players::Self].clear();
+    m_unitsChangedLastFrame[Players::Enemy].clear();
+    m_unitsChangedLastFrame[Players::Neutral].clear();
 
     for (auto & unit : m_bot.GetUnits())
     {
-        updateUnit(unit);
+        if (updateUnit(unit))
+        {
+            m_unitsChangedLastFrame[unit.getPlayer()].push_back(unit);
+        }
         m_units[unit.getPlayer()].push_back(unit);     
     }
 
@@ -55,6 +68,8 @@ void UnitInfoManager::updateUnitInfo()
         }
         m_unitsDiedLastFrame[player] = deadUnits;
     }
+
+    m_threatMap.onFrame();
 }
 
 const std::map<Unit, UnitInfo> & UnitInfoManager::getUnitInfoMap(CCPlayer player) const
@@ -62,6 +77,11 @@ const std::map<Unit, UnitInfo> & UnitInfoManager::getUnitInfoMap(CCPlayer player
     return getUnitData(player).getUnitInfoMap();
 }
 
+const ThreatMap & UnitInfoManager::getThreatMap() const
+{
+    return m_threatMap;
+}
+
 const std::vector<Unit> & UnitInfoManager::getUnitsDied(CCPlayer player) const
 {
     BOT_ASSERT(m_units.find(player) != m_units.end(), "Couldn't find player units died: %d", player);
@@ -69,6 +89,14 @@ const std::vector<Unit> & UnitInfoManager::getUnitsDied(CCPlayer player) const
     return m_unitsDiedLastFrame.at(player);
 }
 
+// units seen for the first time or whose type, completion, orders or flying changed last frame
+const std::vector<Unit> & UnitInfoManager::getUnitsChanged(CCPlayer player) const
+{
+    BOT_ASSERT(m_units.find(player) != m_units.end(), "Couldn't find player units changed: %d", player);
+
+    return m_unitsChangedLastFrame.at(player);
+}
+
 const std::vector<Unit> & UnitInfoManager::getUnits(CCPlayer player) const
 {
     BOT_ASSERT(m_units.find(player) != m_units.end(), "Couldn't find player units: %d", player);
@@ -219,13 +247,13 @@ size_t UnitInfoManager::getUnitTypeCount(CCPlayer player, UnitType type, bool co
 
 void UnitInfoManager::drawUnitInformation(float x,float y) const
 {
-    if (!m_bot.Config().DrawEnemyUnitInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::EnemyUnitInfo))
     {
         return;
     }
 
     std::stringstream ss;
-    auto enemyUnits = m_unitData.at(Players::Enemy).getUnitInfoMap();
+    auto & enemyUnits = m_unitData.at(Players::Enemy).getUnitInfoMap();
     
     ss << "Enemy units: " << enemyUnits.size() << "\n\n";
     
@@ -262,9 +290,9 @@ void UnitInfoManager::drawUnitInformation(float x,float y) const
     
 }
 
-void UnitInfoManager::updateUnit(const Unit & unit)
+bool UnitInfoManager::updateUnit(const Unit & unit)
 {
-    m_unitData[unit.getPlayer()].updateUnit(unit);
+    return m_unitData[unit.getPlayer()].updateUnit(unit);
 }
 
 // is the unit valid?
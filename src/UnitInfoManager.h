@@ -4,6 +4,7 @@
 #include "UnitData.h"
 #include "BaseLocation.h"
 #include "Unit.h"
+#include "ThreatMap.h"
 
 namespace CC
 {
@@ -15,8 +16,10 @@ namespace CC
         std::map<CCPlayer, UnitData> m_unitData;
         std::map<CCPlayer, std::vector<Unit>> m_units;
         std::map<CCPlayer, std::vector<Unit>> m_unitsDiedLastFrame;
+        std::map<CCPlayer, std::vector<Unit>> m_unitsChangedLastFrame;
+        ThreatMap         m_threatMap;
 
-        void                    updateUnit(const Unit & unit);
+        bool                    updateUnit(const Unit & unit);
         void                    updateUnitInfo();
         bool                    isValidUnit(const Unit & unit);
 
@@ -33,12 +36,14 @@ namespace CC
 
         const std::vector<Unit> & getUnits(CCPlayer player) const;
         const std::vector<Unit> & getUnitsDied(CCPlayer player) const;
+        const std::vector<Unit> & getUnitsChanged(CCPlayer player) const;
 
         size_t                  getUnitTypeCount(CCPlayer player, UnitType type, bool completed = true) const;
 
         void                    getNearbyForce(std::vector<UnitInfo> & unitInfo, CCPosition p, int player, float radius) const;
 
         const std::map<Unit, UnitInfo> & getUnitInfoMap(CCPlayer player) const;
+        const ThreatMap &       getThreatMap() const;
 
         //bool                  enemyHasCloakedUnits() const;
         void                    drawUnitInformation(float x, float y) const;
@@ -310,6 +310,7 @@ int UnitType::tileWidth() const
 #ifdef SC2API
     if (isMineral()) { return 2; }
     if (isGeyser()) { return 3; }
+    if (isResourceDepot()) { return 5; }
     if (isCombatUnit()) { return 2; }
     else { return (int)(2 * m_bot->Observation()->GetAbilityData()[m_bot->Data(*this).buildAbility].footprint_radius); }
 #else
@@ -322,6 +323,7 @@ int UnitType::tileHeight() const
 #ifdef SC2API
     if (isMineral()) { return 1; }
     if (isGeyser()) { return 3; }
+    if (isResourceDepot()) { return 5; }
     if (isCombatUnit()) { return 2; }
     else { return (int)(2 * m_bot->Observation()->GetAbilityData()[m_bot->Data(*this).buildAbility].footprint_radius); }
 #else
@@ -347,6 +349,17 @@ bool UnitType::isBuilding() const
 #endif
 }
 
+// rocks and debris that block ground paths until they are destroyed, the unbuildable variants don't block walking
+bool UnitType::isDestructibleObstacle() const
+{
+#ifdef SC2API
+    const std::string name = getName();
+    return name.find("Destructible") != std::string::npos && name.find("Unbuildable") == std::string::npos;
+#else
+    return false;
+#endif
+}
+
 int UnitType::supplyProvided() const
 {
 #ifdef SC2API
@@ -445,6 +458,15 @@ bool UnitType::isTank() const
 #endif
 }
 
+bool UnitType::isBunker() const
+{
+#ifdef SC2API
+    return m_type == sc2::UNIT_TYPEID::TERRAN_BUNKER;
+#else
+    return m_type == BWAPI::UnitTypes::Terran_Bunker;
+#endif
+}
+
 bool UnitType::isMorphedBuilding() const
 {
 #ifdef SC2API
@@ -47,6 +47,7 @@ namespace CC
         bool isDetector() const;
         bool isGeyser() const;
         bool isMineral() const;
+        bool isDestructibleObstacle() const;
         bool isWorker() const;
         bool isMorphedBuilding() const;
         bool canAttack() const;
@@ -70,5 +71,6 @@ namespace CC
         bool isEgg() const;
         bool isQueen() const;
         bool isTank() const;
+        bool isBunker() const;
     };
 }
@@ -0,0 +1,161 @@
+#include "WarpInPlacer.h"
+#include "CCBot.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace CC;
+
+const float PylonPowerRadius        = 6.5f;
+const float WarpPrismPowerRadius    = 3.75f;
+const size_t ConfirmedCells         = 16;       // the best cells of a round the game is asked to confirm
+const float WarpInSpacing           = 1.5f;     // tiles kept between two warp-ins of the same round, more than a diagonal neighbour
+
+WarpInPlacer::WarpInPlacer(CCBot & bot)
+    : m_bot(bot)
+    , m_enemyTile(-1, -1)
+    , m_roundFrame(-1)
+{
+
+}
+
+CCPosition WarpInPlacer::getWarpPosition(const UnitType & type)
+{
+    if (m_roundFrame != m_bot.GetCurrentFrame())
+    {
+        rankCells(type);
+    }
+
+    while (!m_cells.empty())
+    {
+        const CCPosition cell = m_cells.back();
+        m_cells.pop_back();
+
+        bool clear = true;
+        for (auto & used : m_used)
+        {
+            if (Util::Dist(cell, used) < Util::TileToPosition(WarpInSpacing))
+            {
+                clear = false;
+                break;
+            }
+        }
+
+        if (clear)
+        {
+            m_used.push_back(cell);
+            return cell;
+        }
+    }
+
+    return CCPosition(-1, -1);
+}
+
+void WarpInPlacer::rankCells(const UnitType & type)
+{
+    m_roundFrame = m_bot.GetCurrentFrame();
+    m_cells.clear();
+    m_used.clear();
+
+    // the distance map is shared with the map tools, which keep it repaired as structures come and go
+    const BaseLocation * enemyBase = m_bot.Bases().getPlayerStartingBaseLocation(Players::Enemy);
+    const CCTilePosition enemyTile = enemyBase ? Util::GetTilePosition(enemyBase->getPosition()) : CCTilePosition(-1, -1);
+    if (enemyBase && (!m_enemyDistances || enemyTile.x != m_enemyTile.x || enemyTile.y != m_enemyTile.y))
+    {
+        m_enemyDistances = m_bot.Map().getSharedDistanceMap(enemyTile);
+        m_enemyTile = enemyTile;
+    }
+
+    // tiles covered by ground units can't take a warp-in
+    std::set<int> occupied;
+    for (auto & unit : m_bot.GetUnits())
+    {
+        if (unit.isFlying())
+        {
+            continue;
+        }
+
+        const CCTilePosition tile = Util::GetTilePosition(unit.getPosition());
+        const int reach = (int)std::ceil(unit.getUnitPtr()->radius) - 1;
+        for (int x = tile.x - reach; x <= tile.x + reach; ++x)
+        {
+            for (int y = tile.y - reach; y <= tile.y + reach; ++y)
+            {
+                occupied.insert(y * m_bot.Map().width() + x);
+            }
+        }
+    }
+
+    std::set<int> seen;
+    std::vector<std::pair<int, CCPosition>> ranked;
+    for (auto & unit : m_bot.UnitInfo().getUnits(Players::Self))
+    {
+        float radius = 0;
+        if (unit.getType().getAPIUnitType() == sc2::UNIT_TYPEID::PROTOSS_PYLON && unit.isCompleted())
+        {
+            radius = PylonPowerRadius;
+        }
+        else if (unit.getType().getAPIUnitType() == sc2::UNIT_TYPEID::PROTOSS_WARPPRISMPHASING)
+        {
+            radius = WarpPrismPowerRadius;
+        }
+        else
+        {
+            continue;
+        }
+
+        const CCPosition source = unit.getPosition();
+        for (int x = (int)(source.x - radius); x <= (int)(source.x + radius); ++x)
+        {
+            for (int y = (int)(source.y - radius); y <= (int)(source.y + radius); ++y)
+            {
+                const CCPosition cell(x + 0.5f, y + 0.5f);
+                const int key = y * m_bot.Map().width() + x;
+
+                if (!m_bot.Map().isValidTile(x, y) || Util::Dist(cell, source) > radius || seen.count(key) > 0)
+                {
+                    continue;
+                }
+
+                seen.insert(key);
+                if (!m_bot.Map().isWalkable(x, y) || !m_bot.Map().isVisible(x, y) || occupied.count(key) > 0)
+                {
+                    continue;
+                }
+
+                // cells without a ground path to the enemy, like on an island, come last
+                int distance = m_enemyDistances ? m_enemyDistances->getDistance(x, y) : -1;
+                ranked.push_back(std::make_pair(distance < 0 ? INT_MAX : distance, cell));
+            }
+        }
+    }
+
+    // best last, so cells are popped off the back
+    std::sort(ranked.begin(), ranked.end(), [](const std::pair<int, CCPosition> & a, const std::pair<int, CCPosition> & b)
+    {
+        return a.first > b.first;
+    });
+
+    // the game only confirms the best cells, in a single query, the ones it rejects are dropped
+    const size_t firstConfirmed = ranked.size() - std::min(ConfirmedCells, ranked.size());
+    std::vector<sc2::QueryInterface::PlacementQuery> queries;
+    for (size_t i = firstConfirmed; i < ranked.size(); ++i)
+    {
+        queries.push_back(sc2::QueryInterface::PlacementQuery(m_bot.Data(type).warpAbility, ranked[i].second));
+    }
+
+    std::vector<bool> results = queries.empty() ? std::vector<bool>() : m_bot.Query()->Placement(queries);
+    results.resize(queries.size(), false);
+
+    m_cells.reserve(ranked.size());
+    for (size_t i = 0; i < ranked.size(); ++i)
+    {
+        if (i >= firstConfirmed && !results[i - firstConfirmed])
+        {
+            continue;
+        }
+
+        m_cells.push_back(ranked[i].second);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Common.h"
+#include "DistanceMap.h"
+#include <memory>
+
+namespace CC
+{
+    class CCBot;
+    class UnitType;
+
+    // Picks warp-in positions from our own grids instead of asking the game about every position. Once a frame the
+    // cells in the power fields of our pylons and phasing warp prisms that are walkable, visible and not covered by
+    // a ground unit are ranked by walking distance to the enemy base, read from a distance map that is kept across
+    // frames. The game confirms the best cells of the round in one batched query, and every warp-in of the round
+    // takes the best cell left that isn't next to a cell already given out.
+    class WarpInPlacer
+    {
+        CCBot &                             m_bot;
+        std::shared_ptr<const DistanceMap>  m_enemyDistances;   // walking distances to the enemy start location
+        CCTilePosition                      m_enemyTile;
+        int                                 m_roundFrame;       // the frame the cells were ranked in
+        std::vector<CCPosition>             m_cells;            // the ranked cells not given out yet, best last
+        std::vector<CCPosition>             m_used;             // cells given out this round
+
+        void    rankCells(const UnitType & type);
+
+    public:
+
+        WarpInPlacer(CCBot & bot);
+
+        // the best free cell to warp the type in this frame, (-1, -1) if every power field is full
+        CCPosition getWarpPosition(const UnitType & type);
+    };
+}
@@ -262,6 +262,11 @@ const char * WorkerData::getJobCode(const Unit & unit)
 
 void WorkerData::drawDepotDebugInfo()
 {
+    if (!m_bot.Draw().isEnabled(DebugCategory::WorkerInfo))
+    {
+        return;
+    }
+
     for (auto depot: m_depots)
     {
         std::stringstream ss;
@@ -223,7 +223,7 @@ void WorkerManager::setCombatWorker(Unit workerTag)
 
 void WorkerManager::drawResourceDebugInfo()
 {
-    if (!m_bot.Config().DrawResourceInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::ResourceInfo))
     {
         return;
     }
@@ -247,7 +247,7 @@ void WorkerManager::drawResourceDebugInfo()
 
 void WorkerManager::drawWorkerInformation()
 {
-    if (!m_bot.Config().DrawWorkerInfo)
+    if (!m_bot.Draw().isEnabled(DebugCategory::WorkerInfo))
     {
         return;
     }